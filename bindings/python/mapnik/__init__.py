@@ -274,6 +274,11 @@ class _Datasource(Datasource,_injector):
             query.add_property_name(fld)
         return self.features(query)
 
+    def columns(self,fields=None):
+        """All features as flat arrays, see Featureset.columns."""
+        attributes = fields or self.fields()
+        return self.featureset(attributes).columns(attributes)
+
 class _DeprecatedFeatureProperties(object):
 
     def __init__(self, feature):
@@ -398,6 +403,8 @@ def PostGIS(**keywords):
       port -- postgres port (default: see postgres docs)
       initial_size -- integer size of connection pool (default: 1)
       max_size -- integer max of connection pool (default: 10)
+      borrow_timeout -- seconds to wait for a connection when max_size are in use (default: 2)
+      ping_interval -- seconds a connection may be idle before it is checked on use (default: 30)
       persist_connection -- keep connection open (default: True)
 
     Optional table-level keyword arguments:
@@ -408,7 +415,7 @@ def PostGIS(**keywords):
       geometry_field -- specify geometry field to use (default: first entry in geometry_columns)
       srid -- specify srid to use (default: auto-detected from geometry_field)
       row_limit -- integer limit of rows to return (default: 0)
-      cursor_size -- integer size of binary cursor to use (default: 0, no binary cursor is used)
+      cursor_size -- integer rows of the first binary cursor fetch, later fetches adapt to row width and latency (default: 0, no binary cursor is used)
       multiple_geometries -- boolean, direct the Mapnik wkb reader to interpret as multigeometries (default False)
 
     >>> from mapnik import PostGIS, Layer
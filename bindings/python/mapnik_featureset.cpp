@@ -23,9 +23,14 @@
 
 // boost
 #include <boost/python.hpp>
+#include <boost/cstdint.hpp>
 // mapnik
 #include <mapnik/feature.hpp>
 #include <mapnik/datasource.hpp>
+#include <mapnik/unicode.hpp>
+// stl
+#include <vector>
+#include <string>
 
 namespace {
 using namespace boost::python;
@@ -47,6 +52,183 @@ inline list features(mapnik::featureset_ptr const& itr)
 
 inline object pass_through(object const& o) { return o; }
 
+// a featureset drained into flat arrays, filled without the GIL
+struct feature_columns
+{
+    std::vector<int> ids;
+    // x,y pairs of every vertex
+    std::vector<double> coords;
+    // first vertex of every ring (a ring starts at each move_to)
+    std::vector<unsigned> ring_offsets;
+    // first ring of every geometry, and its type
+    std::vector<unsigned> part_offsets;
+    std::vector<unsigned char> geometry_types;
+    // first geometry of every feature
+    std::vector<unsigned> feature_offsets;
+    // one column per requested name, in order
+    std::vector<std::vector<mapnik::value> > attributes;
+};
+
+void drain(mapnik::featureset_ptr const& fs, std::vector<std::string> const& names, feature_columns & cols)
+{
+    cols.attributes.resize(names.size());
+    mapnik::feature_ptr feature;
+    while ((feature = fs->next()))
+    {
+        cols.ids.push_back(feature->id());
+        cols.feature_offsets.push_back(cols.part_offsets.size());
+        for (unsigned i = 0; i < feature->num_geometries(); ++i)
+        {
+            mapnik::geometry_type const& geom = feature->get_geometry(i);
+            cols.part_offsets.push_back(cols.ring_offsets.size());
+            cols.geometry_types.push_back(geom.type());
+            unsigned num_points = geom.num_points();
+            for (unsigned pos = 0; pos < num_points; ++pos)
+            {
+                double x, y;
+                unsigned cmd = geom.get_vertex(pos, &x, &y);
+                if (cmd == mapnik::SEG_CLOSE) continue;
+                if (cmd == mapnik::SEG_MOVETO || pos == 0)
+                {
+                    cols.ring_offsets.push_back(cols.coords.size() / 2);
+                }
+                cols.coords.push_back(x);
+                cols.coords.push_back(y);
+            }
+        }
+        std::map<std::string,mapnik::value> const& props = feature->props();
+        for (unsigned i = 0; i < names.size(); ++i)
+        {
+            std::map<std::string,mapnik::value>::const_iterator itr = props.find(names[i]);
+            cols.attributes[i].push_back(itr != props.end() ? itr->second : mapnik::value());
+        }
+    }
+    // closing offsets, so item i spans [offsets[i], offsets[i+1])
+    cols.ring_offsets.push_back(cols.coords.size() / 2);
+    cols.part_offsets.push_back(cols.ring_offsets.size() - 1);
+    cols.feature_offsets.push_back(cols.part_offsets.size() - 1);
+}
+
+// array.array of the given type code holding a copy of values
+template <typename T>
+object to_array(char const* typecode, std::vector<T> const& values)
+{
+    object result = import("array").attr("array")(typecode);
+    handle<> data(
+#if PY_VERSION_HEX >= 0x03000000
+        ::PyBytes_FromStringAndSize
+#else
+        ::PyString_FromStringAndSize
+#endif
+        (values.empty() ? "" : reinterpret_cast<char const*>(&values[0]), values.size() * sizeof(T)));
+#if PY_VERSION_HEX >= 0x03000000
+    result.attr("frombytes")(object(data));
+#else
+    result.attr("fromstring")(object(data));
+#endif
+    return result;
+}
+
+object value_object(mapnik::value const& val)
+{
+    mapnik::value_base const& base = val.base();
+    switch (base.which())
+    {
+    case 1:
+        return object(boost::get<bool>(base));
+    case 2:
+        return object(boost::get<int>(base));
+    case 3:
+        return object(boost::get<double>(base));
+    case 4:
+    {
+        std::string buffer;
+        mapnik::to_utf8(boost::get<UnicodeString>(base), buffer);
+        return object(handle<>(::PyUnicode_DecodeUTF8(buffer.data(), buffer.size(), 0)));
+    }
+    default:
+        return object();
+    }
+}
+
+// ints give an 'i' array, numbers a 'd' array, anything else
+// (strings, booleans, nulls) a list
+object to_column(std::vector<mapnik::value> const& values)
+{
+    bool all_ints = true;
+    bool all_numbers = true;
+    for (unsigned i = 0; i < values.size() && all_numbers; ++i)
+    {
+        int type = values[i].base().which();
+        if (type != 2) all_ints = false;
+        if (type != 2 && type != 3) all_numbers = false;
+    }
+    if (all_ints)
+    {
+        std::vector<int> ints;
+        ints.reserve(values.size());
+        for (unsigned i = 0; i < values.size(); ++i) ints.push_back(boost::get<int>(values[i].base()));
+        return to_array("i", ints);
+    }
+    if (all_numbers)
+    {
+        std::vector<double> numbers;
+        numbers.reserve(values.size());
+        for (unsigned i = 0; i < values.size(); ++i) numbers.push_back(values[i].to_double());
+        return to_array("d", numbers);
+    }
+    list result;
+    for (unsigned i = 0; i < values.size(); ++i) result.append(value_object(values[i]));
+    return result;
+}
+
+dict columns(mapnik::featureset_ptr const& fs, list const& fields)
+{
+    std::vector<std::string> names;
+    for (boost::python::ssize_t i = 0; i < len(fields); ++i)
+    {
+        names.push_back(extract<std::string>(fields[i]));
+    }
+
+    feature_columns cols;
+    if (fs)
+    {
+        Py_BEGIN_ALLOW_THREADS
+        try
+        {
+            drain(fs, names, cols);
+        }
+        catch (...)
+        {
+            Py_BLOCK_THREADS
+            throw;
+        }
+        Py_END_ALLOW_THREADS
+    }
+    else
+    {
+        cols.attributes.resize(names.size());
+        cols.ring_offsets.push_back(0);
+        cols.part_offsets.push_back(0);
+        cols.feature_offsets.push_back(0);
+    }
+
+    dict result;
+    result["ids"] = to_array("i", cols.ids);
+    result["coords"] = to_array("d", cols.coords);
+    result["ring_offsets"] = to_array("I", cols.ring_offsets);
+    result["part_offsets"] = to_array("I", cols.part_offsets);
+    result["geometry_types"] = to_array("B", cols.geometry_types);
+    result["feature_offsets"] = to_array("I", cols.feature_offsets);
+    dict attributes;
+    for (unsigned i = 0; i < names.size(); ++i)
+    {
+        attributes[names[i]] = to_column(cols.attributes[i]);
+    }
+    result["attributes"] = attributes;
+    return result;
+}
+
 inline mapnik::feature_ptr next(mapnik::featureset_ptr const& itr)
 {
     if (!itr)
@@ -81,5 +263,25 @@ void export_featureset()
             ">>>     print f\n"
             "<mapnik2.Feature object at 0x105e64140>\n"
             )
+        .def("columns",columns,
+            (arg("fields")=list()),
+            "Drain the remaining features into flat arrays, without\n"
+            "creating a Feature object per feature. Returns a dict of\n"
+            "array.array (usable with numpy.frombuffer) with:\n"
+            "  'ids': feature ids ('i')\n"
+            "  'coords': x,y of every vertex ('d')\n"
+            "  'ring_offsets': first vertex of every ring ('I')\n"
+            "  'part_offsets': first ring of every geometry ('I')\n"
+            "  'geometry_types': type of every geometry, 1 point, 2 line, 3 polygon ('B')\n"
+            "  'feature_offsets': first geometry of every feature ('I')\n"
+            "  'attributes': a column per name in fields, an 'i' or 'd'\n"
+            "  array for numeric fields and a list otherwise\n"
+            "Offset arrays have a closing entry, item i spans\n"
+            "offsets[i] to offsets[i+1].\n"
+            "\n"
+            "Usage:\n"
+            ">>> cols = ds.featureset(['NAME']).columns(['NAME'])\n"
+            ">>> len(cols['ids'])\n"
+            )
         ;
 }
@@ -29,28 +29,37 @@
 // mapnik
 #include <mapnik/grid/grid.hpp>
 #include "python_grid_utils.hpp"
+#include "python_buffer.hpp"
 
 using namespace boost::python;
 
 // help compiler see template definitions
 static dict (*encode)( mapnik::grid const&, std::string, bool, unsigned int) = mapnik::grid_encode;
+static PyObject* (*encode_json)( mapnik::grid const&, bool, unsigned int) = mapnik::grid_encode_json;
 
 void export_grid()
 {
-    class_<mapnik::grid,boost::shared_ptr<mapnik::grid> >(
+    object grid = class_<mapnik::grid,boost::shared_ptr<mapnik::grid> >(
             "Grid",
-            "This class represents a feature hitgrid.",
+            "This class represents a feature hitgrid.\n"
+            "Its height x width uint16 pixels are exported, read-only,\n"
+            "through the buffer protocol.\n",
             init<int,int,std::string,unsigned>(
               ( arg("width"),arg("height"),arg("key")="__id__",arg("resolution")=1 ),
             "Create a mapnik.Grid object\n"
             ))
         .def("width",&mapnik::grid::width)
         .def("height",&mapnik::grid::height)
-        .def("view",&mapnik::grid::get_view)
+        // the view refers to the grid pixels
+        .def("view",&mapnik::grid::get_view,with_custodian_and_ward_postcall<0,1>())
         .def("encode",encode,
             ( arg("encoding")="utf",arg("add_features")=true,arg("resolution")=4 ),
             "Encode the grid as as optimized json\n"
             )
+        .def("encode_json",encode_json,
+            ( arg("add_features")=true,arg("resolution")=4 ),
+            "Encode the grid directly to a UTFGrid json string\n"
+            )
         .add_property("key",
             make_function(&mapnik::grid::get_key,return_value_policy<copy_const_reference>()),
             &mapnik::grid::set_key,
@@ -58,6 +67,12 @@ void export_grid()
             "The value should either be __id__ to refer to the feature.id()\n"
             "or some globally unique integer or string attribute field\n"
          )
+        .add_property("compact",
+            &mapnik::grid::compact,
+            &mapnik::grid::set_compact,
+            "Get/Set compact mode where pixels hold dense ids allocated\n"
+            "per unique key rather than the raw feature.id()\n"
+         )
 /*
         // TODO - will require json generator
         .def("save", save_to_file1)
@@ -65,4 +80,6 @@ void export_grid()
 */
         ;
 
+    mapnik::python::export_buffer<mapnik::grid>(grid);
+
 }
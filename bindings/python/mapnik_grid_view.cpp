@@ -31,22 +31,32 @@
 #include <mapnik/grid/grid_view.hpp>
 #include <mapnik/grid/grid.hpp>
 #include "python_grid_utils.hpp"
+#include "python_buffer.hpp"
 
 using namespace boost::python;
 
 // help compiler see template definitions
 static dict (*encode)( mapnik::grid_view const&, std::string, bool, unsigned int) = mapnik::grid_encode;
+static PyObject* (*encode_json)( mapnik::grid_view const&, bool, unsigned int) = mapnik::grid_encode_json;
 
 void export_grid_view()
 {
-    class_<mapnik::grid_view,
+    object view = class_<mapnik::grid_view,
             boost::shared_ptr<mapnik::grid_view> >("GridView",
-            "This class represents a feature hitgrid subset.",no_init)
+            "This class represents a feature hitgrid subset.\n"
+            "Its pixels are exported, read-only and strided, through the buffer protocol.\n",
+            no_init)
         .def("width",&mapnik::grid_view::width)
         .def("height",&mapnik::grid_view::height)
         .def("encode",encode,
             ( arg("encoding")="utf",arg("add_features")=true,arg("resolution")=4 ),
             "Encode the grid as as optimized json\n"
             )
+        .def("encode_json",encode_json,
+            ( arg("add_features")=true,arg("resolution")=4 ),
+            "Encode the grid directly to a UTFGrid json string\n"
+            )
         ;
+
+    mapnik::python::export_buffer<mapnik::grid_view>(view);
 }
@@ -37,6 +37,7 @@ extern "C"
 #include <mapnik/png_io.hpp>
 #include <mapnik/image_reader.hpp>
 #include <sstream>
+#include "python_buffer.hpp"
 
 // agg
 #include "agg_rendering_buffer.h"
@@ -79,7 +80,18 @@ PyObject* tostring1( image_32 const& im)
 // encode (png,jpeg)
 PyObject* tostring2(image_32 const & im, std::string const& format)
 {
-    std::string s = save_to_string(im, format);
+    std::string s;
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        s = save_to_string(im, format);
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
     return
 #if PY_VERSION_HEX >= 0x03000000 
         ::PyBytes_FromStringAndSize
@@ -89,8 +101,35 @@ PyObject* tostring2(image_32 const & im, std::string const& format)
     (s.data(),s.size());
 }
 
-void (*save_to_file1)( mapnik::image_32 const&, std::string const&,std::string const&) = mapnik::save_to_file;
-void (*save_to_file2)( mapnik::image_32 const&, std::string const&) = mapnik::save_to_file;
+void save_to_file1(image_32 const& im, std::string const& filename, std::string const& type)
+{
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        save_to_file(im, filename, type);
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
+}
+
+void save_to_file2(image_32 const& im, std::string const& filename)
+{
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        save_to_file(im, filename);
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
+}
 
 boost::shared_ptr<image_32> open_from_file(std::string const& filename)
 {
@@ -190,10 +229,15 @@ void export_image()
         .value("multiply",multiply)
         ;
     
-    class_<image_32,boost::shared_ptr<image_32> >("Image","This class represents a 32 bit RGBA image.",init<int,int>())
+    object image = class_<image_32,boost::shared_ptr<image_32> >("Image",
+        "This class represents a 32 bit RGBA image.\n"
+        "It supports the buffer protocol: memoryview(im) or numpy.asarray(im)\n"
+        "give height x width x 4 (RGBA) bytes sharing the image pixels.\n",
+        init<int,int>())
         .def("width",&image_32::width)
         .def("height",&image_32::height)
-        .def("view",&image_32::get_view)
+        // the view refers to the image pixels
+        .def("view",&image_32::get_view,with_custodian_and_ward_postcall<0,1>())
         .add_property("background",make_function
                       (&image_32::get_background,return_value_policy<copy_const_reference>()),
                       &image_32::set_background, "The background color of the image.")
@@ -214,5 +258,7 @@ void export_image()
         .staticmethod("from_cairo")
 #endif
         ;    
+
+    mapnik::python::export_buffer<image_32>(image);
     
 }
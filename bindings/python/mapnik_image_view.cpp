@@ -31,6 +31,8 @@ extern "C"
 #include <mapnik/image_view.hpp>
 #include <mapnik/png_io.hpp>
 #include <sstream>
+#include <cstring>
+#include "python_buffer.hpp"
 
 // jpeg
 #if defined(HAVE_JPEG)
@@ -44,25 +46,43 @@ using mapnik::save_to_file;
 // output 'raw' pixels
 PyObject* view_tostring1(image_view<image_data_32> const& view)
 {
-    std::ostringstream ss(std::ios::out|std::ios::binary);
-    for (unsigned i=0;i<view.height();i++)
-    {
-        ss.write(reinterpret_cast<const char*>(view.getRow(i)), 
-                 view.width() * sizeof(image_view<image_data_32>::pixel_type));
-    }
-    return 
+    unsigned row_size = view.width() * sizeof(image_view<image_data_32>::pixel_type);
+    PyObject* result =
 #if PY_VERSION_HEX >= 0x03000000
         ::PyBytes_FromStringAndSize
 #else
         ::PyString_FromStringAndSize
 #endif
-        ((const char*)ss.str().c_str(),ss.str().size());
+        (0, row_size * view.height());
+    if (!result) boost::python::throw_error_already_set();
+    char* out =
+#if PY_VERSION_HEX >= 0x03000000
+        PyBytes_AS_STRING(result);
+#else
+        PyString_AS_STRING(result);
+#endif
+    for (unsigned i=0;i<view.height();i++)
+    {
+        std::memcpy(out + i * row_size, view.getRow(i), row_size);
+    }
+    return result;
 }
 
 // encode (png,jpeg)
 PyObject* view_tostring2(image_view<image_data_32> const & view, std::string const& format)
 {
-    std::string s = save_to_string(view, format);
+    std::string s;
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        s = save_to_string(view, format);
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
     return 
 #if PY_VERSION_HEX >= 0x03000000
         ::PyBytes_FromStringAndSize
@@ -72,13 +92,43 @@ PyObject* view_tostring2(image_view<image_data_32> const & view, std::string con
         (s.data(),s.size());
 }
 
-void (*save_view1)(image_view<image_data_32> const&, std::string const&,std::string const&) = mapnik::save_to_file;
-void (*save_view2)(image_view<image_data_32> const&, std::string const&) = mapnik::save_to_file;
+void save_view1(image_view<image_data_32> const& view, std::string const& filename, std::string const& type)
+{
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        save_to_file(view, filename, type);
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
+}
+
+void save_view2(image_view<image_data_32> const& view, std::string const& filename)
+{
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        save_to_file(view, filename);
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
+}
 
 void export_image_view()
 {
     using namespace boost::python;
-    class_<image_view<image_data_32> >("ImageView","A view into an image.",no_init)
+    object view = class_<image_view<image_data_32> >("ImageView",
+        "A view into an image.\n"
+        "Its pixels are exported, read-only and strided, through the buffer protocol.\n",
+        no_init)
         .def("width",&image_view<image_data_32>::width)
         .def("height",&image_view<image_data_32>::height)
         .def("tostring",&view_tostring1)
@@ -86,4 +136,6 @@ void export_image_view()
         .def("save",save_view1)
         .def("save",save_view2)
         ;
+
+    mapnik::python::export_buffer<image_view<image_data_32> >(view);
 }
@@ -151,6 +151,14 @@ void export_layer()
              ">>> lyr.visible(1.0/1000000)\n"
              "False\n"
             )
+
+        .def("reset_hit_index", &layer::reset_hit_index,
+             "Drop the index built by Map.query_points() and Map.query_map_points(),\n"
+             "so the next query reads the datasource again.\n"
+             "\n"
+             "Usage:\n"
+             ">>> lyr.reset_hit_index()\n"
+            )
                 
         .add_property("abstract", 
                       make_function(&layer::abstract,return_value_policy<copy_const_reference>()),
@@ -51,5 +51,13 @@ void export_line_symbolizer()
                       (&line_symbolizer::get_stroke,
                        return_value_policy<copy_const_reference>()),
                       &line_symbolizer::set_stroke)
+        .add_property("clip",
+                      &line_symbolizer::get_clip,
+                      &line_symbolizer::set_clip,
+                      "Clip lines to the canvas before stroking them")
+        .add_property("simplify_tolerance",
+                      &line_symbolizer::get_simplify_tolerance,
+                      &line_symbolizer::set_simplify_tolerance,
+                      "Drop vertices closer than this many pixels to the previous one")
         ;    
 }
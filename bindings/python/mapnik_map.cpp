@@ -173,6 +173,63 @@ mapnik::featureset_ptr query_map_point(mapnik::Map const& m, int index, double x
     return m.query_map_point(idx, x, y);
 }
 
+boost::python::list query_points_impl(mapnik::Map const& m, int index,
+                                      boost::python::object const& points,
+                                      bool pixel_coords)
+{
+    using namespace boost::python;
+    if (index < 0){
+        PyErr_SetString(PyExc_IndexError, "Please provide a layer index >= 0");
+        throw_error_already_set();
+    }
+    std::vector<mapnik::coord2d> pts;
+    boost::python::ssize_t num_points = len(points);
+    pts.reserve(num_points);
+    for (boost::python::ssize_t i = 0; i < num_points; ++i)
+    {
+        object pt = points[i];
+        pts.push_back(mapnik::coord2d(extract<double>(pt[0]),extract<double>(pt[1])));
+    }
+
+    std::vector<std::vector<mapnik::feature_ptr> > result;
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        if (pixel_coords)
+            m.query_map_points(index, pts, result);
+        else
+            m.query_points(index, pts, result);
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
+
+    list l;
+    for (std::size_t i = 0; i < result.size(); ++i)
+    {
+        list features;
+        for (std::size_t j = 0; j < result[i].size(); ++j)
+        {
+            features.append(result[i][j]);
+        }
+        l.append(features);
+    }
+    return l;
+}
+
+boost::python::list query_points(mapnik::Map const& m, int index, boost::python::object const& points)
+{
+    return query_points_impl(m, index, points, false);
+}
+
+boost::python::list query_map_points(mapnik::Map const& m, int index, boost::python::object const& points)
+{
+    return query_points_impl(m, index, points, true);
+}
+
 void export_map() 
 {
     using namespace boost::python;
@@ -326,6 +383,32 @@ void export_map()
              ">>> [<mapnik.Feature object at 0x3995630>]\n"
             )
         
+        .def("query_map_points",query_map_points,
+             (arg("layer_idx"),arg("points")),
+             "Query a Map Layer (by layer index) for features \n"
+             "at many x,y locations in the pixel coordinates\n"
+             "of the rendered map image at once.\n"
+             "The layer is indexed on first use and the index\n"
+             "is reused by later queries.\n"
+             "Returns one list of features per point.\n"
+             "\n"
+             "Usage:\n"
+             ">>> m.query_map_points(0,[(200,200),(10,10)])\n"
+             "[[<mapnik.Feature object at 0x3995630>], []]\n"
+            )
+        
+        .def("query_points",query_points,
+             (arg("layer_idx"),arg("points")),
+             "Query a Map Layer (by layer index) for features \n"
+             "at many x,y locations in the coordinates of map\n"
+             "projection at once.\n"
+             "Returns one list of features per point.\n"
+             "\n"
+             "Usage:\n"
+             ">>> m.query_points(0,[(-122,48),(0,0)])\n"
+             "[[<mapnik.Feature object at 0x3995630>], []]\n"
+            )
+        
         .def("query_point",query_point,
              (arg("layer idx"),arg("x"),arg("y")),
              "Query a Map Layer (by layer index) for features \n"
@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+#include <boost/python.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/map.hpp>
+
+using mapnik::marker_cache;
+
+namespace {
+
+using namespace boost::python;
+
+dict stats()
+{
+    mapnik::marker_cache_stats s = marker_cache::stats();
+    dict d;
+    d["hits"] = s.hits;
+    d["misses"] = s.misses;
+    d["evictions"] = s.evictions;
+    d["entries"] = s.entries;
+    d["bytes"] = s.bytes;
+    return d;
+}
+
+}
+
+void export_marker_cache()
+{
+    class_<marker_cache,boost::noncopyable>("MarkerCache",no_init)
+        .def("set_max_bytes",&marker_cache::set_max_bytes,
+             "Bound the memory used by markers loaded from files (0 for no limit).\n")
+        .def("max_bytes",&marker_cache::max_bytes)
+        .def("stats",&stats,
+             "Return hits, misses, evictions, entries and bytes of the cache.\n")
+        .def("clear",&marker_cache::clear)
+        .def("preload",&marker_cache::preload,
+             "Load every marker a Map refers to by a constant file name\n"
+             "and return how many are cached.\n")
+        .staticmethod("set_max_bytes")
+        .staticmethod("max_bytes")
+        .staticmethod("stats")
+        .staticmethod("clear")
+        .staticmethod("preload")
+        ;
+}
@@ -78,6 +78,14 @@ void export_polygon_symbolizer()
         .add_property("gamma",
                       &polygon_symbolizer::get_gamma,
                       &polygon_symbolizer::set_gamma)
+        .add_property("clip",
+                      &polygon_symbolizer::get_clip,
+                      &polygon_symbolizer::set_clip,
+                      "Clip polygons to the canvas before filling them")
+        .add_property("simplify_tolerance",
+                      &polygon_symbolizer::get_simplify_tolerance,
+                      &polygon_symbolizer::set_simplify_tolerance,
+                      "Drop vertices closer than this many pixels to the previous one")
         ;    
 
 }
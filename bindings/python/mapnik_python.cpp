@@ -65,6 +65,9 @@ void export_view_transform();
 void export_raster_colorizer();
 void export_glyph_symbolizer();
 void export_inmem_metawriter();
+void export_render_stats();
+void export_marker_cache();
+void export_request();
 
 #include <mapnik/version.hpp>
 #include <mapnik/value_error.hpp>
@@ -79,6 +82,8 @@ void export_inmem_metawriter();
 #include <mapnik/config_error.hpp>
 #include <mapnik/value_error.hpp>
 #include <mapnik/save_map.hpp>
+#include <mapnik/compiled_map.hpp>
+#include <mapnik/render_stats.hpp>
 #include "python_grid_utils.hpp"
 
 #if defined(HAVE_CAIRO) && defined(HAVE_PYCAIRO)
@@ -106,6 +111,47 @@ void render(const mapnik::Map& map,
     Py_END_ALLOW_THREADS
 }
 
+void render_with_stats(const mapnik::Map& map,
+    mapnik::image_32& image,
+    mapnik::render_stats& stats,
+    double scale_factor = 1.0,
+    unsigned offset_x = 0u,
+    unsigned offset_y = 0u)
+{
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        mapnik::agg_renderer<mapnik::image_32> ren(map,image,scale_factor,offset_x, offset_y);
+        ren.set_stats(&stats);
+        ren.apply();
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
+}
+
+void render_request(const mapnik::Map& map,
+    mapnik::image_32& image,
+    mapnik::request const& req,
+    double scale_factor = 1.0)
+{
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        mapnik::agg_renderer<mapnik::image_32> ren(map,req,image,scale_factor);
+        ren.apply();
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
+}
+
 void render_layer2(const mapnik::Map& map,
     mapnik::image_32& image,
     unsigned layer_idx)
@@ -359,7 +405,12 @@ BOOST_PYTHON_FUNCTION_OVERLOADS(load_map_overloads, load_map, 2, 3)
 BOOST_PYTHON_FUNCTION_OVERLOADS(load_map_string_overloads, load_map_string, 2, 4)
 BOOST_PYTHON_FUNCTION_OVERLOADS(save_map_overloads, save_map, 2, 3)
 BOOST_PYTHON_FUNCTION_OVERLOADS(save_map_to_string_overloads, save_map_to_string, 1, 2)
+BOOST_PYTHON_FUNCTION_OVERLOADS(load_map_cached_overloads, load_map_cached, 3, 4)
+BOOST_PYTHON_FUNCTION_OVERLOADS(save_compiled_map_overloads, save_compiled_map, 2, 3)
+BOOST_PYTHON_FUNCTION_OVERLOADS(load_compiled_map_overloads, load_compiled_map, 2, 3)
 BOOST_PYTHON_FUNCTION_OVERLOADS(render_overloads, render, 2, 5)
+BOOST_PYTHON_FUNCTION_OVERLOADS(render_with_stats_overloads, render_with_stats, 3, 6)
+BOOST_PYTHON_FUNCTION_OVERLOADS(render_request_overloads, render_request, 3, 4)
 
 BOOST_PYTHON_MODULE(_mapnik2)
 {
@@ -370,6 +421,9 @@ BOOST_PYTHON_MODULE(_mapnik2)
     using mapnik::load_map_string;
     using mapnik::save_map;
     using mapnik::save_map_to_string;
+    using mapnik::load_map_cached;
+    using mapnik::save_compiled_map;
+    using mapnik::load_compiled_map;
     using mapnik::render_grid;
 
     register_exception_translator<mapnik::config_error>(&config_error_translator);
@@ -411,6 +465,9 @@ BOOST_PYTHON_MODULE(_mapnik2)
     export_map();
     export_raster_colorizer();
     export_glyph_symbolizer();
+    export_render_stats();
+    export_marker_cache();
+    export_request();
     export_inmem_metawriter();
 
     def("render_grid",&render_grid,
@@ -488,6 +545,37 @@ BOOST_PYTHON_MODULE(_mapnik2)
             "\n"
             )); 
 
+    def("render", &render_with_stats, render_with_stats_overloads(
+            "\n"
+            "Render Map to an AGG image_32, recording timings and counters\n"
+            "into a RenderStats object\n"
+            "\n"
+            "Usage:\n"
+            ">>> from mapnik import Map, Image, RenderStats, render, load_map\n"
+            ">>> m = Map(256,256)\n"
+            ">>> load_map(m,'mapfile.xml')\n"
+            ">>> im = Image(m.width,m.height)\n"
+            ">>> stats = RenderStats()\n"
+            ">>> render(m,im,stats)\n"
+            ">>> stats.layers[0]['query_time']\n"
+            "\n"
+            ));
+
+    def("render", &render_request, render_request_overloads(
+            "\n"
+            "Render Map to an AGG image_32 at the size and extent of a Request,\n"
+            "leaving the Map untouched so other threads can render it meanwhile\n"
+            "\n"
+            "Usage:\n"
+            ">>> from mapnik import Map, Image, Request, Box2d, render, load_map\n"
+            ">>> m = Map(256,256)\n"
+            ">>> load_map(m,'mapfile.xml')\n"
+            ">>> req = Request(512,512,Box2d(-180,-90,180,90))\n"
+            ">>> im = Image(req.width,req.height)\n"
+            ">>> render(m,im,req)\n"
+            "\n"
+            ));
+
     def("render_layer", &render_layer2,
       (arg("map"),arg("image"),args("layer"))
     ); 
@@ -590,6 +678,9 @@ BOOST_PYTHON_MODULE(_mapnik2)
 */
     
     def("save_map_to_string", &save_map_to_string, save_map_to_string_overloads());
+    def("load_map_cached", &load_map_cached, load_map_cached_overloads());
+    def("save_compiled_map", &save_compiled_map, save_compiled_map_overloads());
+    def("load_compiled_map", &load_compiled_map, load_compiled_map_overloads());
     def("mapnik_version", &mapnik_version,"Get the Mapnik version number");
     def("mapnik_svn_revision", &mapnik_svn_revision,"Get the Mapnik svn revision");
     def("has_jpeg", &has_jpeg, "Get jpeg read/write support status");
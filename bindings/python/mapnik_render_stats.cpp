@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+#include <boost/python.hpp>
+#include <mapnik/render_stats.hpp>
+
+using mapnik::render_stats;
+
+namespace {
+
+using namespace boost::python;
+
+void fill_counters(dict & d, render_stats::counters const& c)
+{
+    d["query_time"] = c.query_time;
+    d["features_fetched"] = c.features_fetched;
+    d["features_matched"] = c.features_matched;
+    d["label_attempts"] = c.label_attempts;
+    d["label_successes"] = c.label_successes;
+    d["bytes_decoded"] = c.bytes_decoded;
+    dict symbolizers;
+    render_stats::symbolizer_map::const_iterator itr = c.symbolizers.begin();
+    for (; itr != c.symbolizers.end(); ++itr)
+    {
+        dict s;
+        s["count"] = itr->second.count;
+        s["time"] = itr->second.time;
+        symbolizers[itr->first] = s;
+    }
+    d["symbolizers"] = symbolizers;
+}
+
+list layers(render_stats const& stats)
+{
+    list result;
+    std::vector<render_stats::layer_stats>::const_iterator itr = stats.layers().begin();
+    for (; itr != stats.layers().end(); ++itr)
+    {
+        dict layer;
+        layer["name"] = itr->name;
+        layer["time"] = itr->time;
+        fill_counters(layer, *itr);
+        list styles;
+        std::vector<render_stats::style_stats>::const_iterator style = itr->styles.begin();
+        for (; style != itr->styles.end(); ++style)
+        {
+            dict s;
+            s["name"] = style->name;
+            s["time"] = style->time;
+            fill_counters(s, *style);
+            styles.append(s);
+        }
+        layer["styles"] = styles;
+        result.append(layer);
+    }
+    return result;
+}
+
+}
+
+void export_render_stats()
+{
+    using namespace boost::python;
+
+    class_<render_stats, boost::noncopyable>("RenderStats",
+        "Timings (in milliseconds) and counters of the renders it is passed to,\n"
+        "by layer and by style.\n"
+        "\n"
+        "Usage:\n"
+        ">>> stats = RenderStats()\n"
+        ">>> render(m,im,stats)\n"
+        ">>> for layer in stats.layers:\n"
+        "...     print layer['name'], layer['time'], layer['features_fetched']\n",
+        init<>())
+        .add_property("time", &render_stats::time,
+                      "Total wall clock time of the renders.\n")
+        .add_property("layers", &layers,
+                      "A list with a dict per rendered layer holding\n"
+                      "'name', 'time', 'query_time', 'features_fetched',\n"
+                      "'features_matched', 'label_attempts', 'label_successes',\n"
+                      "'bytes_decoded', 'symbolizers' (type -> {'count', 'time'})\n"
+                      "and 'styles', a list of dicts with the same keys per style.\n")
+        .def("clear", &render_stats::clear,
+             "Forget everything recorded so far.\n")
+        ;
+}
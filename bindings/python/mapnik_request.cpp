@@ -0,0 +1,67 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#include <boost/python.hpp>
+#include <mapnik/request.hpp>
+#include <mapnik/map.hpp>
+
+void export_request()
+{
+    using namespace boost::python;
+    using mapnik::request;
+    using mapnik::Map;
+
+    class_<request>("Request",
+                    "The size and extent of a single render.\n"
+                    "A Map rendered with a Request is only read, so several\n"
+                    "threads can render it at once with their own Request.\n",
+                    init<unsigned,unsigned,mapnik::box2d<double> const&>(
+                        (arg("width"),arg("height"),arg("extent")),
+                        "Create a Request for a width x height canvas\n"
+                        "showing extent.\n"
+                        "\n"
+                        "Usage:\n"
+                        ">>> from mapnik import Request, Box2d\n"
+                        ">>> req = Request(256,256,Box2d(-180,-90,180,90))\n"))
+        .def(init<Map const&>(
+                 (arg("map")),
+                 "Create a Request with the size, extent and buffer size of a Map.\n"))
+        .add_property("width",&request::width)
+        .add_property("height",&request::height)
+        .add_property("extent",
+                      make_function(&request::extent,
+                                    return_value_policy<copy_const_reference>()),
+                      &request::set_extent,
+                      "Get/Set the extent, used as is.\n")
+        .add_property("buffer_size",
+                      &request::buffer_size,
+                      &request::set_buffer_size,
+                      "Get/Set the size of buffer around the canvas in pixels.\n")
+        .def("zoom_to_box",&request::zoom_to_box,
+             (arg("box")),
+             "Set the extent to box, grown to the aspect ratio of the canvas.\n")
+        .def("buffered_envelope",&request::get_buffered_extent)
+        .def("scale",&request::scale)
+        ;
+}
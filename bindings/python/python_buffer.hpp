@@ -0,0 +1,239 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+#ifndef MAPNIK_PYTHON_BINDING_BUFFER_INCLUDED
+#define MAPNIK_PYTHON_BINDING_BUFFER_INCLUDED
+
+// boost
+#include <boost/python.hpp>
+
+// mapnik
+#include <mapnik/graphics.hpp>
+#include <mapnik/image_view.hpp>
+#include <mapnik/grid/grid.hpp>
+#include <mapnik/grid/grid_view.hpp>
+
+/*
+ * Python buffer protocol over the pixels of images, grids and their
+ * views, so memoryview(im) or numpy.asarray(im) read (and for images
+ * write) the pixels in place instead of copying them like tostring().
+ * Images are exported as height x width x 4 bytes (RGBA), grids as
+ * height x width uint16. Views are strided into their parent and
+ * need a consumer that accepts strides (PyBUF_STRIDES).
+ */
+
+namespace mapnik { namespace python {
+
+template <typename T>
+struct buffer_traits
+{
+    // image_view, grid and grid_view
+    static void const* row(T const& obj, unsigned y)
+    {
+        return obj.getRow(y);
+    }
+};
+
+template <>
+struct buffer_traits<image_32>
+{
+    static void const* row(image_32 const& im, unsigned y)
+    {
+        return im.data().getRow(y);
+    }
+    static char const* format() { return "B"; }
+    enum { channels = 4, pixel_size = 4, readonly = 0 };
+};
+
+template <>
+struct buffer_traits<image_view<image_data_32> >
+{
+    static void const* row(image_view<image_data_32> const& view, unsigned y)
+    {
+        return view.getRow(y);
+    }
+    static char const* format() { return "B"; }
+    enum { channels = 4, pixel_size = 4, readonly = 1 };
+};
+
+template <>
+struct buffer_traits<grid>
+{
+    static void const* row(grid const& g, unsigned y)
+    {
+        return g.getRow(y);
+    }
+    static char const* format() { return "H"; }
+    enum { channels = 1, pixel_size = 2, readonly = 1 };
+};
+
+template <>
+struct buffer_traits<grid_view>
+{
+    static void const* row(grid_view const& view, unsigned y)
+    {
+        return view.getRow(y);
+    }
+    static char const* format() { return "H"; }
+    enum { channels = 1, pixel_size = 2, readonly = 1 };
+};
+
+template <typename T>
+struct buffer_export
+{
+    typedef buffer_traits<T> traits;
+
+    static T const* get(PyObject * obj)
+    {
+        boost::python::extract<T const&> ex(obj);
+        if (!ex.check()) return 0;
+        return &ex();
+    }
+
+    static Py_ssize_t row_stride(T const& obj)
+    {
+        if (obj.height() < 2) return obj.width() * traits::pixel_size;
+        return static_cast<char const*>(traits::row(obj, 1)) -
+            static_cast<char const*>(traits::row(obj, 0));
+    }
+
+    static bool contiguous(T const& obj)
+    {
+        return row_stride(obj) == Py_ssize_t(obj.width() * traits::pixel_size);
+    }
+
+    static int get_buffer(PyObject * self, Py_buffer * view, int flags)
+    {
+        view->obj = 0;
+        T const* obj = get(self);
+        if (!obj)
+        {
+            PyErr_SetString(PyExc_BufferError, "object does not hold pixels");
+            return -1;
+        }
+        if (traits::readonly && (flags & PyBUF_WRITABLE) == PyBUF_WRITABLE)
+        {
+            PyErr_SetString(PyExc_BufferError, "buffer is read-only");
+            return -1;
+        }
+        if (!contiguous(*obj) && (flags & PyBUF_STRIDES) != PyBUF_STRIDES)
+        {
+            PyErr_SetString(PyExc_BufferError, "view is not contiguous, strides are required");
+            return -1;
+        }
+
+        int ndim = traits::channels > 1 ? 3 : 2;
+        Py_ssize_t itemsize = traits::pixel_size / traits::channels;
+        // shape followed by strides, freed by release_buffer
+        Py_ssize_t * dims = new Py_ssize_t[6];
+        dims[0] = obj->height();
+        dims[1] = obj->width();
+        dims[2] = traits::channels;
+        dims[3] = row_stride(*obj);
+        dims[4] = traits::pixel_size;
+        dims[5] = itemsize;
+
+        view->buf = obj->height() > 0 ? const_cast<void*>(traits::row(*obj, 0)) : 0;
+        view->len = dims[0] * dims[1] * traits::pixel_size;
+        view->readonly = traits::readonly;
+        view->itemsize = itemsize;
+        view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? const_cast<char*>(traits::format()) : 0;
+        view->shape = (flags & PyBUF_ND) == PyBUF_ND ? dims : 0;
+        view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? dims + 3 : 0;
+        if (!view->shape)
+        {
+            // plain bytes
+            view->ndim = 1;
+            view->itemsize = 1;
+        }
+        else view->ndim = ndim;
+        view->suboffsets = 0;
+        view->internal = dims;
+        view->obj = self;
+        Py_INCREF(self);
+        return 0;
+    }
+
+    static void release_buffer(PyObject *, Py_buffer * view)
+    {
+        delete [] static_cast<Py_ssize_t*>(view->internal);
+        view->internal = 0;
+    }
+
+#if PY_VERSION_HEX < 0x03000000
+    // old style buffers, only single segment ones can be exported
+    static Py_ssize_t get_read_buffer(PyObject * self, Py_ssize_t segment, void ** ptr)
+    {
+        T const* obj = get(self);
+        if (!obj || segment != 0 || !contiguous(*obj))
+        {
+            PyErr_SetString(PyExc_TypeError, "pixels are not a single segment buffer");
+            return -1;
+        }
+        *ptr = obj->height() > 0 ? const_cast<void*>(traits::row(*obj, 0)) : 0;
+        return obj->width() * obj->height() * traits::pixel_size;
+    }
+
+    static Py_ssize_t get_write_buffer(PyObject * self, Py_ssize_t segment, void ** ptr)
+    {
+        if (traits::readonly)
+        {
+            PyErr_SetString(PyExc_TypeError, "buffer is read-only");
+            return -1;
+        }
+        return get_read_buffer(self, segment, ptr);
+    }
+
+    static Py_ssize_t get_segment_count(PyObject * self, Py_ssize_t * len)
+    {
+        T const* obj = get(self);
+        if (len) *len = obj ? obj->width() * obj->height() * traits::pixel_size : 0;
+        return obj && contiguous(*obj) ? 1 : 0;
+    }
+#endif
+};
+
+// installs the buffer procs of T on the python class cls
+template <typename T>
+void export_buffer(boost::python::object const& cls)
+{
+    typedef buffer_export<T> exporter;
+    static PyBufferProcs procs;
+    procs.bf_getbuffer = &exporter::get_buffer;
+    procs.bf_releasebuffer = &exporter::release_buffer;
+#if PY_VERSION_HEX < 0x03000000
+    procs.bf_getreadbuffer = &exporter::get_read_buffer;
+    procs.bf_getwritebuffer = &exporter::get_write_buffer;
+    procs.bf_getsegcount = &exporter::get_segment_count;
+    procs.bf_getcharbuffer = 0;
+#endif
+    PyTypeObject * type = reinterpret_cast<PyTypeObject*>(cls.ptr());
+    type->tp_as_buffer = &procs;
+#if PY_VERSION_HEX < 0x03000000
+    type->tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+}
+
+}}
+
+#endif // MAPNIK_PYTHON_BINDING_BUFFER_INCLUDED
@@ -32,6 +32,7 @@
 #include <mapnik/grid/grid.hpp>
 #include <mapnik/grid/grid_util.hpp>
 #include <mapnik/grid/grid_view.hpp>
+#include <mapnik/grid/grid_utf.hpp>
 #include <mapnik/value_error.hpp>
 #include "mapnik_value_converter.hpp"
 
@@ -39,108 +40,30 @@
 namespace mapnik {
 
 
-template <typename T>
-static void grid2utf(T const& grid_type, 
-    boost::python::list& l,
-    std::vector<grid::lookup_type>& key_order)
-{
-    typename T::data_type const& data = grid_type.data();
-    typename T::feature_key_type const& feature_keys = grid_type.get_feature_keys();
-    typename T::key_type keys;
-    typename T::key_type::const_iterator key_pos;
-    typename T::feature_key_type::const_iterator feature_pos;
-    // start counting at utf8 codepoint 32, aka space character
-    uint16_t codepoint = 32;
-    
-    unsigned array_size = data.width();
-    for (unsigned y = 0; y < data.height(); ++y)
-    {
-        uint16_t idx = 0;
-        boost::scoped_array<Py_UNICODE> line(new Py_UNICODE[array_size]);
-        typename T::value_type const* row = data.getRow(y);
-        for (unsigned x = 0; x < data.width(); ++x)
-        {
-            feature_pos = feature_keys.find(row[x]);
-            if (feature_pos != feature_keys.end())
-            {
-                mapnik::grid::lookup_type val = feature_pos->second;
-                key_pos = keys.find(val);
-                if (key_pos == keys.end())
-                {
-                    // Create a new entry for this key. Skip the codepoints that
-                    // can't be encoded directly in JSON.
-                    if (codepoint == 34) ++codepoint;      // Skip "
-                    else if (codepoint == 92) ++codepoint; // Skip backslash
-                
-                    keys[val] = codepoint;
-                    key_order.push_back(val);
-                    line[idx++] = static_cast<Py_UNICODE>(codepoint);
-                    ++codepoint;
-                }
-                else
-                {
-                    line[idx++] = static_cast<Py_UNICODE>(key_pos->second);
-                }
-            }
-            // else, shouldn't get here...
-        }
-        l.append(boost::python::object(
-                    boost::python::handle<>(
-                        PyUnicode_FromUnicode(line.get(), array_size))));
-    }
-}
-
-
 template <typename T>
 static void grid2utf(T const& grid_type, 
     boost::python::list& l,
     std::vector<typename T::lookup_type>& key_order,
     unsigned int resolution)
 {
-    //typename T::data_type const& data = grid_type.data();
-    typename T::feature_key_type const& feature_keys = grid_type.get_feature_keys();
-    typename T::key_type keys;
-    typename T::key_type::const_iterator key_pos;
-    typename T::feature_key_type::const_iterator feature_pos;
-    // start counting at utf8 codepoint 32, aka space character
-    uint16_t codepoint = 32;
+    grid_utf::key_remapper<T> remap(grid_type.keys());
 
     // TODO - use double?
     unsigned array_size = static_cast<unsigned int>(grid_type.width()/resolution);
+    boost::scoped_array<Py_UNICODE> line(new Py_UNICODE[array_size]);
     for (unsigned y = 0; y < grid_type.height(); y=y+resolution)
     {
-        uint16_t idx = 0;
-        boost::scoped_array<Py_UNICODE> line(new Py_UNICODE[array_size]);
-        mapnik::grid::value_type const* row = grid_type.getRow(y);
-        for (unsigned x = 0; x < grid_type.width(); x=x+resolution)
+        typename T::value_type const* row = grid_type.getRow(y);
+        for (unsigned x = 0; x < array_size; ++x)
         {
-            feature_pos = feature_keys.find(row[x]);
-            if (feature_pos != feature_keys.end())
-            {
-                mapnik::grid::lookup_type val = feature_pos->second;
-                key_pos = keys.find(val);
-                if (key_pos == keys.end())
-                {
-                    // Create a new entry for this key. Skip the codepoints that
-                    // can't be encoded directly in JSON.
-                    if (codepoint == 34) ++codepoint;      // Skip "
-                    else if (codepoint == 92) ++codepoint; // Skip backslash
-                    keys[val] = codepoint;
-                    key_order.push_back(val);
-                    line[idx++] = static_cast<Py_UNICODE>(codepoint);
-                    ++codepoint;
-                }
-                else
-                {
-                    line[idx++] = static_cast<Py_UNICODE>(key_pos->second);
-                }
-            }
-            // else, shouldn't get here...
+            line[x] = static_cast<Py_UNICODE>(
+                grid_utf::key_to_codepoint(remap(row[x*resolution])));
         }
         l.append(boost::python::object(
                     boost::python::handle<>(
                         PyUnicode_FromUnicode(line.get(), array_size))));
     }
+    key_order = remap.key_order();
 }
 
 
@@ -151,10 +74,9 @@ static void grid2utf2(T const& grid_type,
     unsigned int resolution)
 {
     typename T::data_type const& data = grid_type.data();
-    typename T::feature_key_type const& feature_keys = grid_type.get_feature_keys();
+    typename T::keys_type const& feature_keys = grid_type.keys();
     typename T::key_type keys;
     typename T::key_type::const_iterator key_pos;
-    typename T::feature_key_type::const_iterator feature_pos;
     // start counting at utf8 codepoint 32, aka space character
     uint16_t codepoint = 32;
 
@@ -170,10 +92,10 @@ static void grid2utf2(T const& grid_type,
         unsigned x;
         for (x = 0; x < target.width(); ++x)
         {
-            feature_pos = feature_keys.find(row[x]);
-            if (feature_pos != feature_keys.end())
+            typename T::lookup_type const* feature_key = feature_keys.find_key(row[x]);
+            if (feature_key)
             {
-                mapnik::grid::lookup_type val = feature_pos->second;
+                mapnik::grid::lookup_type val = *feature_key;
                 key_pos = keys.find(val);
                 if (key_pos == keys.end())
                 {
@@ -207,57 +129,45 @@ static void write_features(T const& grid_type,
 {
     std::string const& key = grid_type.get_key();
     std::set<std::string> const& attributes = grid_type.property_names();
-    typename T::feature_type const& g_features = grid_type.get_grid_features();
-    typename T::feature_type::const_iterator feat_itr = g_features.begin();
-    typename T::feature_type::const_iterator feat_end = g_features.end();
+    typename T::keys_type const& keys = grid_type.keys();
     bool include_key = (attributes.find(key) != attributes.end());
-    for (; feat_itr != feat_end; ++feat_itr)
+    // only serialize features visible in the grid
+    BOOST_FOREACH ( typename T::lookup_type const& join_value, key_order )
     {
-        std::map<std::string,mapnik::value> const& props = feat_itr->second;
-        std::map<std::string,mapnik::value>::const_iterator const& itr = props.find(key);
-        if (itr != props.end())
+        typename T::feature_properties_type const* fprops = keys.find_properties(join_value);
+        if (!fprops) continue;
+        std::map<std::string,mapnik::value> const& props = *fprops;
+        boost::python::dict feat;
+        std::map<std::string,mapnik::value>::const_iterator it = props.begin();
+        std::map<std::string,mapnik::value>::const_iterator end = props.end();
+        bool found = false;
+        for (; it != end; ++it)
         {
-            typename T::lookup_type const& join_value = itr->second.to_string();
-    
-            // only serialize features visible in the grid
-            if(std::find(key_order.begin(), key_order.end(), join_value) != key_order.end()) {
-                boost::python::dict feat;
-                std::map<std::string,mapnik::value>::const_iterator it = props.begin();
-                std::map<std::string,mapnik::value>::const_iterator end = props.end();
-                bool found = false;
-                for (; it != end; ++it)
-                {
-                    std::string const& key_name = it->first;
-                    if (key_name == key) {
-                        // drop key unless requested
-                        if (include_key) {
-                            found = true;
-                            feat[it->first] = boost::python::object(
-                                boost::python::handle<>(
-                                    boost::apply_visitor(
-                                        boost::python::value_converter(),
-                                            it->second.base())));
-                        }
-                    }
-                    else if ( (attributes.find(key_name) != attributes.end()) )
-                    {
-                        found = true;
-                        feat[it->first] = boost::python::object(
-                            boost::python::handle<>(
-                                boost::apply_visitor(
-                                    boost::python::value_converter(),
-                                        it->second.base())));
-                    }
-                }
-                if (found)
-                {
-                    feature_data[feat_itr->first] = feat;
+            std::string const& key_name = it->first;
+            if (key_name == key) {
+                // drop key unless requested
+                if (include_key) {
+                    found = true;
+                    feat[it->first] = boost::python::object(
+                        boost::python::handle<>(
+                            boost::apply_visitor(
+                                boost::python::value_converter(),
+                                    it->second.base())));
                 }
             }
+            else if ( (attributes.find(key_name) != attributes.end()) )
+            {
+                found = true;
+                feat[it->first] = boost::python::object(
+                    boost::python::handle<>(
+                        boost::apply_visitor(
+                            boost::python::value_converter(),
+                                it->second.base())));
+            }
         }
-        else
+        if (found)
         {
-            std::clog << "should not get here: key '" << key << "' not found in grid feature properties\n";
+            feature_data[join_value] = feat;
         }
     }
 }
@@ -272,17 +182,11 @@ static void grid_encode_utf(T const& grid_type,
     boost::python::list l;
     std::vector<typename T::lookup_type> key_order;
     
-    if (resolution != 1) {
-        // resample on the fly - faster, less accurate
-        mapnik::grid2utf<T>(grid_type,l,key_order,resolution);
+    // resample on the fly - faster, less accurate
+    mapnik::grid2utf<T>(grid_type,l,key_order,resolution);
 
-        // resample first - slower, more accurate
-        //mapnik::grid2utf2<T>(grid_type,l,key_order,resolution);
-    }
-    else
-    {
-        mapnik::grid2utf<T>(grid_type,l,key_order);    
-    }
+    // resample first - slower, more accurate
+    //mapnik::grid2utf2<T>(grid_type,l,key_order,resolution);
 
     // convert key order to proper python list
     boost::python::list keys_a;
@@ -319,6 +223,32 @@ static boost::python::dict grid_encode( T const& grid, std::string format, bool
     }
 }
 
+template <typename T>
+static PyObject* grid_encode_json( T const& grid, bool add_features, unsigned int resolution)
+{
+    std::string s;
+    // the encoder only reads the grid (keys through keys(), which never
+    // modifies it), so other threads may read it meanwhile
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        mapnik::grid_to_utf_json<T>(grid,s,add_features,resolution);
+    }
+    catch (...)
+    {
+        Py_BLOCK_THREADS
+        throw;
+    }
+    Py_END_ALLOW_THREADS
+    return
+#if PY_VERSION_HEX >= 0x03000000 
+        ::PyBytes_FromStringAndSize
+#else
+        ::PyString_FromStringAndSize
+#endif
+        (s.data(),s.size());
+}
+
 /* new approach: key comes from grid object
  * grid size should be same as the map
  * encoding, resizing handled as method on grid object
@@ -0,0 +1,107 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_AGG_PATTERN_CACHE_HPP
+#define MAPNIK_AGG_PATTERN_CACHE_HPP
+
+// mapnik
+#include <mapnik/marker.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/agg_pattern_source.hpp>
+// boost
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+// agg
+#include "agg_pattern_filters_rgba.h"
+#include "agg_renderer_outline_image.h"
+// stl
+#include <map>
+#include <string>
+
+namespace mapnik
+{
+
+/*
+ * Pattern images used by an agg_renderer, resolved once per file name
+ * instead of once per feature. Line patterns are kept with their
+ * bilinear filtered (and dilated) copy built, which is the expensive
+ * part of setting up a line_pattern_symbolizer. The cache lives as long
+ * as the renderer, so entries are implicitly per scale factor.
+ */
+class agg_pattern_cache : private boost::noncopyable
+{
+public:
+    typedef agg::pattern_filter_bilinear_rgba8 filter_type;
+    typedef agg::line_image_pattern<filter_type> line_pattern_type;
+
+    // bitmap for filename, empty when it is missing or not a bitmap
+    image_ptr const& find_image(std::string const& filename)
+    {
+        image_cache::const_iterator itr = images_.find(filename);
+        if (itr != images_.end()) return itr->second;
+
+        image_ptr image;
+        if (!filename.empty())
+        {
+            boost::optional<marker_ptr> mark = marker_cache::instance()->find(filename, true);
+            if (mark && (*mark)->is_bitmap())
+            {
+                boost::optional<image_ptr> pat = (*mark)->get_bitmap_data();
+                if (pat) image = *pat;
+            }
+        }
+        return images_.insert(std::make_pair(filename, image)).first->second;
+    }
+
+    // prepared line pattern for filename, 0 when there is no bitmap
+    line_pattern_type const* find_line_pattern(std::string const& filename)
+    {
+        line_pattern_cache::const_iterator itr = line_patterns_.find(filename);
+        if (itr != line_patterns_.end()) return itr->second.get();
+
+        boost::shared_ptr<line_pattern_type> pattern;
+        image_ptr const& image = find_image(filename);
+        if (image)
+        {
+            pattern_source source(*image);
+            pattern = boost::make_shared<line_pattern_type>(filter_, source);
+        }
+        line_patterns_.insert(std::make_pair(filename, pattern));
+        return pattern.get();
+    }
+
+private:
+    typedef std::map<std::string, image_ptr> image_cache;
+    typedef std::map<std::string, boost::shared_ptr<line_pattern_type> > line_pattern_cache;
+
+    // referenced by every line_pattern_type
+    filter_type filter_;
+    image_cache images_;
+    line_pattern_cache line_patterns_;
+};
+
+}
+
+#endif // MAPNIK_AGG_PATTERN_CACHE_HPP
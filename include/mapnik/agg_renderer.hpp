@@ -32,6 +32,9 @@
 #include <mapnik/label_collision_detector.hpp>
 #include <mapnik/placement_finder.hpp>
 #include <mapnik/map.hpp>
+#include <mapnik/request.hpp>
+#include <mapnik/color.hpp>
+#include <mapnik/building_extrusion.hpp>
 //#include <mapnik/marker.hpp>
 
 // agg
@@ -54,6 +57,7 @@ namespace mapnik {
 class marker;
    
 struct rasterizer;
+class agg_pattern_cache;
    
 template <typename T>
 class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T> >,
@@ -62,6 +66,8 @@ class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T>
      
 public:
     agg_renderer(Map const& m, T & pixmap, double scale_factor=1.0, unsigned offset_x=0, unsigned offset_y=0);
+    // renders m with the size and extent of req, m may be shared between threads
+    agg_renderer(Map const& m, request const& req, T & pixmap, double scale_factor=1.0, unsigned offset_x=0, unsigned offset_y=0);
     ~agg_renderer();
     void start_map_processing(Map const& map);
     void end_map_processing(Map const& map);
@@ -111,6 +117,28 @@ public:
     };
 
 private:
+    // pending run of polygon fills sharing the same paint, accumulated
+    // in ras_ptr and swept once by flush_polygons()
+    struct polygon_batch
+    {
+        polygon_batch()
+            : pending(false),
+              fill(),
+              gamma(1.0),
+              clockwise(false),
+              vertices(0) {}
+        bool pending;
+        color fill;
+        double gamma;
+        bool clockwise;
+        unsigned vertices;
+    };
+    // renders pending polygons, must be called before anything else
+    // draws into pixmap_ or uses ras_ptr
+    void flush_polygons();
+    // paints the map background into pixmap_
+    void setup(Map const& m);
+
     T & pixmap_;
     unsigned width_;
     unsigned height_;
@@ -120,6 +148,10 @@ private:
     face_manager<freetype_engine> font_manager_;
     label_collision_detector4 detector_;
     boost::scoped_ptr<rasterizer> ras_ptr;
+    boost::scoped_ptr<agg_pattern_cache> pattern_cache_;
+    polygon_batch polygons_;
+    // reused between building_symbolizer features
+    building_faces wall_faces_;
 };
 }
 
@@ -0,0 +1,245 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_BUILDING_EXTRUSION_HPP
+#define MAPNIK_BUILDING_EXTRUSION_HPP
+
+// mapnik
+#include <mapnik/vertex.hpp>
+#include <mapnik/segment.hpp>
+
+// stl
+#include <vector>
+#include <algorithm>
+
+namespace mapnik {
+
+/*
+ * Vertex sources for building_symbolizer extrusion. They generate
+ * walls, frame and roof on the fly from the footprint geometry, so
+ * nothing is allocated per face. All of them can be wrapped in
+ * coord_transform2 like a geometry.
+ */
+
+typedef std::vector<segment_t> building_faces;
+
+// collects the wall segments of geom into faces (cleared first),
+// back to front
+template <typename Geometry>
+void building_wall_segments(Geometry const& geom, building_faces & faces)
+{
+    faces.clear();
+    double x0(0);
+    double y0(0);
+    geom.rewind(0);
+    geom.vertex(&x0,&y0);
+    for (unsigned j=1;j<geom.num_points();++j)
+    {
+        double x(0);
+        double y(0);
+        unsigned cm = geom.vertex(&x,&y);
+        if (cm == SEG_LINETO)
+        {
+            faces.push_back(segment_t(x0,y0,x,y));
+        }
+        x0 = x;
+        y0 = y;
+    }
+    std::sort(faces.begin(),faces.end(), y_order);
+}
+
+// wall quads for a range of segments, all wound the same way so
+// overlapping walls never cancel out under the non-zero rule
+template <typename Iterator>
+class building_walls
+{
+public:
+    typedef double value_type;
+
+    building_walls(Iterator begin, Iterator end, double height)
+        : begin_(begin),
+          end_(end),
+          height_(height),
+          itr_(begin),
+          pos_(0) {}
+
+    void rewind(unsigned) const
+    {
+        itr_ = begin_;
+        pos_ = 0;
+    }
+
+    unsigned vertex(double * x, double * y) const
+    {
+        if (itr_ == end_) return SEG_END;
+        segment_t const& seg = *itr_;
+        bool flip = (seg.get<2>() - seg.get<0>()) * height_ < 0;
+        double x0 = seg.get<0>(), y0 = seg.get<1>();
+        double x1 = seg.get<2>(), y1 = seg.get<3>();
+        if (flip)
+        {
+            std::swap(x0,x1);
+            std::swap(y0,y1);
+        }
+        unsigned cmd = SEG_LINETO;
+        switch (pos_)
+        {
+        case 0: *x = x0; *y = y0; cmd = SEG_MOVETO; break;
+        case 1: *x = x1; *y = y1; break;
+        case 2: *x = x1; *y = y1 + height_; break;
+        default: *x = x0; *y = y0 + height_; break;
+        }
+        if (++pos_ == 4)
+        {
+            pos_ = 0;
+            ++itr_;
+        }
+        return cmd;
+    }
+
+private:
+    Iterator begin_;
+    Iterator end_;
+    double height_;
+    mutable Iterator itr_;
+    mutable unsigned pos_;
+};
+
+// outline drawn around the building: the footprint, the vertical
+// edges of every face (in faces order) and the roof outline
+template <typename Geometry>
+class building_frame
+{
+public:
+    typedef double value_type;
+
+    building_frame(Geometry const& geom, building_faces const& faces, double height)
+        : geom_(geom),
+          faces_(faces),
+          height_(height),
+          stage_(footprint),
+          pos_(0) {}
+
+    void rewind(unsigned) const
+    {
+        // the first footprint vertex only starts the first segment
+        double x, y;
+        geom_.rewind(0);
+        geom_.vertex(&x,&y);
+        stage_ = footprint;
+        pos_ = 0;
+    }
+
+    unsigned vertex(double * x, double * y) const
+    {
+        for (;;)
+        {
+            switch (stage_)
+            {
+            case footprint:
+            {
+                unsigned cm = geom_.vertex(x,y);
+                if (cm == SEG_MOVETO || cm == SEG_LINETO) return cm;
+                if (cm == SEG_END)
+                {
+                    stage_ = edges;
+                    pos_ = 0;
+                }
+                break;
+            }
+            case edges:
+                if (pos_ < 2 * faces_.size())
+                {
+                    segment_t const& seg = faces_[pos_ / 2];
+                    *x = seg.get<0>();
+                    *y = seg.get<1>();
+                    if (pos_++ % 2 == 0) return SEG_MOVETO;
+                    *y += height_;
+                    return SEG_LINETO;
+                }
+                geom_.rewind(0);
+                stage_ = roof;
+                break;
+            default:
+            {
+                unsigned cm = geom_.vertex(x,y);
+                if (cm == SEG_END) return SEG_END;
+                if (cm == SEG_MOVETO || cm == SEG_LINETO)
+                {
+                    *y += height_;
+                    return cm;
+                }
+                break;
+            }
+            }
+        }
+    }
+
+private:
+    enum stage_e { footprint, edges, roof };
+    Geometry const& geom_;
+    building_faces const& faces_;
+    double height_;
+    mutable stage_e stage_;
+    mutable unsigned pos_;
+};
+
+// the footprint raised by height
+template <typename Geometry>
+class building_roof
+{
+public:
+    typedef double value_type;
+
+    building_roof(Geometry const& geom, double height)
+        : geom_(geom),
+          height_(height) {}
+
+    void rewind(unsigned pos) const
+    {
+        geom_.rewind(pos);
+    }
+
+    unsigned vertex(double * x, double * y) const
+    {
+        for (;;)
+        {
+            unsigned cm = geom_.vertex(x,y);
+            if (cm == SEG_END) return SEG_END;
+            if (cm == SEG_MOVETO || cm == SEG_LINETO)
+            {
+                *y += height_;
+                return cm;
+            }
+        }
+    }
+
+private:
+    Geometry const& geom_;
+    double height_;
+};
+
+}
+
+#endif // MAPNIK_BUILDING_EXTRUSION_HPP
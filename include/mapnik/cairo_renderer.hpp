@@ -36,6 +36,7 @@
 #include <mapnik/label_collision_detector.hpp>
 #include <mapnik/placement_finder.hpp>
 #include <mapnik/map.hpp>
+#include <mapnik/image_data.hpp>
 //#include <mapnik/marker.hpp>
 
 // cairo
@@ -45,6 +46,10 @@
 // boost
 #include <boost/utility.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+// stl
+#include <map>
 
 // FIXME
 // forward declare so that
@@ -62,6 +67,8 @@ class cairo_face;
 
 typedef boost::shared_ptr<cairo_face> cairo_face_ptr;
 
+// Cairo font faces of a renderer. Faces missing here are taken from a
+// process wide cache, so they are only created once per font and thread.
 class cairo_face_manager : private boost::noncopyable
 {
 public:
@@ -70,10 +77,10 @@ public:
     cairo_face_ptr get_face(face_ptr face);
 
 private:
-    typedef std::map<face_ptr,cairo_face_ptr> cairo_face_cache;
+    typedef std::map<face_ptr,cairo_face_ptr> face_map;
     boost::shared_ptr<freetype_engine> font_engine_;
     face_manager<freetype_engine> & font_manager_;
-    cairo_face_cache cache_;
+    face_map cache_;
 };
 
 class MAPNIK_DECL cairo_renderer_base : private boost::noncopyable
@@ -81,7 +88,7 @@ class MAPNIK_DECL cairo_renderer_base : private boost::noncopyable
 protected:
     cairo_renderer_base(Map const& m, Cairo::RefPtr<Cairo::Context> const& context, unsigned offset_x=0, unsigned offset_y=0);
 public:
-    ~cairo_renderer_base();
+    virtual ~cairo_renderer_base();
     void start_map_processing(Map const& map);
     void start_layer_processing(layer const& lay);
     void end_layer_processing(layer const& lay);
@@ -126,7 +133,11 @@ public:
         return false;
     };
 protected:
+    // stats of the feature_style_processor, for label attempts
+    virtual render_stats * stats() const = 0;
     void render_marker(const int x, const int y, marker &marker, const agg::trans_affine & mtx, double opacity=1.0);
+    // surface of a marker bitmap, created once per renderer
+    Cairo::RefPtr<Cairo::ImageSurface> image_surface(boost::shared_ptr<image_data_32> const& image);
 
     Map const& m_;
     Cairo::RefPtr<Cairo::Context> context_;
@@ -135,6 +146,7 @@ protected:
     face_manager<freetype_engine> font_manager_;
     cairo_face_manager face_manager_;
     label_collision_detector4 detector_;
+    std::map<boost::shared_ptr<image_data_32>, Cairo::RefPtr<Cairo::ImageSurface> > image_surfaces_;
 };
 
 template <typename T>
@@ -144,6 +156,10 @@ class MAPNIK_DECL cairo_renderer : public feature_style_processor<cairo_renderer
 public:
     cairo_renderer(Map const& m, Cairo::RefPtr<T> const& surface, unsigned offset_x=0, unsigned offset_y=0);
     void end_map_processing(Map const& map);
+    render_stats * stats() const
+    {
+        return feature_style_processor<cairo_renderer<T> >::stats();
+    }
 };
 }
 
@@ -0,0 +1,227 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_CLIPPED_PATH_HPP
+#define MAPNIK_CLIPPED_PATH_HPP
+
+// mapnik
+#include <mapnik/box2d.hpp>
+#include <mapnik/vertex.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/stroke.hpp>
+
+// agg
+#include "agg_basics.h"
+#include "agg_conv_clip_polygon.h"
+#include "agg_conv_clip_polyline.h"
+
+namespace mapnik {
+
+/*
+ * Vertex source adaptor sitting between the screen space path
+ * (coord_transform2) and the rasterizer / stroker:
+ *
+ *  1. clips to a box around the canvas (Liang-Barsky via agg's
+ *     conv_clip_polygon / conv_clip_polyline), so only the visible part
+ *     of a huge geometry reaches the stroker and rasterizer
+ *  2. drops vertices closer than 'tolerance' pixels to the last one
+ *     emitted; the last vertex of every sub-path is always kept
+ *
+ * Both stages are optional and selected at runtime, so a single type
+ * serves every combination of symbolizer settings.
+ */
+template <typename Path>
+class clipped_path
+{
+public:
+    enum path_kind
+    {
+        polyline,
+        polygon
+    };
+
+    clipped_path(Path & path, path_kind kind)
+        : path_(path),
+          line_clip_(path),
+          poly_clip_(path),
+          kind_(kind),
+          clip_(false),
+          tolerance_sq_(0.0),
+          last_x_(0.0),
+          last_y_(0.0),
+          has_skipped_(false),
+          skipped_x_(0.0),
+          skipped_y_(0.0),
+          has_pending_(false),
+          pending_cmd_(SEG_END),
+          pending_x_(0.0),
+          pending_y_(0.0) {}
+
+    void clip_box(box2d<double> const& box)
+    {
+        clip_ = true;
+        line_clip_.clip_box(box.minx(), box.miny(), box.maxx(), box.maxy());
+        poly_clip_.clip_box(box.minx(), box.miny(), box.maxx(), box.maxy());
+    }
+
+    void tolerance(double tolerance)
+    {
+        tolerance_sq_ = tolerance > 0.0 ? tolerance * tolerance : 0.0;
+    }
+
+    void rewind(unsigned pos)
+    {
+        has_skipped_ = false;
+        has_pending_ = false;
+        if (!clip_) path_.rewind(pos);
+        else if (kind_ == polygon) poly_clip_.rewind(pos);
+        else line_clip_.rewind(pos);
+    }
+
+    unsigned vertex(double * x, double * y)
+    {
+        if (tolerance_sq_ <= 0.0) return source_vertex(x, y);
+
+        if (has_pending_)
+        {
+            has_pending_ = false;
+            *x = pending_x_;
+            *y = pending_y_;
+            if (agg::is_move_to(pending_cmd_))
+            {
+                last_x_ = *x;
+                last_y_ = *y;
+            }
+            return pending_cmd_;
+        }
+
+        for (;;)
+        {
+            unsigned cmd = source_vertex(x, y);
+            if (agg::is_line_to(cmd))
+            {
+                double dx = *x - last_x_;
+                double dy = *y - last_y_;
+                if (dx * dx + dy * dy < tolerance_sq_)
+                {
+                    has_skipped_ = true;
+                    skipped_x_ = *x;
+                    skipped_y_ = *y;
+                    continue;
+                }
+                has_skipped_ = false;
+                last_x_ = *x;
+                last_y_ = *y;
+                return cmd;
+            }
+            if (has_skipped_)
+            {
+                // sub-path ended on skipped vertices, emit the last
+                // one before whatever comes next
+                has_skipped_ = false;
+                has_pending_ = true;
+                pending_cmd_ = cmd;
+                pending_x_ = *x;
+                pending_y_ = *y;
+                *x = skipped_x_;
+                *y = skipped_y_;
+                return SEG_LINETO;
+            }
+            if (agg::is_move_to(cmd))
+            {
+                last_x_ = *x;
+                last_y_ = *y;
+            }
+            return cmd;
+        }
+    }
+
+private:
+    unsigned source_vertex(double * x, double * y)
+    {
+        if (!clip_) return path_.vertex(x, y);
+        if (kind_ == polygon) return poly_clip_.vertex(x, y);
+        return line_clip_.vertex(x, y);
+    }
+
+    clipped_path(clipped_path const&);
+    clipped_path& operator=(clipped_path const&);
+
+    Path & path_;
+    agg::conv_clip_polyline<Path> line_clip_;
+    agg::conv_clip_polygon<Path> poly_clip_;
+    path_kind kind_;
+    bool clip_;
+    double tolerance_sq_;
+    double last_x_, last_y_;
+    bool has_skipped_;
+    double skipped_x_, skipped_y_;
+    bool has_pending_;
+    unsigned pending_cmd_;
+    double pending_x_, pending_y_;
+};
+
+/*
+ * Applies the clip / simplify-tolerance settings of sym to path.
+ * 'padding' grows the canvas box so strokes and anti-aliasing
+ * of clipped edges stay outside of the visible area.
+ */
+template <typename Path>
+void setup_clipped_path(clipped_path<Path> & path,
+                        symbolizer_base const& sym,
+                        double width, double height,
+                        double padding)
+{
+    if (sym.get_clip())
+    {
+        path.clip_box(box2d<double>(-padding, -padding, width + padding, height + padding));
+    }
+    path.tolerance(sym.get_simplify_tolerance());
+}
+
+/*
+ * setup_clipped_path for a stroked line. Dashed lines are not clipped:
+ * the dash pattern would restart at the clip box, which differs from
+ * tile to tile. Otherwise the box is padded by miter_limit times the
+ * stroke width, enough for the longest miter join.
+ */
+template <typename Path>
+void setup_clipped_line(clipped_path<Path> & path,
+                        symbolizer_base const& sym,
+                        stroke const& s,
+                        double width, double height,
+                        double scale_factor,
+                        double miter_limit)
+{
+    if (sym.get_clip() && !s.has_dash())
+    {
+        double padding = miter_limit * s.get_width() * scale_factor + 1.0;
+        path.clip_box(box2d<double>(-padding, -padding, width + padding, height + padding));
+    }
+    path.tolerance(sym.get_simplify_tolerance());
+}
+
+}
+
+#endif // MAPNIK_CLIPPED_PATH_HPP
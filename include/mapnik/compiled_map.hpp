@@ -0,0 +1,62 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+// $Id$
+
+#ifndef MAPNIK_COMPILED_MAP_HPP
+#define MAPNIK_COMPILED_MAP_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+// stl
+#include <string>
+
+namespace mapnik
+{
+class Map;
+
+/*
+ * Compiled maps are a binary dump of everything load_map() builds:
+ * styles, rules, already parsed expressions and path expressions,
+ * symbolizers, fontsets, metawriters and layers with their datasource
+ * parameters. Restoring one skips the XML and grammar parsing entirely,
+ * only the datasources are created again.
+ *
+ * 'source' names the stylesheet the map was loaded from. Its size and
+ * content hash are recorded in the file and a compiled map whose source
+ * has changed since (or which was written by a different mapnik version)
+ * is treated as stale. Files pulled in through XML entities are not
+ * tracked.
+ */
+
+MAPNIK_DECL void save_compiled_map(Map const& map, std::string const& filename, std::string const& source = "");
+
+// Returns false, leaving the map untouched, when the file is missing or stale.
+// Throws config_error for unreadable or truncated files.
+MAPNIK_DECL bool load_compiled_map(Map & map, std::string const& filename, std::string const& source = "");
+
+// load_map() with a compiled map cache: restores cache_filename when it is
+// still valid for filename, otherwise loads the XML and rewrites the cache.
+MAPNIK_DECL void load_map_cached(Map & map, std::string const& filename, std::string const& cache_filename, bool strict = false);
+
+}
+
+#endif // MAPNIK_COMPILED_MAP_HPP
@@ -34,6 +34,7 @@
 #include <boost/shared_ptr.hpp>
 // stl
 #include <map>
+#include <vector>
 
 namespace mapnik {
 class MAPNIK_DECL datasource_cache : 
@@ -45,9 +46,23 @@ private:
     ~datasource_cache();
     datasource_cache(const datasource_cache&);
     datasource_cache& operator=(const datasource_cache&);
-    static std::map<std::string,boost::shared_ptr<PluginInfo> > plugins_;
+    struct plugin_entry
+    {
+        boost::shared_ptr<PluginInfo> info;
+        // resolved once, when the plugin is registered
+        create_ds* create;
+    };
+    typedef std::map<std::string,plugin_entry> plugin_map;
+    // registered plugins. register_datasources publishes a new map instead
+    // of modifying this one, so create() and plugin_names() only lock to
+    // take a reference and read the map itself without locking
+    static boost::shared_ptr<plugin_map const> plugins_;
+#ifdef MAPNIK_THREADSAFE
+    static mutex plugins_mutex_;
+#endif
+    static boost::shared_ptr<plugin_map const> plugins();
     static bool registered_;
-    static bool insert(const std::string&  name,const lt_dlhandle module);
+    static bool insert(plugin_map & plugins, const std::string&  name,const lt_dlhandle module);
     static std::vector<std::string> plugin_directories_;
 public:
     static std::vector<std::string> plugin_names();
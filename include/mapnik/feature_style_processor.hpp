@@ -30,12 +30,14 @@
 #include <mapnik/datasource.hpp>
 #include <mapnik/layer.hpp>
 #include <mapnik/map.hpp>
+#include <mapnik/request.hpp>
 #include <mapnik/attribute_collector.hpp>
 #include <mapnik/expression_evaluator.hpp>
 #include <mapnik/utils.hpp>
 #include <mapnik/projection.hpp>
 #include <mapnik/scale_denominator.hpp>
 #include <mapnik/memory_datasource.hpp>
+#include <mapnik/render_stats.hpp>
 
 #ifdef MAPNIK_DEBUG
 //#include <mapnik/wall_clock_timer.hpp>
@@ -81,7 +83,31 @@ public:
 
     explicit feature_style_processor(Map const& m, double scale_factor = 1.0)
         : m_(m),
-          scale_factor_(scale_factor) {}
+          req_(m),
+          scale_factor_(scale_factor),
+          stats_(0) {}
+
+    /*!
+     * render m with the size and extent of req, m itself is only read
+     */
+    feature_style_processor(Map const& m, request const& req, double scale_factor = 1.0)
+        : m_(m),
+          req_(req),
+          scale_factor_(scale_factor),
+          stats_(0) {}
+
+    /*!
+     * attach a collector filled by the following apply() calls, 0 detaches
+     */
+    void set_stats(render_stats * stats)
+    {
+        stats_ = stats;
+    }
+
+    render_stats * stats() const
+    {
+        return stats_;
+    }
 
     /*!
      * @return apply renderer to all map layers.
@@ -92,15 +118,16 @@ public:
         //mapnik::wall_clock_progress_timer t(std::clog, "map rendering took: ");
 #endif          
         Processor & p = static_cast<Processor&>(*this);
+        if (stats_) stats_->start_map();
         p.start_map_processing(m_);
                        
         try
         {
             projection proj(m_.srs());
 
-            start_metawriters(m_,proj);
+            start_metawriters(proj);
 
-            double scale_denom = mapnik::scale_denominator(m_,proj.is_geographic());
+            double scale_denom = mapnik::scale_denominator(req_.scale(),proj.is_geographic());
             scale_denom *= scale_factor_;
 #ifdef MAPNIK_DEBUG
             std::clog << "scale denominator = " << scale_denom << "\n";
@@ -114,7 +141,7 @@ public:
                 }
             }
 
-            stop_metawriters(m_);
+            stop_metawriters();
         }
         catch (proj_init_error& ex)
         {
@@ -122,6 +149,7 @@ public:
         }
         
         p.end_map_processing(m_);
+        if (stats_) stats_->end_map();
     }   
 
     /*!
@@ -130,11 +158,12 @@ public:
     void apply(mapnik::layer const& lyr, std::set<std::string>& names)
     {
         Processor & p = static_cast<Processor&>(*this);
+        if (stats_) stats_->start_map();
         p.start_map_processing(m_);
         try
         {
             projection proj(m_.srs());
-            double scale_denom = mapnik::scale_denominator(m_,proj.is_geographic());
+            double scale_denom = mapnik::scale_denominator(req_.scale(),proj.is_geographic());
             scale_denom *= scale_factor_;
 
             if (lyr.isVisible(scale_denom))
@@ -147,18 +176,59 @@ public:
             std::clog << "proj_init_error:" << ex.what() << "\n"; 
         }
         p.end_map_processing(m_);
+        if (stats_) stats_->end_map();
     }
 private:
+    /*!
+     * @return next feature of fs, timed and counted when collecting stats.
+     */
+    feature_ptr next_feature(Featureset & fs)
+    {
+        if (!stats_) return fs.next();
+
+        double start = render_stats::now();
+        feature_ptr feature = fs.next();
+        render_stats::counters & counters = stats_->current();
+        counters.query_time += render_stats::now() - start;
+        if (feature)
+        {
+            ++counters.features_fetched;
+            raster_ptr const& raster = feature->get_raster();
+            if (raster)
+            {
+                counters.bytes_decoded += raster->data_.width() * raster->data_.height() * 4;
+            }
+        }
+        return feature;
+    }
+
+    /*!
+     * @return process a single symbolizer, timed when collecting stats.
+     */
+    void process_symbolizer(Processor & p, Feature const& f,
+                            proj_transform const& prj_trans,
+                            symbolizer const& sym)
+    {
+        if (!stats_)
+        {
+            boost::apply_visitor(symbol_dispatch(p,f,prj_trans),sym);
+            return;
+        }
+        double start = render_stats::now();
+        boost::apply_visitor(symbol_dispatch(p,f,prj_trans),sym);
+        stats_->add_symbolizer_time(sym, render_stats::now() - start);
+    }
+
     /*!
      * @return initialize metawriters for a given map and projection.
      */
-    void start_metawriters(Map const& m_, projection const& proj)
+    void start_metawriters(projection const& proj)
     {
         Map::const_metawriter_iterator metaItr = m_.begin_metawriters();
         Map::const_metawriter_iterator metaItrEnd = m_.end_metawriters();
         for (;metaItr!=metaItrEnd; ++metaItr)
         {
-            metaItr->second->set_size(m_.width(), m_.height());
+            metaItr->second->set_size(req_.width(), req_.height());
             metaItr->second->set_map_srs(proj);
             metaItr->second->start(m_.metawriter_output_properties);
         }
@@ -166,7 +236,7 @@ private:
     /*!
      * @return stop metawriters that were previously initialized.
      */
-    void stop_metawriters(Map const& m_)
+    void stop_metawriters()
     {
         Map::const_metawriter_iterator metaItr = m_.begin_metawriters();
         Map::const_metawriter_iterator metaItrEnd = m_.end_metawriters();
@@ -202,6 +272,7 @@ private:
         }
         
         p.start_layer_processing(lay);
+        if (stats_) stats_->start_layer(lay.name());
         
         if (ds)
         {
@@ -216,10 +287,11 @@ private:
                 std::clog << "WARNING: Map srs does not match layer srs, skipping raster layer '" << lay.name() 
                     << "' as raster re-projection is not currently supported (http://trac.mapnik.org/ticket/663)\n"
                     << "map srs: '" << m_.srs() << "'\nlayer srs: '" << lay.srs() << "' \n";       
+                if (stats_) stats_->end_layer();
                 return;
             }
             
-            box2d<double> map_ext = m_.get_buffered_extent();
+            box2d<double> map_ext = req_.get_buffered_extent();
 
             // clip buffered extent by maximum extent, if supplied
             boost::optional<box2d<double> > const& maximum_extent = m_.maximum_extent();
@@ -247,14 +319,16 @@ private:
             else
             {
                  // if no intersection then nothing to do for layer
+                 if (stats_) stats_->end_layer();
                  return;
             }
                         
-            query::resolution_type res(m_.width()/m_.get_current_extent().width(),
-                                       m_.height()/m_.get_current_extent().height());
+            query::resolution_type res(req_.width()/req_.extent().width(),
+                                       req_.height()/req_.extent().height());
             query q(layer_ext,res,scale_denom); //BBOX query
                            
             std::vector<feature_type_style*> active_styles;
+            std::vector<std::string> active_style_names;
             attribute_collector collector(names);
             double filt_factor = 1;
             directive_collector d_collector(&filt_factor);
@@ -288,6 +362,7 @@ private:
                 if (active_rules)
                 {
                     active_styles.push_back(const_cast<feature_type_style*>(&(*style)));
+                    active_style_names.push_back(style_name);
                 }
             }
             
@@ -301,8 +376,11 @@ private:
             bool cache_features = lay.cache_features() && num_styles>1?true:false;
             bool first = true;
             
-            BOOST_FOREACH (feature_type_style * style, active_styles)
+            for (unsigned i = 0; i < active_styles.size(); ++i)
             {
+                feature_type_style * style = active_styles[i];
+                if (stats_) stats_->start_style(active_style_names[i]);
+
                 std::vector<rule*> if_rules;
                 std::vector<rule*> else_rules;
 
@@ -340,6 +418,7 @@ private:
                 
                 // process features
                 featureset_ptr fs;
+                double query_start = stats_ ? render_stats::now() : 0.0;
                 if (first)
                 {
                     if (cache_features)
@@ -350,11 +429,12 @@ private:
                 {
                     fs = cache.features(q);
                 }
+                if (stats_) stats_->current().query_time += render_stats::now() - query_start;
                 
                 if (fs)
                 {               
                     feature_ptr feature;
-                    while ((feature = fs->next()))
+                    while ((feature = next_feature(*fs)))
                     {                  
                         bool do_else=true;
                         
@@ -381,7 +461,7 @@ private:
 
                                     BOOST_FOREACH (symbolizer const& sym, symbols)
                                     {   
-                                        boost::apply_visitor(symbol_dispatch(p,*feature,prj_trans),sym);
+                                        process_symbolizer(p,*feature,prj_trans,sym);
                                     }
                                 }
                                 if (style->get_filter_mode() == FILTER_FIRST)
@@ -391,6 +471,10 @@ private:
                                 }
                             }
                         }
+                        if (stats_ && (!do_else || !else_rules.empty()))
+                        {
+                            ++stats_->current().features_matched;
+                        }
                         if (do_else)
                         {
                             BOOST_FOREACH( rule * r, else_rules )
@@ -404,7 +488,7 @@ private:
                                 {
                                     BOOST_FOREACH (symbolizer const& sym, symbols)
                                     {
-                                        boost::apply_visitor(symbol_dispatch(p,*feature,prj_trans),sym);
+                                        process_symbolizer(p,*feature,prj_trans,sym);
                                     }
                                 }
                             }
@@ -416,10 +500,13 @@ private:
         }
         
         p.end_layer_processing(lay);
+        if (stats_) stats_->end_layer();
     } 
     
     Map const& m_;
+    request req_;
     double scale_factor_;
+    render_stats * stats_;
 };
 }
 
@@ -67,6 +67,10 @@ namespace mapnik
 class font_face;
 
 typedef boost::shared_ptr<font_face> face_ptr;
+// FT_Library released with FT_Done_FreeType once its last face is gone
+typedef boost::shared_ptr<FT_LibraryRec_> ft_library_ptr;
+// content of a font file, shared by every face created from it
+typedef boost::shared_ptr<std::vector<char> > font_data_ptr;
 
 class MAPNIK_DECL font_glyph : private boost::noncopyable
 {
@@ -96,6 +100,12 @@ public:
     font_face(FT_Face face)
         : face_(face) {}
 
+    // keeps the library and the memory the face was created from alive
+    font_face(FT_Face face, ft_library_ptr const& library, font_data_ptr const& data)
+        : library_(library),
+          data_(data),
+          face_(face) {}
+
     std::string  family_name() const
     {
         return std::string(face_->family_name);
@@ -139,6 +149,8 @@ public:
     }
 
 private:
+    ft_library_ptr library_;
+    font_data_ptr data_;
     FT_Face face_;
 };
 
@@ -201,6 +213,10 @@ class stroker : boost::noncopyable
 public:
     explicit stroker(FT_Stroker s)
         : s_(s) {}
+
+    stroker(FT_Stroker s, ft_library_ptr const& library)
+        : library_(library),
+          s_(s) {}
     
     void init(double radius)
     {
@@ -223,6 +239,7 @@ public:
         FT_Stroker_Done(s_);
     }
 private:
+    ft_library_ptr library_;
     FT_Stroker s_;
 };
 
@@ -231,6 +248,17 @@ private:
 typedef boost::shared_ptr<font_face_set> face_set_ptr;
 typedef boost::shared_ptr<stroker> stroker_ptr;
 
+/*
+ * Font files are read into memory once per process, on first use, and
+ * faces are created from that memory with FT_New_Memory_Face. Every
+ * thread has its own FT_Library and keeps the faces it created, so
+ * renderers running on the same thread share them instead of opening
+ * and parsing the font files again on every render. Faces (and so
+ * renderers) must stay on the thread that created them.
+ *
+ * Directories passed to register_fonts() are only scanned the first time
+ * a face is looked up.
+ */
 class MAPNIK_DECL freetype_engine
 {
 public:
@@ -243,11 +271,18 @@ public:
     virtual ~freetype_engine();
     freetype_engine();
 private:
-    FT_Library library_;
+    // the following expect mutex_ to be held
+    static bool add_font_file(std::string const& file_name);
+    static void scan_fonts(std::string const& dir, bool recurse);
+    static void index_pending_fonts();
+    static font_data_ptr font_data(std::string const& file_name);
 #ifdef MAPNIK_THREADSAFE
     static boost::mutex mutex_;
 #endif
     static std::map<std::string,std::string> name2file_;
+    static std::map<std::string,font_data_ptr> file2data_;
+    // directories registered but not scanned yet, with their recurse flag
+    static std::vector<std::pair<std::string,bool> > pending_dirs_;
 };
 
 template <typename T>
@@ -27,6 +27,7 @@
 #include <mapnik/image_data.hpp>
 #include <mapnik/box2d.hpp>
 #include <mapnik/grid/grid_view.hpp>
+#include <mapnik/grid/grid_keys.hpp>
 #include <mapnik/global.hpp>
 #include <mapnik/value.hpp>
 #include <mapnik/feature.hpp>
@@ -48,23 +49,25 @@ class MAPNIK_DECL hit_grid
 public:
     typedef T value_type;
     typedef mapnik::ImageData<value_type> data_type;
-    typedef std::string lookup_type;
-    // mapping between pixel id and key
-    typedef std::map<value_type, lookup_type> feature_key_type;
-    typedef std::map<lookup_type, value_type> key_type;
-    typedef std::map<std::string, mapnik::value> feature_properties_type;
-    // note: feature_type is not the same as a mapnik::Feature as it lacks a geometry
-    typedef std::map<std::string, feature_properties_type > feature_type;
+    typedef hit_grid_keys<value_type> keys_type;
+    typedef typename keys_type::lookup_type lookup_type;
+    typedef typename keys_type::feature_key_type feature_key_type;
+    typedef typename keys_type::key_type key_type;
+    typedef typename keys_type::feature_properties_type feature_properties_type;
+    typedef typename keys_type::feature_type feature_type;
     
 private:
     unsigned width_;
     unsigned height_;
     std::string key_;
-    feature_key_type f_keys_;
-    feature_type features_;
+    keys_type keys_;
     data_type data_;
     std::set<std::string> names_;
     unsigned int resolution_;
+    // lookup value of the feature pixel_id() was last asked for,
+    // so add_feature() does not compute it again
+    mapnik::Feature const* pending_feature_;
+    lookup_type pending_lookup_;
     
 public:
 
@@ -76,11 +79,8 @@ public:
          key_(key),
          data_(width,height),
          resolution_(resolution),
-         id_name_("__id__") {
-             // this only works if each datasource's 
-             // feature count starts at 1
-             f_keys_[0] = "";
-         }
+         pending_feature_(0),
+         id_name_("__id__") {}
     
     hit_grid(const hit_grid<T>& rhs)
         :width_(rhs.width_),
@@ -88,59 +88,93 @@ public:
          key_(rhs.key_),
          data_(rhs.data_),
          resolution_(rhs.resolution_),
+         pending_feature_(0),
          id_name_("__id__")  {
-             f_keys_[0] = "";     
+             keys_.set_compact(rhs.compact());
          }
     
     ~hit_grid() {}
 
-    void add_feature(mapnik::Feature const& feature)
+    // id to burn into the grid for this feature. In compact mode a key
+    // seen for the first time gets the next free id, which is only taken
+    // once add_feature() reports the feature as drawn.
+    value_type pixel_id(mapnik::Feature const& feature)
     {
+        pending_feature_ = &feature;
+        pending_lookup_ = get_lookup_value(feature);
+        if (!keys_.compact())
+        {
+            return static_cast<value_type>(feature.id());
+        }
+        if (pending_lookup_.empty())
+        {
+            return 0;
+        }
+        value_type id = keys_.find_id(pending_lookup_);
+        return id != 0 ? id : keys_.next_id();
+    }
 
-        // copies feature props
-        std::map<std::string,value> fprops = feature.props();
+    // to be called once the feature's pixels are written
+    void add_feature(mapnik::Feature const& feature)
+    {
         lookup_type lookup_value;
-        if (key_ == id_name_)
+        if (pending_feature_ == &feature)
         {
-            // TODO - this will break if lookup_type is not a string
-            std::stringstream s;
-            s << feature.id();
-            lookup_value = s.str();
-            // add this as a proper feature so filtering works later on
-            fprops[id_name_] = feature.id();
-            //fprops[id_name_] = tr_->transcode(lookup_value));
+            lookup_value.swap(pending_lookup_);
+            pending_feature_ = 0;
         }
         else
         {
-            std::map<std::string,value>::const_iterator const& itr = fprops.find(key_);
-            if (itr != fprops.end())
-            {
-                lookup_value = itr->second.to_string();
-            }
-            else
-            {
-                std::clog << "should not get here: key '" << key_ << "' not found in feature properties\n";
-            }    
+            lookup_value = get_lookup_value(feature);
         }
 
         // what good is an empty lookup key?
-        if (!lookup_value.empty())
+        if (lookup_value.empty())
+        {
+            std::clog << "### Warning: key '" << key_ << "' was blank for " << feature << "\n";
+            return;
+        }
+
+        if (keys_.compact())
         {
-            // TODO - consider shortcutting f_keys if feature_id == lookup_value
-            // create a mapping between the pixel id and the feature key
-            f_keys_.insert(std::make_pair(feature.id(),lookup_value));
-            // if extra fields have been supplied, push them into grid memory
-            if (!names_.empty()) {
-                // TODO - add ability to push WKT/WKB of geometry into grid storage
-                features_.insert(std::make_pair(lookup_value,fprops));
+            if (keys_.find_id(lookup_value) != 0) return;
+            if (keys_.next_id() == 0)
+            {
+                // value_type wrapped around, nothing left to hand out
+                std::clog << "### Warning: grid ran out of ids for key '" << lookup_value << "'\n";
+                return;
             }
+            feature_properties_type & fprops = keys_.add_compact_key(lookup_value);
+            if (!names_.empty())
+            {
+                copy_properties(feature, fprops);
+            }
+            return;
         }
-        else
+
+        // TODO - consider shortcutting f_keys if feature_id == lookup_value
+        // create a mapping between the pixel id and the feature key
+        keys_.feature_keys().insert(std::make_pair(feature.id(),lookup_value));
+        // if extra fields have been supplied, push them into grid memory
+        // once per key, keeping only the requested fields and the key
+        feature_type & features = keys_.features();
+        if (!names_.empty() && features.find(lookup_value) == features.end())
         {
-            std::clog << "### Warning: key '" << key_ << "' was blank for " << feature << "\n";
+            // TODO - add ability to push WKT/WKB of geometry into grid storage
+            copy_properties(feature, features[lookup_value]);
         }
     } 
     
+    inline bool compact() const
+    {
+        return keys_.compact();
+    }
+
+    inline void set_compact(bool compact)
+    {
+        keys_.set_compact(compact);
+    }
+
     void add_property_name(std::string const& name)
     {
         names_.insert(name);
@@ -151,24 +185,31 @@ public:
         return names_;
     }
 
+    // keys and properties in either mode
+    inline const keys_type& keys() const
+    {
+        return keys_;
+    }
+
+    // default mode tables, empty in compact mode (use keys())
     inline const feature_type& get_grid_features() const
     {
-        return features_;
+        return keys_.features();
     }
 
     inline feature_type& get_grid_features()
     {
-        return features_;
+        return keys_.features();
     }
 
     inline const feature_key_type& get_feature_keys() const
     {
-        return f_keys_;
+        return keys_.feature_keys();
     }
 
     inline feature_key_type& get_feature_keys()
     {
-        return f_keys_;
+        return keys_.feature_keys();
     }
 
     inline const std::string& get_key() const
@@ -231,12 +272,54 @@ public:
     inline mapnik::grid_view get_view(unsigned x, unsigned y, unsigned w, unsigned h)
     {
         return mapnik::grid_view(x,y,w,h,
-            data_,key_,resolution_,names_,f_keys_,features_);
+            data_,key_,resolution_,names_,keys_);
     }
     
 
 private:
 
+    // keeps only the requested fields and the key
+    void copy_properties(mapnik::Feature const& feature, feature_properties_type & fprops) const
+    {
+        std::map<std::string,value> const& props = feature.props();
+        if (key_ == id_name_)
+        {
+            // add this as a proper feature so filtering works later on
+            fprops[id_name_] = feature.id();
+        }
+        else
+        {
+            std::map<std::string,value>::const_iterator itr = props.find(key_);
+            if (itr != props.end()) fprops.insert(*itr);
+        }
+        std::set<std::string>::const_iterator name_itr = names_.begin();
+        std::set<std::string>::const_iterator name_end = names_.end();
+        for (; name_itr != name_end; ++name_itr)
+        {
+            std::map<std::string,value>::const_iterator itr = props.find(*name_itr);
+            if (itr != props.end()) fprops.insert(*itr);
+        }
+    }
+
+    lookup_type get_lookup_value(mapnik::Feature const& feature) const
+    {
+        if (key_ == id_name_)
+        {
+            // TODO - this will break if lookup_type is not a string
+            std::ostringstream s;
+            s << feature.id();
+            return s.str();
+        }
+        std::map<std::string,value> const& props = feature.props();
+        std::map<std::string,value>::const_iterator itr = props.find(key_);
+        if (itr != props.end())
+        {
+            return itr->second.to_string();
+        }
+        std::clog << "should not get here: key '" << key_ << "' not found in feature properties\n";
+        return lookup_type();
+    }
+
     inline bool checkBounds(unsigned x, unsigned y) const
     {
         return (x < width_ && y < height_);
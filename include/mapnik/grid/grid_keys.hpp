@@ -0,0 +1,173 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_GRID_KEYS_HPP
+#define MAPNIK_GRID_KEYS_HPP
+
+// mapnik
+#include <mapnik/value.hpp>
+
+// boost
+#include <boost/unordered_map.hpp>
+
+// stl
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mapnik {
+
+/*
+ * Join values and properties of the features burnt into a hit grid.
+ *
+ * By default pixels hold feature ids and keys are kept in maps. In
+ * compact mode pixels hold dense ids allocated per join value, and the
+ * key and properties of id n are stored at index n of plain arrays
+ * (0 is the empty key). Readers go through find_key() and
+ * find_properties(), which work the same in both modes and never
+ * modify the store.
+ */
+template <typename T>
+class hit_grid_keys
+{
+public:
+    typedef T value_type;
+    typedef std::string lookup_type;
+    // mapping between pixel id and key
+    typedef std::map<value_type, lookup_type> feature_key_type;
+    typedef std::map<lookup_type, value_type> key_type;
+    typedef std::map<std::string, mapnik::value> feature_properties_type;
+    // note: feature_type is not the same as a mapnik::Feature as it lacks a geometry
+    typedef std::map<std::string, feature_properties_type > feature_type;
+
+    hit_grid_keys()
+        : compact_(false),
+          id_keys_(1),
+          id_features_(1)
+    {
+        // this only works if each datasource's
+        // feature count starts at 1
+        f_keys_[0] = "";
+    }
+
+    inline bool compact() const
+    {
+        return compact_;
+    }
+
+    inline void set_compact(bool compact)
+    {
+        compact_ = compact;
+    }
+
+    // key burnt in as id, 0 if there is none
+    lookup_type const* find_key(value_type id) const
+    {
+        if (compact_)
+        {
+            std::size_t pos = static_cast<std::size_t>(id);
+            return pos < id_keys_.size() ? &id_keys_[pos] : 0;
+        }
+        typename feature_key_type::const_iterator itr = f_keys_.find(id);
+        return itr != f_keys_.end() ? &itr->second : 0;
+    }
+
+    // every id with a key is below this
+    std::size_t id_bound() const
+    {
+        if (compact_) return id_keys_.size();
+        // feature_key_type is ordered so the last id bounds the ids
+        return f_keys_.empty() ? 0 : static_cast<std::size_t>(f_keys_.rbegin()->first) + 1;
+    }
+
+    // stored properties of key, 0 if there are none
+    feature_properties_type const* find_properties(lookup_type const& key) const
+    {
+        if (compact_)
+        {
+            typename id_map::const_iterator itr = key_ids_.find(key);
+            return itr != key_ids_.end() ? &id_features_[itr->second] : 0;
+        }
+        typename feature_type::const_iterator itr = features_.find(key);
+        return itr != features_.end() ? &itr->second : 0;
+    }
+
+    // compact mode: id of key, 0 if it has none yet
+    value_type find_id(lookup_type const& key) const
+    {
+        typename id_map::const_iterator itr = key_ids_.find(key);
+        return itr != key_ids_.end() ? itr->second : 0;
+    }
+
+    // compact mode: the id the next key gets, 0 once value_type is exhausted
+    value_type next_id() const
+    {
+        return static_cast<value_type>(id_keys_.size());
+    }
+
+    // compact mode: gives key the next id and returns its
+    // (empty) properties
+    feature_properties_type & add_compact_key(lookup_type const& key)
+    {
+        key_ids_.insert(std::make_pair(key, next_id()));
+        id_keys_.push_back(key);
+        id_features_.push_back(feature_properties_type());
+        return id_features_.back();
+    }
+
+    // default mode tables, empty in compact mode
+    inline feature_key_type const& feature_keys() const
+    {
+        return f_keys_;
+    }
+
+    inline feature_key_type & feature_keys()
+    {
+        return f_keys_;
+    }
+
+    inline feature_type const& features() const
+    {
+        return features_;
+    }
+
+    inline feature_type & features()
+    {
+        return features_;
+    }
+
+private:
+    typedef boost::unordered_map<lookup_type, value_type> id_map;
+
+    bool compact_;
+    feature_key_type f_keys_;
+    feature_type features_;
+    id_map key_ids_;
+    std::vector<lookup_type> id_keys_;
+    std::vector<feature_properties_type> id_features_;
+};
+
+}
+
+#endif // MAPNIK_GRID_KEYS_HPP
@@ -31,6 +31,25 @@ namespace mapnik {
 
 struct grid_rasterizer :  agg::rasterizer_scanline_aa<>, boost::noncopyable {};
 
+// agg::render_scanlines that also tells whether any pixel was written,
+// so features which end up outside the grid are not added to it
+template <typename Rasterizer, typename Scanline, typename Renderer>
+bool render_id_scanlines(Rasterizer & ras, Scanline & sl, Renderer & ren)
+{
+    bool drawn = false;
+    if (ras.rewind_scanlines())
+    {
+        sl.reset(ras.min_x(), ras.max_x());
+        ren.prepare();
+        while (ras.sweep_scanline(sl))
+        {
+            ren.render(sl);
+            drawn = true;
+        }
+    }
+    return drawn;
+}
+
 }
 
 #endif //MAPNIK_AGG_RASTERIZER_HPP
@@ -32,9 +32,11 @@
 #include <mapnik/label_collision_detector.hpp>
 #include <mapnik/placement_finder.hpp>
 #include <mapnik/map.hpp>
+#include <mapnik/request.hpp>
 //#include <mapnik/marker.hpp>
 
 #include <mapnik/grid/grid.hpp>
+#include <mapnik/building_extrusion.hpp>
 
 // boost
 #include <boost/utility.hpp>
@@ -61,6 +63,8 @@ class MAPNIK_DECL grid_renderer : public feature_style_processor<grid_renderer<T
      
 public:
     grid_renderer(Map const& m, T & pixmap, double scale_factor=1.0, unsigned offset_x=0, unsigned offset_y=0);
+    // renders m with the size and extent of req, m may be shared between threads
+    grid_renderer(Map const& m, request const& req, T & pixmap, double scale_factor=1.0, unsigned offset_x=0, unsigned offset_y=0);
     ~grid_renderer();
     void start_map_processing(Map const& map);
     void end_map_processing(Map const& map);
@@ -119,6 +123,8 @@ private:
     face_manager<freetype_engine> font_manager_;
     label_collision_detector4 detector_;
     boost::scoped_ptr<grid_rasterizer> ras_ptr;
+    // reused between building_symbolizer features
+    building_faces wall_faces_;
 };
 }
 
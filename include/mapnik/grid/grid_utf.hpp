@@ -0,0 +1,344 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_GRID_UTF_HPP
+#define MAPNIK_GRID_UTF_HPP
+
+// mapnik
+#include <mapnik/grid/grid.hpp>
+#include <mapnik/grid/grid_view.hpp>
+#include <mapnik/value.hpp>
+
+// boost
+#include <boost/variant.hpp>
+#include <boost/cstdint.hpp>
+
+// stl
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+
+namespace mapnik {
+
+/*
+ * Native UTFGrid encoding
+ *
+ * Produces the same document as the python 'utf' encoder:
+ *
+ *   {"grid":[<rows>],"keys":[<keys>],"data":{<key>:{<props>}}}
+ *
+ * Pixel ids are remapped once per distinct id into a dense table
+ * so the per-pixel work is a single array lookup.
+ */
+
+namespace grid_utf {
+
+// append a JSON string literal (with quotes) to out
+inline void escape_json(std::string const& in, std::string & out)
+{
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (std::string::const_iterator itr = in.begin(); itr != in.end(); ++itr)
+    {
+        unsigned char c = static_cast<unsigned char>(*itr);
+        switch (c)
+        {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b";  break;
+        case '\f': out += "\\f";  break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (c < 0x20)
+            {
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xf];
+            }
+            else
+            {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+// append the utf8 encoding of codepoint to out
+inline void append_utf8(boost::uint32_t cp, std::string & out)
+{
+    if (cp < 0x80)
+    {
+        out += static_cast<char>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        out += static_cast<char>(0xc0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    else if (cp < 0x10000)
+    {
+        out += static_cast<char>(0xe0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    else
+    {
+        out += static_cast<char>(0xf0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+}
+
+// key index -> codepoint, skipping '"' and '\' which
+// cannot be encoded directly in JSON
+inline boost::uint32_t key_to_codepoint(unsigned idx)
+{
+    boost::uint32_t cp = 32 + idx;
+    if (cp >= 34) ++cp;
+    if (cp >= 92) ++cp;
+    return cp;
+}
+
+struct json_value_writer : public boost::static_visitor<>
+{
+    explicit json_value_writer(std::string & out)
+        : out_(out) {}
+
+    void operator() (value_null const&) const
+    {
+        out_ += "null";
+    }
+
+    void operator() (bool val) const
+    {
+        out_ += val ? "true" : "false";
+    }
+
+    void operator() (int val) const
+    {
+        std::ostringstream s;
+        s << val;
+        out_ += s.str();
+    }
+
+    void operator() (double val) const
+    {
+        std::ostringstream s;
+        s << std::setprecision(16) << val;
+        out_ += s.str();
+    }
+
+    void operator() (UnicodeString const& val) const
+    {
+        std::string utf8;
+        to_utf8(val,utf8);
+        escape_json(utf8,out_);
+    }
+
+    std::string & out_;
+};
+
+/*
+ * Maps pixel ids to dense key indices in order of first appearance.
+ * Ids which share a join value share an index.
+ */
+template <typename T>
+class key_remapper
+{
+public:
+    typedef typename T::value_type value_type;
+    typedef typename T::lookup_type lookup_type;
+    typedef typename T::keys_type keys_type;
+
+    explicit key_remapper(keys_type const& keys)
+        : grid_keys_(keys),
+          table_(keys.id_bound(), -1) {}
+
+    inline unsigned operator() (value_type id)
+    {
+        std::size_t pos = static_cast<std::size_t>(id);
+        if (pos < table_.size())
+        {
+            int idx = table_[pos];
+            if (idx >= 0) return static_cast<unsigned>(idx);
+            idx = static_cast<int>(resolve(id));
+            table_[pos] = idx;
+            return static_cast<unsigned>(idx);
+        }
+        // ids without a known key fall back to the empty key
+        return resolve_key(lookup_type());
+    }
+
+    std::vector<lookup_type> const& key_order() const
+    {
+        return key_order_;
+    }
+
+private:
+    unsigned resolve(value_type id)
+    {
+        lookup_type const* key = grid_keys_.find_key(id);
+        return resolve_key(key ? *key : lookup_type());
+    }
+
+    unsigned resolve_key(lookup_type const& key)
+    {
+        typename std::map<lookup_type,unsigned>::const_iterator itr = keys_.find(key);
+        if (itr != keys_.end())
+        {
+            return itr->second;
+        }
+        unsigned idx = key_order_.size();
+        keys_.insert(std::make_pair(key,idx));
+        key_order_.push_back(key);
+        return idx;
+    }
+
+    keys_type const& grid_keys_;
+    std::vector<int> table_;
+    std::map<lookup_type,unsigned> keys_;
+    std::vector<lookup_type> key_order_;
+};
+
+}
+
+/*
+ * Append the "grid" rows of a UTFGrid to out and fill key_order
+ * with the join values in codepoint order.
+ */
+template <typename T>
+void grid_to_utf_rows(T const& grid_type,
+    std::string & out,
+    std::vector<typename T::lookup_type> & key_order,
+    unsigned int resolution)
+{
+    if (resolution == 0) resolution = 1;
+    grid_utf::key_remapper<T> remap(grid_type.keys());
+
+    unsigned width = grid_type.width() / resolution;
+    out.reserve(out.size() + (width + 3) * (grid_type.height() / resolution + 1) + 2);
+    out += '[';
+    for (unsigned y = 0; y < grid_type.height(); y += resolution)
+    {
+        if (y > 0) out += ',';
+        out += '"';
+        typename T::value_type const* row = grid_type.getRow(y);
+        for (unsigned x = 0; x < width; ++x)
+        {
+            unsigned idx = remap(row[x * resolution]);
+            boost::uint32_t cp = grid_utf::key_to_codepoint(idx);
+            if (cp < 0x80) out += static_cast<char>(cp);
+            else grid_utf::append_utf8(cp, out);
+        }
+        out += '"';
+    }
+    out += ']';
+    key_order = remap.key_order();
+}
+
+/*
+ * Append the UTFGrid JSON document for grid_type to out.
+ * When add_features is set, properties listed in fields are written
+ * for every key visible in the grid; the join key itself is only
+ * written if it is part of fields.
+ */
+template <typename T>
+void grid_to_utf_json(T const& grid_type,
+    std::string & out,
+    bool add_features,
+    unsigned int resolution,
+    std::set<std::string> const& fields)
+{
+    typedef typename T::lookup_type lookup_type;
+    typedef typename T::feature_properties_type feature_properties_type;
+
+    std::vector<lookup_type> key_order;
+    out += "{\"grid\":";
+    grid_to_utf_rows(grid_type, out, key_order, resolution);
+
+    out += ",\"keys\":[";
+    for (std::size_t i = 0; i < key_order.size(); ++i)
+    {
+        if (i > 0) out += ',';
+        grid_utf::escape_json(key_order[i], out);
+    }
+    out += "],\"data\":{";
+
+    if (add_features && !fields.empty())
+    {
+        std::string const& key = grid_type.get_key();
+        bool include_key = (fields.find(key) != fields.end());
+        grid_utf::json_value_writer writer(out);
+        bool first_feature = true;
+        for (std::size_t i = 0; i < key_order.size(); ++i)
+        {
+            feature_properties_type const* fprops = grid_type.keys().find_properties(key_order[i]);
+            if (!fprops) continue;
+            feature_properties_type const& props = *fprops;
+            bool first_prop = true;
+            typename feature_properties_type::const_iterator itr = props.begin();
+            typename feature_properties_type::const_iterator end = props.end();
+            for (; itr != end; ++itr)
+            {
+                if (itr->first == key ? !include_key : fields.find(itr->first) == fields.end())
+                    continue;
+                if (first_prop)
+                {
+                    if (!first_feature) out += ',';
+                    grid_utf::escape_json(key_order[i], out);
+                    out += ":{";
+                    first_feature = false;
+                    first_prop = false;
+                }
+                else
+                {
+                    out += ',';
+                }
+                grid_utf::escape_json(itr->first, out);
+                out += ':';
+                boost::apply_visitor(writer, itr->second.base());
+            }
+            if (!first_prop) out += '}';
+        }
+    }
+    out += "}}";
+}
+
+template <typename T>
+void grid_to_utf_json(T const& grid_type,
+    std::string & out,
+    bool add_features,
+    unsigned int resolution)
+{
+    grid_to_utf_json(grid_type, out, add_features, resolution, grid_type.property_names());
+}
+
+}
+
+#endif // MAPNIK_GRID_UTF_HPP
@@ -29,6 +29,7 @@
 #include <mapnik/box2d.hpp>
 #include <mapnik/global.hpp>
 #include <mapnik/value.hpp>
+#include <mapnik/grid/grid_keys.hpp>
 
 // stl
 #include <map>
@@ -47,11 +48,12 @@ class hit_grid_view
 public:
     typedef T data_type;
     typedef typename T::pixel_type value_type;
-    typedef std::string lookup_type;
-    typedef std::map<value_type, lookup_type> feature_key_type;
-    typedef std::map<lookup_type, value_type> key_type;
-    typedef std::map<std::string, mapnik::value> feature_properties_type;
-    typedef std::map<std::string, feature_properties_type > feature_type;
+    typedef hit_grid_keys<value_type> keys_type;
+    typedef typename keys_type::lookup_type lookup_type;
+    typedef typename keys_type::feature_key_type feature_key_type;
+    typedef typename keys_type::key_type key_type;
+    typedef typename keys_type::feature_properties_type feature_properties_type;
+    typedef typename keys_type::feature_type feature_type;
           
     hit_grid_view(unsigned x, unsigned y, 
               unsigned width, unsigned height,
@@ -59,8 +61,7 @@ public:
               std::string const& key,
               unsigned resolution,
               std::set<std::string> const& names,
-              feature_key_type const& f_keys,
-              feature_type const& features
+              keys_type const& keys
               )
         : x_(x),
           y_(y),
@@ -70,8 +71,7 @@ public:
           key_(key),
           resolution_(resolution),
           names_(names),
-          f_keys_(f_keys),
-          features_(features)
+          keys_(keys)
           
     {
         if (x_ >= data_.width()) x_=data_.width()-1;
@@ -91,8 +91,7 @@ public:
           key_(rhs.key_),
           resolution_(rhs.resolution_),
           names_(rhs.names_),
-          f_keys_(rhs.f_keys_),
-          features_(rhs.features_)
+          keys_(rhs.keys_)
           {}
         
     hit_grid_view<T> & operator=(hit_grid_view<T> const& rhs)
@@ -106,8 +105,7 @@ public:
         key_ = rhs.key_;
         resolution_ = rhs.resolution_;
         names_ = rhs.names_;
-        f_keys_ = rhs.f_keys_;
-        features_ = rhs.features_;
+        keys_ = rhs.keys_;
     }
         
     inline unsigned x() const
@@ -155,14 +153,21 @@ public:
         return names_;
     }
 
+    // keys and properties in either mode
+    inline const keys_type& keys() const
+    {
+        return keys_;
+    }
+
+    // default mode tables, empty in compact mode (use keys())
     inline const feature_type& get_grid_features() const
     {
-        return features_;
+        return keys_.features();
     }
 
     inline const feature_key_type& get_feature_keys() const
     {
-        return f_keys_;
+        return keys_.feature_keys();
     }
 
     inline const lookup_type& get_key() const
@@ -184,8 +189,7 @@ private:
     std::string const& key_;
     unsigned int resolution_;
     std::set<std::string> const& names_;
-    feature_key_type const& f_keys_;
-    feature_type const& features_;
+    keys_type const& keys_;
 };
 
 typedef hit_grid_view<mapnik::ImageData<uint16_t> > grid_view;
@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_HIT_TEST_INDEX_HPP
+#define MAPNIK_HIT_TEST_INDEX_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/datasource.hpp>
+#include <mapnik/quad_tree.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
+
+// stl
+#include <vector>
+
+namespace mapnik {
+
+/*!
+ * @brief In-memory envelope index over all features of a vector datasource.
+ *
+ * Built once (reading every feature with all attributes) and then queried
+ * read-only, so a single index can serve concurrent point queries.
+ */
+class MAPNIK_DECL hit_test_index : private boost::noncopyable
+{
+public:
+    explicit hit_test_index(datasource_ptr const& ds);
+    ~hit_test_index();
+
+    /*!
+     * @brief Append copies of the features whose geometry is hit at x,y
+     *        (within tol) to result, in datasource order.
+     *
+     * The indexed features themselves are never handed out, so callers
+     * may modify what they get back.
+     */
+    void query(double x, double y, double tol, std::vector<feature_ptr> & result) const;
+
+    std::size_t size() const;
+
+private:
+    std::vector<feature_ptr> features_;
+    std::vector<box2d<double> > envelopes_;
+    boost::scoped_ptr<quad_tree<unsigned> > tree_;
+};
+
+typedef boost::shared_ptr<hit_test_index const> hit_test_index_ptr;
+
+/*!
+ * @brief Lazily built hit_test_index of one datasource.
+ *
+ * Each cache has its own lock, so building the index of one layer
+ * does not hold up queries or index builds of other layers.
+ */
+class MAPNIK_DECL hit_test_index_cache : private boost::noncopyable
+{
+public:
+    hit_test_index_cache();
+    ~hit_test_index_cache();
+
+    /*!
+     * @brief The index of ds, built on the first call after construction
+     *        or reset().
+     */
+    hit_test_index_ptr get(datasource_ptr const& ds);
+
+    /*!
+     * @brief Drop the index so the next get() rebuilds it, for
+     *        datasources whose features change.
+     */
+    void reset();
+
+private:
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex mutex_;
+#endif
+    hit_test_index_ptr index_;
+};
+
+}
+
+#endif // MAPNIK_HIT_TEST_INDEX_HPP
@@ -26,6 +26,7 @@
 // mapnik
 #include <mapnik/feature.hpp>
 #include <mapnik/datasource.hpp>
+#include <mapnik/hit_test_index.hpp>
 
 // stl
 #include <vector>
@@ -196,6 +197,24 @@ public:
      * @return the geographic envelope/bounding box of the data in the layer.
      */
     box2d<double> envelope() const;
+
+    /*!
+     * @brief Envelope index over this layer's features for point queries.
+     *
+     * Built on first use by reading the whole datasource and shared by
+     * copies of the layer until set_datasource() or reset_hit_index()
+     * is called.
+     *
+     * @return the index, or an empty pointer for raster or missing datasources.
+     */
+    hit_test_index_ptr hit_index() const;
+
+    /*!
+     * @brief Drop the point query index, the next query rebuilds it.
+     *
+     * Needed after the features of the datasource changed.
+     */
+    void reset_hit_index();
         
     ~layer();
 private:
@@ -214,6 +233,7 @@ private:
     bool cache_features_;
     std::vector<std::string>  styles_;
     datasource_ptr ds_;
+    boost::shared_ptr<hit_test_index_cache> hit_index_;
 };
 }
 
@@ -416,6 +416,30 @@ public:
      */
     featureset_ptr query_map_point(unsigned index, double x, double y) const;
 
+    /*!
+     * @brief Query a Map layer (by layer index) for features
+     *        at many locations at once.
+     *
+     * The layer's features are indexed by envelope on first use
+     * (see layer::hit_index()) and the index is reused by later calls.
+     *
+     * @param index The index of the layer to query from.
+     * @param points The x,y locations in the coordinates of map projection.
+     * @param result Receives one list of matching features per point.
+     */
+    void query_points(unsigned index, std::vector<coord2d> const& points,
+                      std::vector<std::vector<feature_ptr> > & result) const;
+
+    /*!
+     * @brief Query a Map layer (by layer index) for features
+     *        at many locations at once.
+     *
+     * As query_points() but with x,y locations in the coordinates
+     * of the pixmap or map surface.
+     */
+    void query_map_points(unsigned index, std::vector<coord2d> const& points,
+                          std::vector<std::vector<feature_ptr> > & result) const;
+
     /*!
      * @brief Resolve names to object references for metawriters.
      */
@@ -456,6 +480,9 @@ public:
 
 private:
     void fixAspectRatio();
+    void query_points_impl(unsigned index, std::vector<coord2d> const& points,
+                           std::vector<std::vector<feature_ptr> > & result,
+                           bool pixel_coords) const;
 };
    
 DEFINE_ENUM(aspect_fix_mode_e,Map::aspect_fix_mode);
@@ -39,30 +39,62 @@
 #include <boost/unordered_map.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/optional.hpp>
-#ifdef MAPNIK_THREADSAFE
-#include <boost/thread/mutex.hpp>
-#endif
+// stl
+#include <string>
+#include <cstddef>
 
 namespace mapnik
 {
 
 using namespace mapnik::svg;
 
+class Map;
+
 typedef boost::shared_ptr<marker> marker_ptr;
 
+struct marker_cache_stats
+{
+    marker_cache_stats()
+        : hits(0),
+          misses(0),
+          evictions(0),
+          entries(0),
+          bytes(0) {}
+
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t evictions;
+    std::size_t entries;
+    // estimated memory held by the cached markers
+    std::size_t bytes;
+};
 
+/*
+ * Markers by uri. The cache is split in shards, each with its own lock,
+ * so lookups from many threads rarely wait on each other, and files are
+ * loaded without holding any lock. Markers loaded from files are evicted
+ * least recently used first once max_bytes() is exceeded; markers added
+ * with insert() can not be reloaded and are never evicted, not even by
+ * clear().
+ */
 struct MAPNIK_DECL marker_cache :
         public singleton <marker_cache, CreateStatic>,
         private boost::noncopyable
 {
 
     friend class CreateStatic<marker_cache>;
-#ifdef MAPNIK_THREADSAFE
-    static boost::mutex mutex_;
-#endif
-    static boost::unordered_map<std::string,marker_ptr> cache_;
     static bool insert(std::string const& key, marker_ptr);
     static boost::optional<marker_ptr> find(std::string const& key, bool update_cache = false);
+
+    // 0 (the default) for no limit
+    static void set_max_bytes(std::size_t max_bytes);
+    static std::size_t max_bytes();
+    static marker_cache_stats stats();
+    static void clear();
+
+    // loads every marker map refers to by a constant file name,
+    // returns how many are cached
+    static unsigned preload(Map const& map);
 };
 
 }
@@ -30,9 +30,12 @@
 // boost
 #include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #ifdef MAPNIK_THREADSAFE
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
 #endif
 
 // stl
@@ -65,79 +68,237 @@ private:
     PoolGuard& operator=(const PoolGuard&);
 };
 
+struct pool_stats
+{
+    pool_stats()
+        : borrowed(0),
+          waited(0),
+          timeouts(0),
+          created(0),
+          dropped(0),
+          borrow_time(0.0),
+          max_borrow_time(0.0) {}
+
+    unsigned long borrowed;  // successful borrowObject() calls
+    unsigned long waited;    // ... of which had to wait for a returned object
+    unsigned long timeouts;  // borrowObject() calls that found the pool exhausted
+    unsigned long created;
+    unsigned long dropped;   // objects failing isOK() or ping()
+    double borrow_time;      // seconds spent in successful borrowObject() calls
+    double max_borrow_time;
+};
+
+/*
+ * Objects are created on demand up to maxSize. When all of them are in use
+ * borrowObject() waits up to 'timeout' seconds for one to be returned
+ * (single threaded builds never wait). An idle object last used by the
+ * calling thread is preferred, otherwise the most recently returned one.
+ * Objects idle for 'ping_interval' seconds or more are checked with
+ * T::ping() before they are handed out, without holding the pool lock.
+ */
 template <typename T,template <typename> class Creator>
 class Pool : private boost::noncopyable
 {
     typedef boost::shared_ptr<T> HolderType;
     typedef std::deque<HolderType> ContType;    
+#ifdef MAPNIK_THREADSAFE
+    typedef boost::thread::id owner_type;
+#else
+    typedef int owner_type;
+#endif
+    struct idle_object
+    {
+        HolderType obj;
+        owner_type owner;
+        boost::posix_time::ptime since;
+    };
+    typedef std::deque<idle_object> IdleType;
         
     Creator<T> creator_;
     const unsigned initialSize_; 
     const unsigned maxSize_;
+    const double timeout_;
+    const double ping_interval_;
     ContType usedPool_;
-    ContType unusedPool_;
+    IdleType unusedPool_;
+    // objects being created outside of the lock
+    unsigned creating_;
+    pool_stats stats_;
 #ifdef MAPNIK_THREADSAFE
     mutable boost::mutex mutex_;
+    boost::condition_variable returned_;
+#endif
+
+    static boost::posix_time::ptime now()
+    {
+        return boost::posix_time::microsec_clock::universal_time();
+    }
+
+    static double seconds(boost::posix_time::time_duration const& d)
+    {
+        return d.total_microseconds() * 1e-6;
+    }
+
+    static owner_type current_owner()
+    {
+#ifdef MAPNIK_THREADSAFE
+        return boost::this_thread::get_id();
+#else
+        return owner_type();
 #endif
+    }
+
+    void add_idle(HolderType const& obj)
+    {
+        idle_object idle;
+        idle.obj = obj;
+        idle.owner = current_owner();
+        idle.since = now();
+        unusedPool_.push_back(idle);
+    }
+
+    void remove_used(HolderType const& obj)
+    {
+        typename ContType::iterator itr=usedPool_.begin();
+        for (; itr != usedPool_.end(); ++itr)
+        {
+            if (itr->get() == obj.get())
+            {
+                usedPool_.erase(itr);
+                return;
+            }
+        }
+    }
+
+    void borrowed(boost::posix_time::ptime const& start, bool waited)
+    {
+        double t = seconds(now() - start);
+        ++stats_.borrowed;
+        if (waited) ++stats_.waited;
+        stats_.borrow_time += t;
+        if (t > stats_.max_borrow_time) stats_.max_borrow_time = t;
+    }
+
 public:
 
-    Pool(const Creator<T>& creator,unsigned initialSize=1, unsigned maxSize=10)
+    Pool(const Creator<T>& creator,unsigned initialSize=1, unsigned maxSize=10,
+         double timeout=0.0, double ping_interval=0.0)
         :creator_(creator),
          initialSize_(initialSize),
-         maxSize_(maxSize)
+         maxSize_(maxSize),
+         timeout_(timeout),
+         ping_interval_(ping_interval),
+         creating_(0)
     {
         for (unsigned i=0; i < initialSize_; ++i) 
         {
             HolderType conn(creator_());
+            ++stats_.created;
             if (conn->isOK())
-                unusedPool_.push_back(conn);
+                add_idle(conn);
         }
     }
 
     HolderType borrowObject()
     {   
+        boost::posix_time::ptime start = now();
+        bool waited = false;
 #ifdef MAPNIK_THREADSAFE    
-        mutex::scoped_lock lock(mutex_);
-#endif
-        typename ContType::iterator itr=unusedPool_.begin();
-        if (itr!=unusedPool_.end())
-        { 
-#ifdef MAPNIK_DEBUG
-            std::clog<<"borrow "<<(*itr).get()<<"\n";
+        boost::posix_time::ptime deadline = start + boost::posix_time::microseconds(long(timeout_ * 1e6));
+        boost::mutex::scoped_lock lock(mutex_);
 #endif
-            if ((*itr)->isOK())
+        for (;;)
+        {
+            if (!unusedPool_.empty())
             {
-                usedPool_.push_back(*itr);
+                typename IdleType::iterator itr=unusedPool_.end() - 1;
+                owner_type owner = current_owner();
+                for (typename IdleType::iterator i=unusedPool_.begin(); i != unusedPool_.end(); ++i)
+                {
+                    if (i->owner == owner) itr = i;
+                }
+                idle_object idle = *itr;
                 unusedPool_.erase(itr);
-                return usedPool_[usedPool_.size()-1];
-            }
-            else
-            {
+                usedPool_.push_back(idle.obj);
 #ifdef MAPNIK_DEBUG
-                std::clog<<"bad connection (erase)" << (*itr).get()<<"\n";
+                std::clog<<"borrow "<<idle.obj.get()<<"\n";
+#endif
+                bool ok = idle.obj->isOK();
+                if (ok && ping_interval_ > 0 && seconds(start - idle.since) >= ping_interval_)
+                {
+#ifdef MAPNIK_THREADSAFE
+                    lock.unlock();
+#endif
+                    ok = idle.obj->ping();
+#ifdef MAPNIK_THREADSAFE
+                    lock.lock();
+#endif
+                }
+                if (ok)
+                {
+                    borrowed(start, waited);
+                    return idle.obj;
+                }
+#ifdef MAPNIK_DEBUG
+                std::clog<<"bad connection (erase)" << idle.obj.get()<<"\n";
 #endif 
-                unusedPool_.erase(itr);
+                remove_used(idle.obj);
+                ++stats_.dropped;
+                continue;
             }
-        }
-        if (unusedPool_.size() < maxSize_)
-        {
-            HolderType conn(creator_());
-            if (conn->isOK())
+            if (usedPool_.size() + creating_ < maxSize_)
             {
-                usedPool_.push_back(conn);
+                ++creating_;
+                HolderType conn;
+                try
+                {
+#ifdef MAPNIK_THREADSAFE
+                    lock.unlock();
+#endif
+                    conn.reset(creator_());
+#ifdef MAPNIK_THREADSAFE
+                    lock.lock();
+#endif
+                }
+                catch (...)
+                {
+#ifdef MAPNIK_THREADSAFE
+                    if (!lock.owns_lock()) lock.lock();
+                    returned_.notify_one();
+#endif
+                    --creating_;
+                    throw;
+                }
+                --creating_;
+                ++stats_.created;
+                if (conn->isOK())
+                {
+                    usedPool_.push_back(conn);
 #ifdef MAPNIK_DEBUG
-                std::clog << "create << " << conn.get() << "\n";
+                    std::clog << "create << " << conn.get() << "\n";
 #endif
-                return conn;
+                    borrowed(start, waited);
+                    return conn;
+                }
+                ++stats_.dropped;
+            }
+#ifdef MAPNIK_THREADSAFE
+            if (now() < deadline)
+            {
+                waited = true;
+                returned_.timed_wait(lock, deadline);
+                continue;
             }
+#endif
+            ++stats_.timeouts;
+            return HolderType();
         }
-        return HolderType();
     } 
 
     void returnObject(HolderType obj)
     {
 #ifdef MAPNIK_THREADSAFE
-        mutex::scoped_lock lock(mutex_);
+        boost::mutex::scoped_lock lock(mutex_);
 #endif
         typename ContType::iterator itr=usedPool_.begin();
         while (itr != usedPool_.end())
@@ -147,8 +308,18 @@ public:
 #ifdef MAPNIK_DEBUG
                 std::clog<<"return "<<(*itr).get()<<"\n";
 #endif
-                unusedPool_.push_back(*itr);
+                if (obj->isOK())
+                {
+                    add_idle(obj);
+                }
+                else
+                {
+                    ++stats_.dropped;
+                }
                 usedPool_.erase(itr);
+#ifdef MAPNIK_THREADSAFE
+                returned_.notify_one();
+#endif
                 return;
             }
             ++itr;
@@ -158,11 +329,19 @@ public:
     std::pair<unsigned,unsigned> size() const
     {
 #ifdef MAPNIK_THREADSAFE
-        mutex::scoped_lock lock(mutex_);
+        boost::mutex::scoped_lock lock(mutex_);
 #endif
         std::pair<unsigned,unsigned> size(unusedPool_.size(),usedPool_.size());
         return size;
     }
+
+    pool_stats stats() const
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        return stats_;
+    }
 };
 }
 #endif //POOL_HPP
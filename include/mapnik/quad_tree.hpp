@@ -123,6 +123,13 @@ public:
     {
         return query_result_.end();
     }
+
+    // re-entrant variant: results go to the caller's container
+    // so a built tree can be shared between threads
+    void query_in_box(box2d<double> const& box, std::vector<T> & result) const
+    {
+        query_node(box,result,root_);
+    }
         
     const_iterator begin() const
     {
@@ -172,6 +179,22 @@ private:
         }
     }
         
+    void query_node(box2d<double> const& box, std::vector<T> & result, node const* node_) const
+    {
+        if (node_)
+        {
+            box2d<double> const& node_extent = node_->extent();
+            if (box.intersects(node_extent))
+            {
+                result.insert(result.end(),node_->begin(),node_->end());
+                for (int k = 0; k < 4; ++k)
+                {
+                    query_node(box,result,node_->children_[k]);
+                }
+            }
+        }
+    }
+        
     void do_insert_data(T data, box2d<double> const& box, node * n, unsigned int& depth)
     {
         if (++depth >= max_depth_)
@@ -0,0 +1,162 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef MAPNIK_RENDER_STATS_HPP
+#define MAPNIK_RENDER_STATS_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/rule.hpp>
+// stl
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mapnik
+{
+
+/*
+ * Counters and timings of a single render, broken down by layer and by
+ * style. Attach one to a renderer with set_stats() before apply(); while
+ * none is attached nothing is measured and no clock is read. Times are
+ * wall clock milliseconds, totals of a layer are the sums over its styles.
+ */
+class MAPNIK_DECL render_stats
+{
+public:
+    struct symbolizer_stats
+    {
+        symbolizer_stats()
+            : count(0),
+              time(0.0) {}
+        unsigned count; // features processed
+        double time;
+    };
+
+    typedef std::map<std::string, symbolizer_stats> symbolizer_map;
+
+    struct counters
+    {
+        counters()
+            : query_time(0.0),
+              features_fetched(0),
+              features_matched(0),
+              label_attempts(0),
+              label_successes(0),
+              bytes_decoded(0) {}
+        // time spent in the datasource (features() and next())
+        double query_time;
+        unsigned features_fetched;
+        // features passing at least one rule filter, else rules included
+        unsigned features_matched;
+        unsigned label_attempts;
+        unsigned label_successes;
+        // size of the raster data of the features fetched
+        unsigned long bytes_decoded;
+        // by symbolizer type: "polygon", "line", "text", ...
+        symbolizer_map symbolizers;
+
+        void add(counters const& other);
+    };
+
+    struct style_stats : counters
+    {
+        std::string name;
+        double time;
+    };
+
+    struct layer_stats : counters
+    {
+        std::string name;
+        double time;
+        std::vector<style_stats> styles;
+    };
+
+    render_stats();
+
+    void clear();
+    std::vector<layer_stats> const& layers() const;
+    // wall clock time of the whole render
+    double time() const;
+
+    // milliseconds from an arbitrary origin, for measuring intervals
+    static double now();
+    // "polygon", "line", ... the names used by the python bindings
+    static std::string const& symbolizer_name(symbolizer const& sym);
+
+    /* recording, called by the renderers */
+    void start_map();
+    void end_map();
+    void start_layer(std::string const& name);
+    void end_layer();
+    void start_style(std::string const& name);
+    void end_style();
+
+    // counters of the style being rendered
+    counters & current()
+    {
+        return current_;
+    }
+
+    void add_symbolizer_time(symbolizer const& sym, double time)
+    {
+        unsigned type = sym.which();
+        if (type >= by_type_.size()) by_type_.resize(type + 1);
+        symbolizer_timing & t = by_type_[type];
+        if (!t.name) t.name = &symbolizer_name(sym);
+        ++t.stats.count;
+        t.stats.time += time;
+    }
+
+    void add_label_attempt(bool success)
+    {
+        ++current_.label_attempts;
+        if (success) ++current_.label_successes;
+    }
+
+private:
+    struct symbolizer_timing
+    {
+        symbolizer_timing()
+            : name(0) {}
+        symbolizer_stats stats;
+        std::string const* name;
+    };
+
+    std::vector<layer_stats> layers_;
+    counters current_;
+    // symbolizer timings of the current style, by symbolizer::which(),
+    // so no name is looked up per feature
+    std::vector<symbolizer_timing> by_type_;
+    double time_;
+    double map_start_;
+    double layer_start_;
+    double style_start_;
+    std::string style_name_;
+    bool in_style_;
+};
+
+}
+
+#endif // MAPNIK_RENDER_STATS_HPP
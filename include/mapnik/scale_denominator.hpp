@@ -30,6 +30,8 @@ namespace mapnik {
  
 class Map;
 MAPNIK_DECL double scale_denominator(Map const& map, bool geographic);
+// for a map scale in map units per pixel
+MAPNIK_DECL double scale_denominator(double map_scale, bool geographic);
 }
 
 #endif // MAPNIK_SCALE_DENOMINATOR_HPP
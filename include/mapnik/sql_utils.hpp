@@ -28,6 +28,8 @@
 // boost
 #include <boost/algorithm/string.hpp>
 #include <boost/scoped_array.hpp>
+// stl
+#include <cmath>
 
 namespace mapnik
 {
@@ -187,6 +189,29 @@ inline std::string numeric2string(const char* buf)
    return ss.str();
 }
 
+// binary numeric straight to double, false for NaN
+inline bool numeric2double(const char* buf, double & val)
+{
+   int16_t ndigits = int2net(buf);
+   int16_t weight  = int2net(buf+2);
+   int16_t sign    = int2net(buf+4);
+   if (sign == int16_t(0xC000)) return false;
+
+   // base 10000 digits, the first one weighs 10000^weight
+   double v = 0;
+   for (int n=0; n < ndigits ;++n)
+   {
+      v = v * 10000 + int2net(buf+8+n*2);
+   }
+   int exponent = weight - ndigits + 1;
+   if (exponent > 0)
+      v *= std::pow(10000.0, exponent);
+   else if (exponent < 0)
+      v /= std::pow(10000.0, -exponent);
+   val = (sign == 0x4000) ? -v : v;
+   return true;
+}
+
 }
 
 #endif //SQL_UTILS_HPP
@@ -40,6 +40,11 @@ namespace mapnik { namespace svg {
      * A method to generate each kind of SVG tag is provided. The information needed
      * needed to generate the attributes of a tag is passed within a *_output_attributes
      * structure.
+     *
+     * The grammars are built once per generator and reused for every tag.
+     * Consecutive unfilled paths sharing the same attributes are written
+     * as the sub-paths of a single path element, which is kept open until
+     * a path with different attributes, a rect or flush() closes it.
      */
     template <typename OutputIterator>
     class svg_generator : private boost::noncopyable
@@ -61,9 +66,26 @@ namespace mapnik { namespace svg {
         void generate_closing_root();
         void generate_rect(rect_output_attributes const& rect_attributes);
         void generate_path(path_type const& path, path_output_attributes const& path_attributes);
+
+        /*!
+         * @brief Closes the pending path element, if any.
+         */
+        void flush();
+
+        /*!
+         * @brief Maximum number of fractional digits of path coordinates (default 3).
+         */
+        void set_coordinate_precision(unsigned precision);
+        unsigned coordinate_precision() const;
   
     private:
         OutputIterator& output_iterator_;
+        unsigned coordinate_precision_;
+        path_data_grammar data_grammar_;
+        path_attributes_grammar attributes_grammar_;
+        path_dash_array_grammar dash_array_grammar_;
+        bool path_open_;
+        path_output_attributes open_path_attributes_;
     };
 }}
 
@@ -79,6 +79,8 @@ namespace mapnik { namespace svg {
         const std::string stroke_linejoin() const;
         const dash_array stroke_dasharray() const;
         const double stroke_dashoffset() const;
+
+        bool operator==(path_output_attributes const& other) const;
       
         /*!
          * @brief Set members back to their default values.
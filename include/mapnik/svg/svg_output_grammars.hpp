@@ -132,38 +132,78 @@ namespace mapnik { namespace svg {
     using namespace boost::spirit;
     using namespace boost::phoenix;
 
+    /*!
+     * Karma real policy used for path coordinates: always fixed notation,
+     * at most *precision_ fractional digits and no trailing zeros (nor a
+     * lone dot). The precision is read through a pointer so that a grammar
+     * built once follows later changes made by its owner.
+     */
+    struct coordinate_policy : karma::real_policies<double>
+    {
+        typedef karma::real_policies<double> base_type;
+
+        explicit coordinate_policy(unsigned const* precision = 0)
+            : precision_(precision) {}
+
+        static int floatfield(double)
+        {
+            return base_type::fmtflags::fixed;
+        }
+
+        unsigned precision(double) const
+        {
+            return precision_ ? *precision_ : 3;
+        }
+
+        template <typename OutputIterator>
+        static bool dot(OutputIterator& sink, double n, unsigned precision)
+        {
+            if (n == 0 || precision == 0) return true;
+            return base_type::dot(sink, n, precision);
+        }
+
+        template <typename OutputIterator>
+        static bool fraction_part(OutputIterator& sink, double n,
+                                  unsigned adjusted_precision, unsigned precision)
+        {
+            if (n == 0 || precision == 0) return true;
+            return base_type::fraction_part(sink, n, adjusted_precision, precision);
+        }
+
+        unsigned const* precision_;
+    };
+
+    /*!
+     * Generates the vertices of a path as SVG path data ("M x y L x y ..."),
+     * without the surrounding d="" so that several paths can be written
+     * into a single path element.
+     */
     template <typename OutputIterator, typename PathType>
-    struct svg_path_data_grammar : karma::grammar<OutputIterator, PathType&()>
+    struct svg_path_data_grammar : karma::grammar<OutputIterator, PathType()>
     {
         typedef path_iterator_type::value_type vertex_type;
 
-        explicit svg_path_data_grammar(PathType const& path_type)
+        explicit svg_path_data_grammar(unsigned const* precision)
         : svg_path_data_grammar::base_type(svg_path),
-          path_type_(path_type)
+          coordinate(coordinate_policy(precision))
         {
               using karma::int_;
-              using karma::double_;
-              using repository::confix;
-              
-              svg_path = 
-                  lit("d=") 
-                  << confix('"', '"')[
-                  -(path_vertex % lit(' '))];
-              
+
+              svg_path = -(path_vertex % lit(' '));
+
               path_vertex = 
                   path_vertex_command
-                  << double_
+                  << coordinate
                   << lit(' ')
-                  << double_;
+                  << coordinate;
               
               path_vertex_command = &int_(1) << lit('M') | lit('L');
         }
   
-        karma::rule<OutputIterator, PathType&()> svg_path;
+        karma::rule<OutputIterator, PathType()> svg_path;
         karma::rule<OutputIterator, vertex_type()> path_vertex;
         karma::rule<OutputIterator, int()> path_vertex_command;
-      
-        PathType const& path_type_;
+        karma::real_generator<double, coordinate_policy> coordinate;
     };
 
     template <typename OutputIterator>
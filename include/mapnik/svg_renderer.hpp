@@ -38,6 +38,8 @@ namespace mapnik
     // parameterized with the type of output iterator it will use for output.
     // output iterators add more flexibility than streams, because iterators
     // can target many other output destinations besides streams.
+    // std::back_insert_iterator<std::string> is instantiated as well, to
+    // render into a caller-provided buffer without going through a stream.
     template <typename OutputIterator>
     class MAPNIK_DECL svg_renderer : public feature_style_processor<svg_renderer<OutputIterator> >, 
              private boost::noncopyable
@@ -96,6 +98,19 @@ namespace mapnik
                Feature const& feature,
                proj_transform const& prj_trans);
         
+        /*!
+         * @brief Maximum number of fractional digits written for path coordinates.
+         */
+        void set_coordinate_precision(unsigned precision)
+        {
+            generator_.set_coordinate_precision(precision);
+        }
+
+        unsigned coordinate_precision() const
+        {
+            return generator_.coordinate_precision();
+        }
+
         inline OutputIterator& get_output_iterator() 
         {
             return output_iterator_;
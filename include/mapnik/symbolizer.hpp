@@ -43,7 +43,9 @@ class MAPNIK_DECL symbolizer_base {
             properties_(),
             properties_complete_(),
             writer_name_(),
-            writer_ptr_() {}
+            writer_ptr_(),
+            clip_(true),
+            simplify_tolerance_(0.0) {}
             
         /** Add a metawriter to this symbolizer.
           *
@@ -73,12 +75,21 @@ class MAPNIK_DECL symbolizer_base {
         metawriter_properties const& get_metawriter_properties_overrides() const {return properties_;}
         /** Get metawriter name. */
         std::string const& get_metawriter_name() const {return writer_name_;}
+        /** Clip geometries to the canvas before stroking or filling them.
+          * Only used by line and polygon symbolizers. */
+        void set_clip(bool clip) {clip_ = clip;}
+        bool get_clip() const {return clip_;}
+        /** Drop vertices closer than this many pixels to the previous one (0 disables).
+          * Only used by line and polygon symbolizers. */
+        void set_simplify_tolerance(double tolerance) {simplify_tolerance_ = tolerance;}
+        double get_simplify_tolerance() const {return simplify_tolerance_;}
     private:
         metawriter_properties properties_;
         metawriter_properties properties_complete_;
         std::string writer_name_;
         metawriter_ptr writer_ptr_;
-
+        bool clip_;
+        double simplify_tolerance_;
 };
 
 typedef boost::array<double,6> transform_type;
@@ -32,6 +32,9 @@
 // mapnik
 #include <mapnik/ptree_helpers.hpp>
 #include <mapnik/geom_util.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/wkb.hpp>
+#include <mapnik/feature_factory.hpp>
 
 // boost
 #include <boost/algorithm/string.hpp>
@@ -64,6 +67,10 @@ using mapnik::attribute_descriptor;
 using mapnik::datasource_exception;
 using mapnik::filter_in_box;
 using mapnik::filter_at_point;
+using mapnik::feature_ptr;
+using mapnik::feature_factory;
+using mapnik::geometry_utils;
+using mapnik::transcoder;
 
 
 void geos_notice(const char* fmt, ...)
@@ -129,6 +136,7 @@ geos_datasource::~geos_datasource()
 {
     if (is_bound_) 
     {
+        prepared_.set_geometry(0);
         geometry_.set_feature(0);
 
         finishGEOS();
@@ -221,6 +229,24 @@ void geos_datasource::bind() const
 
     if (! extent_initialized_)
         throw datasource_exception("GEOS Plugin: cannot determine extent for <wkt> geometry");
+
+    // the geometry never changes, so it is converted to WKB once
+    if (! GEOSisEmpty(*geometry_))
+    {
+        geos_wkb_ptr wkb(*geometry_);
+        if (wkb.is_valid())
+        {
+            wkb_ = boost::make_shared<std::string>(wkb.data(), wkb.size());
+
+            if (geometry_data_ != "")
+            {
+                transcoder tr(desc_.get_encoding());
+                geometry_data_value_ = tr.transcode(geometry_data_.c_str());
+            }
+        }
+
+        prepared_.set_geometry(GEOSPrepare(*geometry_));
+    }
    
     is_bound_ = true;
 }
@@ -249,51 +275,65 @@ layer_descriptor geos_datasource::get_descriptor() const
     return desc_;
 }
 
+featureset_ptr geos_datasource::features_intersecting(GEOSGeometry* shape) const
+{
+    geos_feature_ptr owner(shape);
+
+    bool render_geometry = true;
+    if (*prepared_ != NULL && shape != NULL)
+    {
+        // prepared geometries build their index lazily
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(prepared_mutex_);
+#endif
+        render_geometry = GEOSPreparedIntersects(*prepared_, shape) == 1;
+    }
+
+    if (! render_geometry || ! wkb_)
+    {
+        return boost::make_shared<geos_featureset>();
+    }
+    return boost::make_shared<geos_featureset>(wkb_,
+                                               geometry_id_,
+                                               multiple_geometries_,
+                                               geometry_data_name_,
+                                               geometry_data_value_);
+}
+
 featureset_ptr geos_datasource::features(query const& q) const
 {
     if (!is_bound_) bind();
 
     const mapnik::box2d<double> extent = q.get_bbox();
 
-    std::ostringstream s;
-    s << "POLYGON(("
-      << extent.minx() << " " << extent.miny() << ","
-      << extent.maxx() << " " << extent.miny() << ","
-      << extent.maxx() << " " << extent.maxy() << ","
-      << extent.minx() << " " << extent.maxy() << ","
-      << extent.minx() << " " << extent.miny()
-      << "))";
-
 #ifdef MAPNIK_DEBUG
-    clog << "GEOS Plugin: using extent: " << s.str() << endl;
+    clog << "GEOS Plugin: using extent: " << extent << endl;
 #endif
 
-    return boost::make_shared<geos_featureset>(*geometry_,
-                                               GEOSGeomFromWKT(s.str().c_str()),
-                                               geometry_id_,
-                                               geometry_data_,
-                                               geometry_data_name_,
-                                               desc_.get_encoding(),
-                                               multiple_geometries_);
+    GEOSCoordSequence* cs = GEOSCoordSeq_create(5, 2);
+    GEOSCoordSeq_setX(cs, 0, extent.minx()); GEOSCoordSeq_setY(cs, 0, extent.miny());
+    GEOSCoordSeq_setX(cs, 1, extent.maxx()); GEOSCoordSeq_setY(cs, 1, extent.miny());
+    GEOSCoordSeq_setX(cs, 2, extent.maxx()); GEOSCoordSeq_setY(cs, 2, extent.maxy());
+    GEOSCoordSeq_setX(cs, 3, extent.minx()); GEOSCoordSeq_setY(cs, 3, extent.maxy());
+    GEOSCoordSeq_setX(cs, 4, extent.minx()); GEOSCoordSeq_setY(cs, 4, extent.miny());
+
+    GEOSGeometry* shell = GEOSGeom_createLinearRing(cs);
+    GEOSGeometry* shape = shell != NULL ? GEOSGeom_createPolygon(shell, NULL, 0) : NULL;
+
+    return features_intersecting(shape);
 }
 
 featureset_ptr geos_datasource::features_at_point(coord2d const& pt) const
 {
     if (!is_bound_) bind();
 
-    std::ostringstream s;
-    s << "POINT(" << pt.x << " " << pt.y << ")";
-
 #ifdef MAPNIK_DEBUG
-    clog << "GEOS Plugin: using point: " << s.str() << endl;
+    clog << "GEOS Plugin: using point: " << pt << endl;
 #endif
 
-    return boost::make_shared<geos_featureset>(*geometry_,
-                                               GEOSGeomFromWKT(s.str().c_str()),
-                                               geometry_id_,
-                                               geometry_data_,
-                                               geometry_data_name_,
-                                               desc_.get_encoding(),
-                                               multiple_geometries_);
-}
+    GEOSCoordSequence* cs = GEOSCoordSeq_create(1, 2);
+    GEOSCoordSeq_setX(cs, 0, pt.x);
+    GEOSCoordSeq_setY(cs, 0, pt.y);
 
+    return features_intersecting(GEOSGeom_createPoint(cs));
+}
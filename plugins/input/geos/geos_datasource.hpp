@@ -31,6 +31,9 @@
 
 // boost
 #include <boost/shared_ptr.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include "geos_feature_ptr.hpp"
 
@@ -47,11 +50,20 @@ class geos_datasource : public mapnik::datasource
         mapnik::layer_descriptor get_descriptor() const;
         void bind() const;
     private:
+        mapnik::featureset_ptr features_intersecting(GEOSGeometry* shape) const;
         mutable mapnik::box2d<double> extent_;
         mutable bool extent_initialized_;
         int type_;
         mutable mapnik::layer_descriptor desc_;
         mutable geos_feature_ptr geometry_;
+        // prepared once, so intersection tests reuse its spatial index
+        mutable geos_prepared_ptr prepared_;
+        // geometry_ as WKB, every featureset builds its own feature from it
+        mutable boost::shared_ptr<std::string> wkb_;
+        mutable UnicodeString geometry_data_value_;
+#ifdef MAPNIK_THREADSAFE
+        mutable boost::mutex prepared_mutex_;
+#endif
         mutable std::string geometry_data_;
         mutable std::string geometry_data_name_;
         mutable int geometry_id_;
@@ -64,6 +64,38 @@ private:
 };
 
 
+class geos_prepared_ptr
+{
+public:
+    geos_prepared_ptr ()
+        : prepared_ (NULL)
+    {
+    }
+
+    ~geos_prepared_ptr ()
+    {
+        if (prepared_ != NULL)
+            GEOSPreparedGeom_destroy(prepared_);
+    }
+
+    void set_geometry (const GEOSPreparedGeometry* const prepared)
+    {
+        if (prepared_ != NULL)
+            GEOSPreparedGeom_destroy(prepared_);
+
+        prepared_ = prepared;
+    }
+
+    const GEOSPreparedGeometry* operator*()
+    {
+        return prepared_;
+    }
+
+private:
+    const GEOSPreparedGeometry* prepared_;
+};
+
+
 class geos_wkb_ptr
 {
 public:
@@ -21,51 +21,35 @@
  *****************************************************************************/
 //$Id$
 
-#include <iostream>
-#include <fstream>
-
 // mapnik
-#include <mapnik/global.hpp>
-#include <mapnik/datasource.hpp>
-#include <mapnik/box2d.hpp>
-#include <mapnik/geometry.hpp>
 #include <mapnik/feature.hpp>
-#include <mapnik/feature_layer_desc.hpp>
-#include <mapnik/wkb.hpp>
-#include <mapnik/unicode.hpp>
 #include <mapnik/feature_factory.hpp>
+#include <mapnik/wkb.hpp>
 
-// ogr
 #include "geos_featureset.hpp"
 
-using std::clog;
-using std::endl;
-
-using mapnik::query;
-using mapnik::box2d;
-using mapnik::coord2d;
-using mapnik::CoordTransform;
-using mapnik::Feature;
 using mapnik::feature_ptr;
-using mapnik::geometry_utils;
-using mapnik::transcoder;
 using mapnik::feature_factory;
+using mapnik::geometry_utils;
 
 
-geos_featureset::geos_featureset(GEOSGeometry* geometry,
-                                 GEOSGeometry* extent,
-                                 int identifier,
-                                 const std::string& field,
-                                 const std::string& field_name,
-                                 const std::string& encoding,
-                                 bool multiple_geometries)
-   : geometry_(geometry),
-     tr_(new transcoder(encoding)),
-     extent_(extent),
-     identifier_(identifier),
-     field_(field),
-     field_name_(field_name),
+geos_featureset::geos_featureset()
+   : id_(0),
+     multiple_geometries_(false),
+     already_rendered_(true)
+{
+}
+
+geos_featureset::geos_featureset(boost::shared_ptr<std::string> const& wkb,
+                                 int id,
+                                 bool multiple_geometries,
+                                 std::string const& data_name,
+                                 UnicodeString const& data)
+   : wkb_(wkb),
+     id_(id),
      multiple_geometries_(multiple_geometries),
+     data_name_(data_name),
+     data_(data),
      already_rendered_(false)
 {
 }
@@ -79,63 +63,18 @@ feature_ptr geos_featureset::next()
     if (! already_rendered_)
     {
         already_rendered_ = true;
-        
-        if (GEOSisValid(geometry_) && ! GEOSisEmpty(geometry_))
-        {
-            bool render_geometry = true;
-            
-            if (*extent_ != NULL && GEOSisValid(*extent_) && !GEOSisEmpty(*extent_))
-            {
-                const int type = GEOSGeomTypeId(*extent_);
-                render_geometry = false;
-
-                switch ( type )
-                {
-                case GEOS_POINT:
-                    if (GEOSIntersects(*extent_, geometry_))
-                    {
-                        render_geometry = true;
-                    }
-                    break;
-                case GEOS_POLYGON:
-                    if (GEOSContains(*extent_, geometry_)
-                        || GEOSWithin(geometry_, *extent_)
-                        || GEOSEquals(geometry_, *extent_))
-                    {
-                        render_geometry = true;
-                    }
-                    break;
-               default:
-#ifdef MAPNIK_DEBUG
-                    clog << "GEOS Plugin: unknown extent geometry_type=" << type << endl;
-#endif
-                    break;
-               }
-            }
-
-            if (render_geometry)
-            {
-                geos_wkb_ptr wkb(geometry_);
-                if (wkb.is_valid())
-                {
-                    feature_ptr feature(feature_factory::create(identifier_));
 
-                    geometry_utils::from_wkb(*feature,
-                                             wkb.data(),
-                                             wkb.size(),
-                                             multiple_geometries_);
-
-                    if (field_ != "")
-                    {
-                        boost::put(*feature, field_name_, tr_->transcode(field_.c_str()));
-                    }
-                    
-                    return feature;
-                }
-            }
+        feature_ptr feature(feature_factory::create(id_));
+        geometry_utils::from_wkb(*feature,
+                                 wkb_->data(),
+                                 wkb_->size(),
+                                 multiple_geometries_);
+        if (! data_.isEmpty())
+        {
+            boost::put(*feature, data_name_, data_);
         }
+        return feature;
     }
 
     return feature_ptr();
 }
-
@@ -26,38 +26,35 @@
 
 // mapnik
 #include <mapnik/datasource.hpp>
-#include <mapnik/unicode.hpp> 
-#include <mapnik/geom_util.hpp>
+#include <mapnik/unicode.hpp>
 
 // boost
-#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
-// geos
-#include <geos_c.h>
+// stl
+#include <string>
 
-#include "geos_feature_ptr.hpp"
-  
+// The single feature of a geos_datasource, already tested against the
+// query by the datasource and built here from its WKB, so featuresets
+// never share a feature. A default constructed featureset is empty.
 class geos_featureset : public mapnik::Featureset
 {
 public:
-      geos_featureset(GEOSGeometry* geometry,
-                      GEOSGeometry* extent,
-                      int identifier,
-                      const std::string& field,
-                      const std::string& field_name,
-                      const std::string& encoding,
-                      bool multiple_geometries);
+      geos_featureset();
+      geos_featureset(boost::shared_ptr<std::string> const& wkb,
+                      int id,
+                      bool multiple_geometries,
+                      std::string const& data_name,
+                      UnicodeString const& data);
       virtual ~geos_featureset();
       mapnik::feature_ptr next();
 
 private:
-      GEOSGeometry* geometry_;
-      boost::scoped_ptr<mapnik::transcoder> tr_;
-      geos_feature_ptr extent_;
-      int identifier_;
-      std::string field_;
-      std::string field_name_;
+      boost::shared_ptr<std::string> wkb_;
+      int id_;
       bool multiple_geometries_;
+      std::string data_name_;
+      UnicodeString data_;
       bool already_rendered_;
 
       geos_featureset(const geos_featureset&);
@@ -31,10 +31,12 @@
 
 // ogr
 #include "ogr_converter.hpp"
+#include <gdal_version.h>
 
 using mapnik::feature_ptr;
 using mapnik::geometry_utils;
 using mapnik::geometry_type;
+using mapnik::transcoder;
 
 void ogr_converter::convert_geometry (OGRGeometry* geom, feature_ptr feature, bool multiple_geometries)
 {
@@ -269,3 +271,101 @@ void ogr_converter::convert_collection (OGRGeometryCollection* geom, feature_ptr
     }
 }
 
+ogr_field_converter::ogr_field_converter (OGRFeatureDefn* layerdef, std::string const& encoding)
+    : tr_(new transcoder(encoding))
+{
+    init (layerdef, 0);
+}
+
+ogr_field_converter::ogr_field_converter (OGRFeatureDefn* layerdef, std::string const& encoding,
+                                          std::set<std::string> const& names)
+    : tr_(new transcoder(encoding))
+{
+    init (layerdef, &names);
+}
+
+void ogr_field_converter::init (OGRFeatureDefn* layerdef, std::set<std::string> const* names)
+{
+    int fld_count = layerdef->GetFieldCount();
+    for (int i = 0; i < fld_count; i++)
+    {
+        OGRFieldDefn* fld = layerdef->GetFieldDefn (i);
+        std::string fld_name = fld->GetNameRef ();
+        if (names && names->find (fld_name) == names->end())
+        {
+            ignored_.push_back (fld_name);
+            continue;
+        }
+
+        OGRFieldType type_oid = fld->GetType ();
+        switch (type_oid)
+        {
+            case OFTInteger:
+            case OFTReal:
+            case OFTString:
+            case OFTWideString:     // deprecated !
+            {
+               field f;
+               f.index = i;
+               f.name = fld_name;
+               f.type = type_oid;
+               fields_.push_back (f);
+               break;
+            }
+
+            default: // lists, binary, date/time and unknown types are not handled
+            {
+            #ifdef MAPNIK_DEBUG
+               std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
+            #endif
+               ignored_.push_back (fld_name);
+               break;
+            }
+        }
+    }
+    // feature style strings are never used
+    ignored_.push_back ("OGR_STYLE");
+}
+
+void ogr_field_converter::set_ignored_fields (OGRLayer & layer) const
+{
+#if GDAL_VERSION_NUM >= 1800
+    std::vector<const char*> names;
+    names.reserve (ignored_.size() + 1);
+    for (std::vector<std::string>::const_iterator itr = ignored_.begin(); itr != ignored_.end(); ++itr)
+    {
+        names.push_back (itr->c_str());
+    }
+    names.push_back (NULL);
+    // drivers without support simply keep reading every field
+    layer.SetIgnoredFields (&names[0]);
+#endif
+}
+
+void ogr_field_converter::convert (OGRFeature* feat, feature_ptr feature) const
+{
+    for (std::vector<field>::const_iterator itr = fields_.begin(); itr != fields_.end(); ++itr)
+    {
+        switch (itr->type)
+        {
+            case OFTInteger:
+            {
+               boost::put(*feature,itr->name,feat->GetFieldAsInteger (itr->index));
+               break;
+            }
+
+            case OFTReal:
+            {
+               boost::put(*feature,itr->name,feat->GetFieldAsDouble (itr->index));
+               break;
+            }
+
+            default: // OFTString, OFTWideString
+            {
+               UnicodeString ustr = tr_->transcode(feat->GetFieldAsString (itr->index));
+               boost::put(*feature,itr->name,ustr);
+               break;
+            }
+        }
+    }
+}
@@ -26,6 +26,16 @@
 
 // mapnik
 #include <mapnik/datasource.hpp>
+#include <mapnik/unicode.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+// stl
+#include <set>
+#include <string>
+#include <vector>
 
 // ogr
 #include <ogrsf_frmts.h>
@@ -47,4 +57,31 @@ class ogr_converter
       static void convert_multipolygon_2 (OGRMultiPolygon* geom, mapnik::feature_ptr feature);
 };
 
-#endif // OGR_FEATURESET_HPP
+// Converts the attributes of OGR features into mapnik features. The
+// field layout is resolved once per query instead of once per feature,
+// and only the requested fields are read.
+class ogr_field_converter : private boost::noncopyable
+{
+    public:
+      // all fields of the layer
+      ogr_field_converter (OGRFeatureDefn* layerdef, std::string const& encoding);
+      // only the fields listed in names
+      ogr_field_converter (OGRFeatureDefn* layerdef, std::string const& encoding,
+                           std::set<std::string> const& names);
+      // tells OGR to skip parsing the fields which are not converted
+      void set_ignored_fields (OGRLayer & layer) const;
+      void convert (OGRFeature* feat, mapnik::feature_ptr feature) const;
+    private:
+      struct field
+      {
+          int index;
+          std::string name;
+          OGRFieldType type;
+      };
+      void init (OGRFeatureDefn* layerdef, std::set<std::string> const* names);
+      std::vector<field> fields_;
+      std::vector<std::string> ignored_;
+      boost::scoped_ptr<mapnik::transcoder> tr_;
+};
+
+#endif // OGR_CONVERTER_HPP
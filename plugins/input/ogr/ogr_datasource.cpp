@@ -35,6 +35,7 @@
 
 // boost
 #include <boost/algorithm/string.hpp>
+#include <boost/make_shared.hpp>
 
 using mapnik::datasource;
 using mapnik::parameters;
@@ -289,30 +290,11 @@ featureset_ptr ogr_datasource::features(query const& q) const
    
    if (dataset_ && layer_)
    {
-
-        // TODO - actually filter fields!
-        // http://trac.osgeo.org/gdal/wiki/rfc29_desired_fields
-        // http://trac.osgeo.org/gdal/wiki/rfc28_sqlfunc
-#if 0
-        std::ostringstream s;
-            
-        s << "select ";
-        std::set<std::string> const& props=q.property_names();
-        std::set<std::string>::const_iterator pos=props.begin();
-        std::set<std::string>::const_iterator end=props.end();
-        while (pos != end)
-        {
-           s <<",\""<<*pos<<"\"";
-           ++pos;
-        }   
-        s << " from " << layerName_ ;
-
-        // execute existing SQL
-        OGRLayer* layer = dataset_->ExecuteSQL (s.str(), poly);
-
-        // layer must be freed
-        dataset_->ReleaseResultSet (layer);
-#endif
+        // only the requested fields are read and converted
+        boost::shared_ptr<ogr_field_converter> fields =
+            boost::make_shared<ogr_field_converter>(layer_->GetLayerDefn(),
+                                                    desc_.get_encoding(),
+                                                    q.property_names());
 
         if (indexed_)
         {
@@ -322,7 +304,7 @@ featureset_ptr ogr_datasource::features(query const& q) const
                                                                            *layer_,
                                                                            filter,
                                                                            index_name_,
-                                                                           desc_.get_encoding(),
+                                                                           fields,
                                                                            multiple_geometries_));
         }
         else
@@ -330,7 +312,7 @@ featureset_ptr ogr_datasource::features(query const& q) const
             return featureset_ptr(new ogr_featureset (*dataset_,
                                                       *layer_,
                                                       q.get_bbox(),
-                                                      desc_.get_encoding(),
+                                                      fields,
                                                       multiple_geometries_));
         }
    }
@@ -343,6 +325,11 @@ featureset_ptr ogr_datasource::features_at_point(coord2d const& pt) const
    
    if (dataset_ && layer_)
    {
+        // no query, so every field is read
+        boost::shared_ptr<ogr_field_converter> fields =
+            boost::make_shared<ogr_field_converter>(layer_->GetLayerDefn(),
+                                                    desc_.get_encoding());
+
         if (indexed_)
         {
             filter_at_point filter(pt);
@@ -351,7 +338,7 @@ featureset_ptr ogr_datasource::features_at_point(coord2d const& pt) const
                                                                              *layer_,
                                                                              filter,
                                                                              index_name_,
-                                                                             desc_.get_encoding(),
+                                                                             fields,
                                                                              multiple_geometries_));
         }
         else
@@ -363,7 +350,7 @@ featureset_ptr ogr_datasource::features_at_point(coord2d const& pt) const
             return featureset_ptr(new ogr_featureset (*dataset_,
                                                       *layer_,
                                                       point,
-                                                      desc_.get_encoding(),
+                                                      fields,
                                                       multiple_geometries_));
         }
    }
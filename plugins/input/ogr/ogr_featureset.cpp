@@ -49,32 +49,34 @@ using mapnik::feature_factory;
 ogr_featureset::ogr_featureset(OGRDataSource & dataset,
                                OGRLayer & layer,
                                OGRGeometry & extent,
-                               const std::string& encoding,
+                               boost::shared_ptr<ogr_field_converter> const& fields,
                                const bool multiple_geometries)
    : dataset_(dataset),
      layer_(layer),
      layerdef_(layer.GetLayerDefn()),
-     tr_(new transcoder(encoding)),
+     fields_(fields),
      fidcolumn_(layer_.GetFIDColumn ()),
      multiple_geometries_(multiple_geometries),
      count_(0)
 {
+    fields_->set_ignored_fields (layer_);
     layer_.SetSpatialFilter (&extent);
 }
 
 ogr_featureset::ogr_featureset(OGRDataSource & dataset,
                                OGRLayer & layer,
                                const mapnik::box2d<double> & extent,
-                               const std::string& encoding,
+                               boost::shared_ptr<ogr_field_converter> const& fields,
                                const bool multiple_geometries)
    : dataset_(dataset),
      layer_(layer),
      layerdef_(layer.GetLayerDefn()),
-     tr_(new transcoder(encoding)),
+     fields_(fields),
      fidcolumn_(layer_.GetFIDColumn()),
      multiple_geometries_(multiple_geometries),
      count_(0)
 {
+    fields_->set_ignored_fields (layer_);
     layer_.SetSpatialFilterRect (extent.minx(),
                                  extent.miny(),
                                  extent.maxx(),
@@ -106,74 +108,7 @@ feature_ptr ogr_featureset::next()
 #endif
         ++count_;
         
-        int fld_count = layerdef_->GetFieldCount();
-        for (int i = 0; i < fld_count; i++)
-        {
-            OGRFieldDefn* fld = layerdef_->GetFieldDefn (i);
-            OGRFieldType type_oid = fld->GetType ();
-            std::string fld_name = fld->GetNameRef ();
-        
-            switch (type_oid)
-            {
-                case OFTInteger:
-                {
-                   boost::put(*feature,fld_name,(*feat)->GetFieldAsInteger (i));
-                   break;
-                }
-                
-                case OFTReal:
-                {
-                   boost::put(*feature,fld_name,(*feat)->GetFieldAsDouble (i));
-                   break;
-                }
-                       
-                case OFTString:
-                case OFTWideString:     // deprecated !
-                {
-                   UnicodeString ustr = tr_->transcode((*feat)->GetFieldAsString (i));
-                   boost::put(*feature,fld_name,ustr);
-                   break;
-                }
-                
-                case OFTIntegerList:
-                case OFTRealList:
-                case OFTStringList:
-                case OFTWideStringList: // deprecated !
-                {
-                #ifdef MAPNIK_DEBUG
-                   std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-                #endif
-                   break;
-                }
-                
-                case OFTBinary:
-                {
-                #ifdef MAPNIK_DEBUG
-                   std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-                #endif
-                   //boost::put(*feature,name,feat->GetFieldAsBinary (i, size));
-                   break;
-                }
-                   
-                case OFTDate:
-                case OFTTime:
-                case OFTDateTime:       // unhandled !
-                {
-                #ifdef MAPNIK_DEBUG
-                   std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-                #endif
-                   break;
-                }
-                
-                default: // unknown
-                {
-                #ifdef MAPNIK_DEBUG
-                   std::clog << "OGR Plugin: unknown type_oid=" << type_oid << std::endl;
-                #endif
-                   break;
-                }
-            }
-        }
+        fields_->convert (*feat, feature);
         return feature;
     }
 
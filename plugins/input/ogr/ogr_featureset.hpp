@@ -30,17 +30,18 @@
 #include <mapnik/geom_util.hpp>
 
 // boost
-#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 // ogr
 #include <ogrsf_frmts.h>
+#include "ogr_converter.hpp"
   
 class ogr_featureset : public mapnik::Featureset
 {
       OGRDataSource & dataset_;
       OGRLayer & layer_;
       OGRFeatureDefn * layerdef_;
-      boost::scoped_ptr<mapnik::transcoder> tr_;
+      boost::shared_ptr<ogr_field_converter> fields_;
       const char* fidcolumn_;
       bool multiple_geometries_;
       mutable int count_;
@@ -48,13 +49,13 @@ class ogr_featureset : public mapnik::Featureset
       ogr_featureset(OGRDataSource & dataset,
                      OGRLayer & layer,
                      OGRGeometry & extent,
-                     const std::string& encoding,
+                     boost::shared_ptr<ogr_field_converter> const& fields,
                      const bool multiple_geometries);
 
       ogr_featureset(OGRDataSource & dataset,
                      OGRLayer & layer,
                      const mapnik::box2d<double> & extent,
-                     const std::string& encoding,
+                     boost::shared_ptr<ogr_field_converter> const& fields,
                      const bool multiple_geometries);
       virtual ~ogr_featureset();
       mapnik::feature_ptr next();
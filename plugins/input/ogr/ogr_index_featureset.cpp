@@ -56,13 +56,14 @@ ogr_index_featureset<filterT>::ogr_index_featureset(OGRDataSource & dataset,
                                                     OGRLayer & layer,
                                                     const filterT& filter,
                                                     const std::string& index_file,
-                                                    const std::string& encoding,
+                                                    boost::shared_ptr<ogr_field_converter> const& fields,
                                                     const bool multiple_geometries)
    : dataset_(dataset),
      layer_(layer),
      layerdef_(layer.GetLayerDefn()),
      filter_(filter),
-     tr_(new transcoder(encoding)),
+     next_pos_(0),
+     fields_(fields),
      fidcolumn_(layer_.GetFIDColumn()),
      multiple_geometries_(multiple_geometries)
 {
@@ -82,6 +83,8 @@ ogr_index_featureset<filterT>::ogr_index_featureset(OGRDataSource & dataset,
 
     itr_ = ids_.begin();
 
+    fields_->set_ignored_fields (layer_);
+
     // reset reading            
     layer_.ResetReading();
 }
@@ -95,7 +98,13 @@ feature_ptr ogr_index_featureset<filterT>::next()
     if (itr_ != ids_.end())
     {
         int pos = *itr_++;
-        layer_.SetNextByIndex (pos);
+        // ids are sorted, runs of consecutive ones are read sequentially
+        // instead of seeking to every single feature
+        if (pos != next_pos_)
+        {
+            layer_.SetNextByIndex (pos);
+        }
+        next_pos_ = pos + 1;
 
         ogr_feature_ptr feat (layer_.GetNextFeature());
         if ((*feat) != NULL)
@@ -117,74 +126,7 @@ feature_ptr ogr_index_featureset<filterT>::next()
             }
     #endif
             
-            int fld_count = layerdef_->GetFieldCount();
-            for (int i = 0; i < fld_count; i++)
-            {
-                OGRFieldDefn* fld = layerdef_->GetFieldDefn (i);
-                OGRFieldType type_oid = fld->GetType ();
-                std::string fld_name = fld->GetNameRef ();
-            
-                switch (type_oid)
-                {
-                    case OFTInteger:
-                    {
-                       boost::put(*feature,fld_name,(*feat)->GetFieldAsInteger (i));
-                       break;
-                    }
-                    
-                    case OFTReal:
-                    {
-                       boost::put(*feature,fld_name,(*feat)->GetFieldAsDouble (i));
-                       break;
-                    }
-                           
-                    case OFTString:
-                    case OFTWideString:     // deprecated !
-                    {
-                       UnicodeString ustr = tr_->transcode((*feat)->GetFieldAsString (i));
-                       boost::put(*feature,fld_name,ustr);
-                       break;
-                    }
-                    
-                    case OFTIntegerList:
-                    case OFTRealList:
-                    case OFTStringList:
-                    case OFTWideStringList: // deprecated !
-                    {
-                    #ifdef MAPNIK_DEBUG
-                       std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-                    #endif
-                       break;
-                    }
-                    
-                    case OFTBinary:
-                    {
-                    #ifdef MAPNIK_DEBUG
-                       std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-                    #endif
-                       //boost::put(*feature,name,feat->GetFieldAsBinary (i, size));
-                       break;
-                    }
-                       
-                    case OFTDate:
-                    case OFTTime:
-                    case OFTDateTime:       // unhandled !
-                    {
-                    #ifdef MAPNIK_DEBUG
-                       std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-                    #endif
-                       break;
-                    }
-                    
-                    default: // unknown
-                    {
-                    #ifdef MAPNIK_DEBUG
-                       std::clog << "OGR Plugin: unknown type_oid=" << type_oid << std::endl;
-                    #endif
-                       break;
-                    }
-                }
-            }
+            fields_->convert (*feat, feature);
             return feature;
         }
     }
@@ -26,7 +26,7 @@
 
 #include <set>
 #include <vector>
-#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include "ogr_featureset.hpp"
 
 template <typename filterT>
@@ -38,7 +38,8 @@ class ogr_index_featureset : public mapnik::Featureset
       filterT filter_;
       std::vector<int> ids_;
       std::vector<int>::iterator itr_;
-      boost::scoped_ptr<mapnik::transcoder> tr_;
+      int next_pos_;
+      boost::shared_ptr<ogr_field_converter> fields_;
       const char* fidcolumn_;
       bool multiple_geometries_;
 
@@ -47,7 +48,7 @@ class ogr_index_featureset : public mapnik::Featureset
                            OGRLayer & layer,
                            const filterT& filter,
                            const std::string& index_file,
-                           const std::string& encoding,
+                           boost::shared_ptr<ogr_field_converter> const& fields,
                            const bool multiple_geometries);
       virtual ~ogr_index_featureset();
       mapnik::feature_ptr next();
@@ -6,6 +6,9 @@
 #include <sstream>
 #include <string>
 #include "basiccurl.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 
 #include <iostream>
@@ -95,40 +98,78 @@ void osm_dataset::clear()
 
   ways.clear();
   nodes.clear();
+  node_store.clear();
+  strings.clear();
+  way_index.clear();
+  rewind();
 
 #ifdef MAPNIK_DEBUG
     cerr<<"Done"<<endl;
 #endif
 }
 
+void osm_dataset::add_way(osm_way* w)
+{
+  if(w->nodes.empty())
+  {
+    // nothing to draw
+    delete w;
+    return;
+  }
+  w->finalize(strings);
+  ways.push_back(w);
+}
+
+void osm_dataset::finish()
+{
+  // coordinates are only needed to resolve way node refs while parsing
+  node_store.clear();
+  way_index.build(ways);
+  rewind();
+}
+
 std::string osm_dataset::to_string()
 {
   std::string result;
 
   for(unsigned int count=0; count<nodes.size(); count++)
   {
-    result += nodes[count]->to_string();
+    result += nodes[count]->to_string(strings);
   }
   for(unsigned int count=0; count<ways.size(); count++)
   {
-    result += ways[count]->to_string();
+    result += ways[count]->to_string(strings);
   }
   return result;
 }
 
+static void expand_bounds(bounds & b, bool & first, double lon, double lat)
+{
+  if(first)
+  {
+    b = bounds(lon,lat,lon,lat);
+    first = false;
+    return;
+  }
+  if(lon < b.w) b.w = lon;
+  if(lon > b.e) b.e = lon;
+  if(lat < b.s) b.s = lat;
+  if(lat > b.n) b.n = lat;
+}
+
 bounds osm_dataset::get_bounds()
 {
-  bounds b (-180,-90,180,90);
+  bounds b;
+  bool first = true;
   for(unsigned int count=0; count<nodes.size();count++)
   {
-    if(nodes[count]->lon > b.w)
-      b.w=nodes[count]->lon;
-    if(nodes[count]->lon < b.e)
-      b.e=nodes[count]->lon;
-    if(nodes[count]->lat > b.s)
-      b.s=nodes[count]->lat;
-    if(nodes[count]->lat < b.n)
-      b.n=nodes[count]->lat;
+    expand_bounds(b,first,nodes[count]->lon,nodes[count]->lat);
+  }
+  for(unsigned int count=0; count<ways.size();count++)
+  {
+    bounds wb = ways[count]->get_bounds();
+    expand_bounds(b,first,wb.w,wb.s);
+    expand_bounds(b,first,wb.e,wb.n);
   }
   return b;
 }
@@ -173,91 +214,332 @@ osm_item *osm_dataset::next_item()
   
 std::set<std::string> osm_dataset::get_keys()
 {
-  std::set<std::string> keys;
+  std::set<unsigned> key_ids;
   for(unsigned int count=0; count<nodes.size(); count++)
   {
-    for(std::map<std::string,std::string>::iterator i=
-      nodes[count]->keyvals.begin(); i!=nodes[count]->keyvals.end(); i++)
+    for(osm_tags::const_iterator i=nodes[count]->tags.begin();
+        i!=nodes[count]->tags.end(); i++)
     {
-      keys.insert(i->first);
+      key_ids.insert(i->first);
     }
   }
   for(unsigned int count=0; count<ways.size(); count++)
   {
-    for(std::map<std::string,std::string>::iterator i=
-      ways[count]->keyvals.begin(); i!=ways[count]->keyvals.end(); i++)
+    for(osm_tags::const_iterator i=ways[count]->tags.begin();
+        i!=ways[count]->tags.end(); i++)
     {
-      keys.insert(i->first);
+      key_ids.insert(i->first);
     }
   }
+  std::set<std::string> keys;
+  for(std::set<unsigned>::const_iterator i=key_ids.begin(); i!=key_ids.end(); i++)
+  {
+    keys.insert(strings.get(*i));
+  }
   return keys;
 }
 
-      
-    
+// node store
+
+void osm_node_store::add(long id, double lon, double lat)
+{
+  if(!ids_.empty() && id < ids_.back())
+    sorted_ = false;
+  ids_.push_back(id);
+  coords_.push_back(osm_coord(lon,lat));
+}
+
+struct node_id_less
+{
+  std::vector<long> const& ids;
+  explicit node_id_less(std::vector<long> const& ids_) : ids(ids_) {}
+  bool operator()(unsigned a, unsigned b) const { return ids[a] < ids[b]; }
+};
+
+void osm_node_store::finalize()
+{
+  if(sorted_) return;
+  // files are normally sorted by id, only reorder when they are not
+  std::vector<unsigned> order(ids_.size());
+  for(unsigned i=0; i<order.size(); i++) order[i]=i;
+  std::stable_sort(order.begin(),order.end(),node_id_less(ids_));
+  std::vector<long> ids(ids_.size());
+  std::vector<osm_coord> coords(coords_.size());
+  for(unsigned i=0; i<order.size(); i++)
+  {
+    ids[i] = ids_[order[i]];
+    coords[i] = coords_[order[i]];
+  }
+  ids_.swap(ids);
+  coords_.swap(coords);
+  sorted_ = true;
+}
+
+bool osm_node_store::find(long id, osm_coord & c)
+{
+  finalize();
+  std::vector<long>::const_iterator itr =
+    std::lower_bound(ids_.begin(),ids_.end(),id);
+  if(itr == ids_.end() || *itr != id)
+    return false;
+  c = coords_[itr - ids_.begin()];
+  return true;
+}
+
+void osm_node_store::clear()
+{
+  std::vector<long>().swap(ids_);
+  std::vector<osm_coord>().swap(coords_);
+  sorted_ = true;
+}
 
-std::string osm_item::to_string()
+// string table
+
+unsigned osm_string_table::intern(std::string const& str)
+{
+  boost::unordered_map<std::string,unsigned>::const_iterator itr = ids_.find(str);
+  if(itr != ids_.end())
+    return itr->second;
+  unsigned id = strings_.size();
+  strings_.push_back(str);
+  ids_.insert(std::make_pair(str,id));
+  return id;
+}
+
+bool osm_string_table::find(std::string const& str, unsigned & id) const
+{
+  boost::unordered_map<std::string,unsigned>::const_iterator itr = ids_.find(str);
+  if(itr == ids_.end())
+    return false;
+  id = itr->second;
+  return true;
+}
+
+void osm_string_table::clear()
+{
+  strings_.clear();
+  ids_.clear();
+}
+
+// way index
+
+struct node_center_less
+{
+  bool by_x;
+  explicit node_center_less(bool x) : by_x(x) {}
+  template <typename T>
+  bool operator()(T const& a, T const& b) const
+  {
+    if(by_x) return (a.box.w + a.box.e) < (b.box.w + b.box.e);
+    return (a.box.s + a.box.n) < (b.box.s + b.box.n);
+  }
+};
+
+struct pair_less
+{
+  node_center_less less;
+  explicit pair_less(bool x) : less(x) {}
+  template <typename T>
+  bool operator()(T const& a, T const& b) const
+  {
+    return less(a.first,b.first);
+  }
+};
+
+void osm_way_index::pack(std::vector<node> const& children,
+                         std::vector<unsigned> & order,
+                         std::vector<node> & parents) const
+{
+  // sort-tile-recursive: slice by x into vertical slabs, sort each
+  // slab by y and cut it into runs of node_capacity
+  std::vector<std::pair<node,unsigned> > tmp;
+  tmp.reserve(children.size());
+  for(unsigned i=0; i<children.size(); i++)
+    tmp.push_back(std::make_pair(children[i],i));
+
+  std::sort(tmp.begin(),tmp.end(),pair_less(true));
+  unsigned num_parents = (tmp.size() + node_capacity - 1) / node_capacity;
+  unsigned slabs = static_cast<unsigned>(std::ceil(std::sqrt(double(num_parents))));
+  unsigned slab_size = slabs * node_capacity;
+  for(unsigned start=0; start<tmp.size(); start+=slab_size)
+  {
+    unsigned stop = std::min<unsigned>(start + slab_size, tmp.size());
+    std::sort(tmp.begin()+start,tmp.begin()+stop,pair_less(false));
+  }
+
+  order.clear();
+  parents.clear();
+  for(unsigned start=0; start<tmp.size(); start+=node_capacity)
+  {
+    unsigned stop = std::min<unsigned>(start + node_capacity, tmp.size());
+    node parent;
+    parent.box = tmp[start].first.box;
+    parent.begin = start;
+    parent.end = stop;
+    for(unsigned i=start; i<stop; i++)
+    {
+      bounds const& b = tmp[i].first.box;
+      if(b.w < parent.box.w) parent.box.w = b.w;
+      if(b.s < parent.box.s) parent.box.s = b.s;
+      if(b.e > parent.box.e) parent.box.e = b.e;
+      if(b.n > parent.box.n) parent.box.n = b.n;
+      order.push_back(tmp[i].second);
+    }
+    parents.push_back(parent);
+  }
+}
+
+void osm_way_index::build(std::vector<osm_way*> const& ways)
+{
+  clear();
+  if(ways.empty()) return;
+
+  std::vector<node> entries(ways.size());
+  for(unsigned i=0; i<ways.size(); i++)
+  {
+    entries[i].box = ways[i]->get_bounds();
+    entries[i].begin = i;
+    entries[i].end = i+1;
+  }
+
+  std::vector<unsigned> order;
+  std::vector<node> level;
+  pack(entries,order,level);
+  items_ = order;
+  item_bounds_.reserve(order.size());
+  for(unsigned i=0; i<order.size(); i++)
+    item_bounds_.push_back(entries[order[i]].box);
+  levels_.push_back(level);
+
+  while(levels_.back().size() > 1)
+  {
+    std::vector<node> const& children = levels_.back();
+    std::vector<node> parents;
+    pack(children,order,parents);
+    // reorder the child level to match its parents' ranges
+    std::vector<node> reordered(children.size());
+    for(unsigned i=0; i<order.size(); i++)
+      reordered[i] = children[order[i]];
+    levels_.back().swap(reordered);
+    levels_.push_back(parents);
+  }
+}
+
+static bool intersects(bounds const& a, bounds const& b)
+{
+  return !(a.w > b.e || a.e < b.w || a.s > b.n || a.n < b.s);
+}
+
+void osm_way_index::query_node(node const& n, unsigned level, bounds const& box,
+                               std::vector<unsigned> & result) const
+{
+  if(!intersects(n.box,box))
+    return;
+  if(level == 0)
+  {
+    for(unsigned i=n.begin; i<n.end; i++)
+    {
+      if(intersects(item_bounds_[i],box))
+        result.push_back(items_[i]);
+    }
+    return;
+  }
+  std::vector<node> const& children = levels_[level-1];
+  for(unsigned i=n.begin; i<n.end; i++)
+    query_node(children[i],level-1,box,result);
+}
+
+void osm_way_index::query(bounds const& box, std::vector<unsigned> & result) const
+{
+  if(levels_.empty()) return;
+  std::size_t start = result.size();
+  unsigned top = levels_.size() - 1;
+  std::vector<node> const& roots = levels_[top];
+  for(unsigned i=0; i<roots.size(); i++)
+    query_node(roots[i],top,box,result);
+  // keep painter's order of the source file
+  std::sort(result.begin()+start,result.end());
+}
+
+void osm_way_index::clear()
+{
+  levels_.clear();
+  items_.clear();
+  item_bounds_.clear();
+}
+
+// items
+
+void osm_item::set_tag(unsigned key, unsigned value)
+{
+  osm_tags::iterator itr = std::lower_bound(tags.begin(),tags.end(),
+                                            std::make_pair(key,0u));
+  if(itr != tags.end() && itr->first == key)
+    itr->second = value;
+  else
+    tags.insert(itr,std::make_pair(key,value));
+}
+
+bool osm_item::get_tag(unsigned key, unsigned & value) const
+{
+  osm_tags::const_iterator itr = std::lower_bound(tags.begin(),tags.end(),
+                                                  std::make_pair(key,0u));
+  if(itr == tags.end() || itr->first != key)
+    return false;
+  value = itr->second;
+  return true;
+}
+
+std::string osm_item::to_string(osm_string_table const& strings) const
 {
   std::ostringstream strm;
   strm << "id=" << id << std::endl << "Keyvals: " << std::endl;
-  for(std::map<std::string,std::string>::iterator i=keyvals.begin();
-      i!=keyvals.end(); i++)
+  for(osm_tags::const_iterator i=tags.begin(); i!=tags.end(); i++)
   {
-    strm << "Key " << i->first << " Value " << i->second << std::endl; 
+    strm << "Key " << strings.get(i->first) << " Value "
+         << strings.get(i->second) << std::endl; 
   }
   return strm.str();
 }
 
-std::string osm_node::to_string()
+std::string osm_node::to_string(osm_string_table const& strings) const
 {
   std::ostringstream strm;
-  strm << "Node: "<< osm_item::to_string() << 
+  strm << "Node: "<< osm_item::to_string(strings) << 
       " Lat=" << lat <<" lon="  <<lon << std::endl;
   return strm.str();
 }
 
-std::string osm_way::to_string()
+std::string osm_way::to_string(osm_string_table const& strings) const
 {
   std::ostringstream strm;
-  strm << "Way: " << osm_item::to_string() << "Nodes in way:";
+  strm << "Way: " << osm_item::to_string(strings) << "Nodes in way:";
 
   for(unsigned int count=0; count<nodes.size(); count++)
   {
-    if(nodes[count]!=NULL)
-    {
-      strm << nodes[count]->id << " ";
-    }
+    strm << "(" << nodes[count].lon() << "," << nodes[count].lat() << ") ";
   }
   strm << std::endl;
   return strm.str();
 }
 
-bounds osm_way::get_bounds()
+void osm_way::finalize(osm_string_table const& strings)
 {
-  bounds b (-180,-90,180,90);
+  bool first = true;
   for(unsigned int count=0; count<nodes.size();count++)
   {
-    if(nodes[count]->lon > b.w)
-      b.w=nodes[count]->lon;
-    if(nodes[count]->lon < b.e)
-      b.e=nodes[count]->lon;
-    if(nodes[count]->lat > b.s)
-      b.s=nodes[count]->lat;
-    if(nodes[count]->lat < b.n)
-      b.n=nodes[count]->lat;
+    expand_bounds(bounds_,first,nodes[count].lon(),nodes[count].lat());
   }
-  return b;
-}
 
-bool osm_way::is_polygon()
-{
-  for(unsigned int count=0; count<ptypes.ptypes.size(); count++)
+  polygon_ = false;
+  for(unsigned int count=0; count<ptypes.ptypes.size() && !polygon_; count++)
   {
-    if(keyvals.find(ptypes.ptypes[count].first) != keyvals.end() &&
-       keyvals[ptypes.ptypes[count].first] == ptypes.ptypes[count].second)
+    unsigned key, value, expected;
+    if(strings.find(ptypes.ptypes[count].first,key) &&
+       strings.find(ptypes.ptypes[count].second,expected) &&
+       get_tag(key,value) && value == expected)
     {
-      return true;
+      polygon_ = true;
     }
   }
-  return false;
 }
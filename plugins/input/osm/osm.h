@@ -6,6 +6,8 @@
 #include <map>
 #include <set>
 #include <utility>
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
 
 struct bounds
 {
@@ -40,11 +42,62 @@ public:
     }
 };
 
+// fixed point lon/lat with the 1e-7 degree precision OSM itself uses
+struct osm_coord
+{
+    boost::int32_t x, y;
+    osm_coord() : x(0), y(0) {}
+    osm_coord(double lon, double lat) : x(to_fixed(lon)), y(to_fixed(lat)) {}
+    double lon() const { return x * 1e-7; }
+    double lat() const { return y * 1e-7; }
+    static boost::int32_t to_fixed(double v)
+    {
+        return static_cast<boost::int32_t>(v >= 0 ? v * 1e7 + 0.5 : v * 1e7 - 0.5);
+    }
+};
+
+// coordinates of every node in the dataset as sorted id/coordinate
+// arrays, so ways can resolve their node refs while parsing without
+// an osm_node object (or a map entry) per node
+class osm_node_store
+{
+public:
+    osm_node_store() : sorted_(true) {}
+    void add(long id, double lon, double lat);
+    bool find(long id, osm_coord & c);
+    void finalize();
+    void clear();
+    std::size_t size() const { return ids_.size(); }
+private:
+    std::vector<long> ids_;
+    std::vector<osm_coord> coords_;
+    bool sorted_;
+};
+
+// every tag key and value is stored once, items refer to them by id
+class osm_string_table
+{
+public:
+    unsigned intern(std::string const& str);
+    bool find(std::string const& str, unsigned & id) const;
+    std::string const& get(unsigned id) const { return strings_[id]; }
+    std::size_t size() const { return strings_.size(); }
+    void clear();
+private:
+    std::vector<std::string> strings_;
+    boost::unordered_map<std::string,unsigned> ids_;
+};
+
+// interned (key,value) pairs, sorted by key
+typedef std::vector<std::pair<unsigned,unsigned> > osm_tags;
+
 struct osm_item
 {
     long id;
-    std::map<std::string,std::string> keyvals;    
-    virtual std::string to_string();
+    osm_tags tags;
+    void set_tag(unsigned key, unsigned value);
+    bool get_tag(unsigned key, unsigned & value) const;
+    virtual std::string to_string(osm_string_table const& strings) const;
     virtual ~osm_item() { }
 };
 
@@ -52,16 +105,47 @@ struct osm_item
 struct osm_node: public osm_item
 {
     double lat, lon;
-    std::string to_string();
+    std::string to_string(osm_string_table const& strings) const;
 };
 
 struct osm_way: public osm_item
 {
-    std::vector<osm_node*> nodes; 
-    std::string to_string();
-    bounds get_bounds();
-    bool is_polygon();
+    std::vector<osm_coord> nodes;
+    std::string to_string(osm_string_table const& strings) const;
+    bounds get_bounds() const { return bounds_; }
+    bool is_polygon() const { return polygon_; }
+    // caches bounds and polygon type once all nodes and tags are known
+    void finalize(osm_string_table const& strings);
     static polygon_types ptypes;
+private:
+    bounds bounds_;
+    bool polygon_;
+};
+
+// packed (sort-tile-recursive) r-tree over way bounds, built once
+// after loading and only read afterwards
+class osm_way_index
+{
+public:
+    void build(std::vector<osm_way*> const& ways);
+    // appends indices of ways whose bounds intersect the box, in dataset order
+    void query(bounds const& box, std::vector<unsigned> & result) const;
+    void clear();
+private:
+    struct node
+    {
+        bounds box;
+        unsigned begin, end;
+    };
+    enum { node_capacity = 16 };
+    void pack(std::vector<node> const& children, std::vector<unsigned> & order,
+              std::vector<node> & parents) const;
+    void query_node(node const& n, unsigned level, bounds const& box,
+                    std::vector<unsigned> & result) const;
+    // levels_[0] are leaves referring to ranges of items_
+    std::vector<std::vector<node> > levels_;
+    std::vector<unsigned> items_;
+    std::vector<bounds> item_bounds_;
 };
 
 class osm_dataset
@@ -71,8 +155,12 @@ private:
     enum {Node, Way };
     std::vector<osm_node*>::iterator node_i;
     std::vector<osm_way*>::iterator way_i;
+    // tagged nodes only, the rest are just way coordinates
     std::vector<osm_node*> nodes;
     std::vector<osm_way*> ways; 
+    osm_node_store node_store;
+    osm_string_table strings;
+    osm_way_index way_index;
 
 public:
     osm_dataset() { node_i=nodes.begin(); way_i=ways.begin();
@@ -86,7 +174,14 @@ public:
     ~osm_dataset();
     void clear();
     void add_node(osm_node* n) { nodes.push_back(n); }
-    void add_way(osm_way* w) { ways.push_back(w); }
+    void add_node_coord(long id, double lon, double lat) { node_store.add(id,lon,lat); }
+    bool find_node_coord(long id, osm_coord & c) { return node_store.find(id,c); }
+    void add_way(osm_way* w);
+    // called once parsing is done, drops the node store and builds
+    // the spatial index
+    void finish();
+    osm_string_table & get_strings() { return strings; }
+    osm_string_table const& get_strings() const { return strings; }
     std::string to_string();
     bounds get_bounds();
     std::set<std::string> get_keys();
@@ -98,6 +193,13 @@ public:
     osm_item * next_item();
     bool current_item_is_node() { return next_item_mode==Node; }
     bool current_item_is_way() { return next_item_mode==Way; }
+    // read-only access for featuresets
+    std::vector<osm_node*> const& get_nodes() const { return nodes; }
+    std::vector<osm_way*> const& get_ways() const { return ways; }
+    void query_ways(bounds const& box, std::vector<unsigned> & result) const
+    {
+        way_index.query(box,result);
+    }
 };
 
 #endif // OSM_H
@@ -150,6 +150,7 @@ featureset_ptr osm_datasource::features(const query& q) const
     // so we need to filter osm features by bbox here...
     
     return boost::make_shared<osm_featureset<filter_in_box> >(filter,
+                                              q.get_bbox(),
                                               osm_data_,
                                               q.property_names(),
                                               desc_.get_encoding());
@@ -174,6 +175,7 @@ featureset_ptr osm_datasource::features_at_point(coord2d const& pt) const
    }
     
     return boost::make_shared<osm_featureset<filter_at_point> >(filter,
+                                                box2d<double>(pt.x,pt.y,pt.x,pt.y),
                                                 osm_data_,
                                                 names,
                                                 desc_.get_encoding());
@@ -39,104 +39,92 @@ using std::endl;
 
 template <typename filterT>
 osm_featureset<filterT>::osm_featureset(const filterT& filter, 
-                                        osm_dataset * dataset, 
+                                        box2d<double> const& query_ext,
+                                        osm_dataset const* dataset, 
                                         const std::set<std::string>& 
                                         attribute_names,
                                         std::string const& encoding)
     : filter_(filter),
-      query_ext_(),
+      query_ext_(query_ext),
       tr_(new transcoder(encoding)),
       feature_id_(1),
       dataset_ (dataset),
-      attribute_names_ (attribute_names)
+      node_pos_(0),
+      way_pos_(0)
 {
-    dataset_->rewind();
+    osm_string_table const& strings = dataset_->get_strings();
+    std::set<std::string>::const_iterator itr = attribute_names.begin();
+    std::set<std::string>::const_iterator end = attribute_names.end();
+    for (; itr != end; ++itr)
+    {
+        unsigned key;
+        // keys which never occur in the data can't match anything
+        if (strings.find(*itr,key))
+            attributes_.push_back(std::make_pair(key,*itr));
+    }
+    dataset_->query_ways(bounds(query_ext_.minx(),query_ext_.miny(),
+                                query_ext_.maxx(),query_ext_.maxy()),
+                         way_ids_);
 }
 
+template <typename filterT>
+void osm_featureset<filterT>::add_attributes(feature_ptr & feature, osm_item const* item)
+{
+    osm_string_table const& strings = dataset_->get_strings();
+    std::vector<std::pair<unsigned,std::string> >::const_iterator itr = attributes_.begin();
+    std::vector<std::pair<unsigned,std::string> >::const_iterator end = attributes_.end();
+    for (; itr != end; ++itr)
+    {
+        unsigned value;
+        if (item->get_tag(itr->first,value))
+            (*feature)[itr->second] = tr_->transcode(strings.get(value).c_str());
+    }
+}
 
 template <typename filterT>
 feature_ptr osm_featureset<filterT>::next()
 {
-    osm_item * cur_item = dataset_->next_item();
-    feature_ptr feature;
-    bool success=false;
-    if(cur_item != NULL)
+    std::vector<osm_node*> const& nodes = dataset_->get_nodes();
+    while (node_pos_ < nodes.size())
     {
-        if(dataset_->current_item_is_node())
-        {
-            feature = feature_factory::create(feature_id_);
-            ++feature_id_;
-            double lat = static_cast<osm_node*>(cur_item)->lat;
-            double lon = static_cast<osm_node*>(cur_item)->lon;
-            geometry_type * point = new geometry_type(mapnik::Point);
-            point->move_to(lon,lat);
-            feature->add_geometry(point);
-            success = true;
-        } 
-        else if (dataset_->current_item_is_way())
-        {
-            bounds b = static_cast<osm_way*>(cur_item)->get_bounds();
-                
-            // Loop until we find a feature which passes the filter
-            while(cur_item != NULL &&
-                  !filter_.pass(box2d<double>(b.w,b.s,b.e,b.n)))
-            {
-                cur_item = dataset_->next_item();
-                if(cur_item!=NULL)
-                    b = static_cast<osm_way*>(cur_item)->get_bounds();
-            }   
-                                
-            if(cur_item != NULL)
-            {
-                if(static_cast<osm_way*>(cur_item)->nodes.size())
-                {
-                    feature = feature_factory::create(feature_id_);
-                    ++feature_id_;
-                    geometry_type *geom;
-                    if(static_cast<osm_way*>(cur_item)->is_polygon())
-                        geom = new geometry_type(mapnik::Polygon);
-                    else
-                        geom = new geometry_type(mapnik::LineString);
-                    
-                    geom->set_capacity(static_cast<osm_way*>(cur_item)->
-                                       nodes.size());
-                    geom->move_to(static_cast<osm_way*>(cur_item)->
-                                  nodes[0]->lon,
-                                  static_cast<osm_way*>(cur_item)->
-                                  nodes[0]->lat);
-                                
-                    for(unsigned int count=1; count<static_cast<osm_way*>(cur_item)
-                            ->nodes.size(); count++)
-                    {
-                        geom->line_to(static_cast<osm_way*>(cur_item)
-                                      ->nodes[count]->lon,
-                                      static_cast<osm_way*>(cur_item)
-                                      ->nodes[count]->lat);
-                    }
-                    feature->add_geometry(geom);
-                    success = true;
-                }
-            }
-        }
-        
-        // can feature_ptr be compared to NULL? - no 
-        if(success)
-        {
-            std::map<std::string,std::string>::iterator i=
-                cur_item->keyvals.begin();
+        osm_node const* node = nodes[node_pos_++];
+        if (!filter_.pass(box2d<double>(node->lon,node->lat,node->lon,node->lat)))
+            continue;
+        feature_ptr feature = feature_factory::create(feature_id_);
+        ++feature_id_;
+        geometry_type * point = new geometry_type(mapnik::Point);
+        point->move_to(node->lon,node->lat);
+        feature->add_geometry(point);
+        add_attributes(feature,node);
+        return feature;
+    }
 
-            // add the keyvals to the feature. the feature seems to be a map
-            // of some sort so this should work - see dbf_file::add_attribute()
-            while(i != cur_item->keyvals.end())
-            {   
-                //only add if in the specified set of attribute names
-                if(attribute_names_.find(i->first) != attribute_names_.end())
-                    (*feature)[i->first] = tr_->transcode(i->second.c_str());
-                i++;
-            }
-            return feature;
+    std::vector<osm_way*> const& ways = dataset_->get_ways();
+    while (way_pos_ < way_ids_.size())
+    {
+        osm_way const* way = ways[way_ids_[way_pos_++]];
+        bounds b = way->get_bounds();
+        if (!filter_.pass(box2d<double>(b.w,b.s,b.e,b.n)))
+            continue;
+        feature_ptr feature = feature_factory::create(feature_id_);
+        ++feature_id_;
+        geometry_type *geom;
+        if(way->is_polygon())
+            geom = new geometry_type(mapnik::Polygon);
+        else
+            geom = new geometry_type(mapnik::LineString);
+
+        std::vector<osm_coord> const& coords = way->nodes;
+        geom->set_capacity(coords.size());
+        geom->move_to(coords[0].lon(),coords[0].lat());
+        for(unsigned int count=1; count<coords.size(); count++)
+        {
+            geom->line_to(coords[count].lon(),coords[count].lat());
         }
-    }   
+        feature->add_geometry(geom);
+        add_attributes(feature,way);
+        return feature;
+    }
     return feature_ptr();
 }
 
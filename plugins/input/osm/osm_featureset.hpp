@@ -31,6 +31,8 @@
 #include <mapnik/unicode.hpp>
 #include <mapnik/datasource.hpp>
 #include <set>
+#include <vector>
+#include <string>
 
 using mapnik::Featureset;
 using mapnik::box2d;
@@ -47,17 +49,26 @@ class osm_featureset : public Featureset
       mutable box2d<double> feature_ext_;
       mutable int total_geom_size;
       mutable int feature_id_;
-      osm_dataset *dataset_;
-      std::set<std::string> attribute_names_;
+      osm_dataset const* dataset_;
+      // requested attributes as interned key ids, so tags are matched
+      // without string compares
+      std::vector<std::pair<unsigned,std::string> > attributes_;
+      // own cursors, the dataset is shared between featuresets
+      unsigned node_pos_;
+      std::vector<unsigned> way_ids_;
+      unsigned way_pos_;
 
    public:
       osm_featureset(const filterT& filter, 
-                       osm_dataset *dataset, 
+                       box2d<double> const& query_ext,
+                       osm_dataset const* dataset, 
                        const std::set<std::string>& attribute_names,
                        std::string const& encoding);
       virtual ~osm_featureset();
       feature_ptr next();
    private:
+      void add_attributes(feature_ptr & feature, osm_item const* item);
+
       osm_featureset(const osm_featureset&);
       const osm_featureset& operator=(const osm_featureset&);
       
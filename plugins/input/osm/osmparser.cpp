@@ -14,7 +14,8 @@ using std::endl;
  bool osmparser::in_node=false, osmparser::in_way=false;
  osm_dataset* osmparser::components=NULL;
  std::string osmparser::error="";
- std::map<long,osm_node*> osmparser::tmp_node_store=std::map<long,osm_node*>();
+ long osmparser::node_id=0;
+ double osmparser::node_lat=0, osmparser::node_lon=0;
 
 void osmparser::processNode(xmlTextReaderPtr reader)
 {
@@ -26,6 +27,9 @@ void osmparser::processNode(xmlTextReaderPtr reader)
   {
     case XML_READER_TYPE_ELEMENT:
       startElement(reader,name);
+      // <node .../> and <way .../> produce no END_ELEMENT
+      if(xmlTextReaderIsEmptyElement(reader)==1)
+        endElement(name);
       break;
 
     case XML_READER_TYPE_END_ELEMENT:
@@ -43,18 +47,16 @@ void osmparser::startElement(xmlTextReaderPtr reader, const xmlChar *name)
     {
       curID = 0;
       in_node = true;
-      osm_node *node=new osm_node;
       xlat=xmlTextReaderGetAttribute(reader,BAD_CAST "lat");
       xlon=xmlTextReaderGetAttribute(reader,BAD_CAST "lon");
       xid=xmlTextReaderGetAttribute(reader,BAD_CAST "id");
       assert(xlat);
       assert(xlon);
       assert(xid);
-      node->lat=atof((char*)xlat);  
-      node->lon=atof((char*)xlon);  
-      node->id = atol((char*)xid);
-      cur_item = node;  
-      tmp_node_store[node->id] = node;
+      node_lat=atof((char*)xlat);  
+      node_lon=atof((char*)xlon);  
+      node_id = atol((char*)xid);
+      cur_item = NULL;  
       xmlFree(xid);
       xmlFree(xlon);
       xmlFree(xlat);
@@ -68,16 +70,18 @@ void osmparser::startElement(xmlTextReaderPtr reader, const xmlChar *name)
       assert(xid);
       way->id = atol((char*)xid); 
       cur_item  =  way; 
+      osm_string_table & strings = components->get_strings();
+      unsigned empty = strings.intern("");
       // Prevent ways with no name being assigned a name of "0"
-      cur_item->keyvals["name"] = ""; 
+      cur_item->set_tag(strings.intern("name"),empty); 
 
       // HACK: allows comparison with "" in the XML file. Otherwise it
       // doesn't work. Only do for the most crucial tags for Freemap's
       // purposes.  TODO investigate why this is
-      cur_item->keyvals["width"] = "";  
-      cur_item->keyvals["horse"] = "";  
-      cur_item->keyvals["foot"] = "";  
-      cur_item->keyvals["bicycle"] = "";  
+      cur_item->set_tag(strings.intern("width"),empty);  
+      cur_item->set_tag(strings.intern("horse"),empty);  
+      cur_item->set_tag(strings.intern("foot"),empty);  
+      cur_item->set_tag(strings.intern("bicycle"),empty);  
       xmlFree(xid);
     }
     else if (xmlStrEqual(name,BAD_CAST "nd"))
@@ -85,10 +89,10 @@ void osmparser::startElement(xmlTextReaderPtr reader, const xmlChar *name)
       xid=xmlTextReaderGetAttribute(reader,BAD_CAST "ref");
       assert(xid);
       long ndid = atol((char*)xid); 
-      if(tmp_node_store.find(ndid)!=tmp_node_store.end())
+      osm_coord c;
+      if(in_way && components->find_node_coord(ndid,c))
       {
-        (static_cast<osm_way*>(cur_item))->nodes.push_back
-            (tmp_node_store[ndid]);
+        (static_cast<osm_way*>(cur_item))->nodes.push_back(c);
       }
       xmlFree(xid);
     }
@@ -99,7 +103,20 @@ void osmparser::startElement(xmlTextReaderPtr reader, const xmlChar *name)
       xv = xmlTextReaderGetAttribute(reader,BAD_CAST "v");
       assert(xk);
       assert(xv);
-      cur_item->keyvals[(char*)xk] = (char*)xv; 
+      if(in_node && cur_item==NULL)
+      {
+        // first tag, the node is a feature of its own
+        osm_node *node=new osm_node;
+        node->id = node_id;
+        node->lat = node_lat;
+        node->lon = node_lon;
+        cur_item = node;
+      }
+      if(cur_item!=NULL)
+      {
+        osm_string_table & strings = components->get_strings();
+        cur_item->set_tag(strings.intern((char*)xk),strings.intern((char*)xv)); 
+      }
       xmlFree(xk);
       xmlFree(xv);
     }
@@ -109,13 +126,24 @@ void osmparser::endElement(const xmlChar* name)
 {
   if(xmlStrEqual(name,BAD_CAST "node"))
   {
-    in_node = false;
-    components->add_node(static_cast<osm_node*>(cur_item));
+    endNode();
   }
   else if(xmlStrEqual(name,BAD_CAST "way"))
   {
     in_way = false;
     components->add_way(static_cast<osm_way*>(cur_item));
+    cur_item = NULL;
+  }
+}
+
+void osmparser::endNode()
+{
+  in_node = false;
+  components->add_node_coord(node_id,node_lon,node_lat);
+  if(cur_item!=NULL)
+  {
+    components->add_node(static_cast<osm_node*>(cur_item));
+    cur_item = NULL;
   }
 }
 
@@ -153,5 +181,6 @@ int osmparser::do_parse(xmlTextReaderPtr reader)
       ret=xmlTextReaderRead(reader);
     }
   }
+  components->finish();
   return ret;
 }
@@ -15,7 +15,10 @@ private:
     static bool in_node, in_way; 
     static osm_dataset* components;
     static std::string error;
-    static std::map<long,osm_node*> tmp_node_store;
+    // attributes of the node being read, it only becomes an osm_node
+    // once a tag shows up
+    static long node_id;
+    static double node_lat, node_lon;
 
   static int do_parse(xmlTextReaderPtr);
 
@@ -23,6 +26,7 @@ public:
     static void processNode(xmlTextReaderPtr reader);
     static void startElement(xmlTextReaderPtr reader, const xmlChar *name);
     static void endElement(const xmlChar* name);
+    static void endNode();
     static bool parse(osm_dataset *ds, const char* filename);
     static bool parse(osm_dataset *ds, char* data,int nbytes);
 };
@@ -13,7 +13,7 @@ int main(int argc,char* argv[])
     dataset.rewind();
     while((item=dataset.next_item())!=NULL)
     {
-      std::cerr << item->to_string() << endl;
+      std::cerr << item->to_string(dataset.get_strings()) << endl;
     }
   }
   else
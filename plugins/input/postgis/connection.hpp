@@ -108,7 +108,16 @@ class Connection
       
       bool isOK() const
       {
-         return (PQstatus(conn_)!=CONNECTION_BAD);
+         return (!closed_ && PQstatus(conn_)!=CONNECTION_BAD);
+      }
+
+      // round trip to the server, for connections idle for a while
+      bool ping() const
+      {
+         PGresult *result=PQexec(conn_,"SELECT 1");
+         bool ok=(result && PQresultStatus(result)==PGRES_TUPLES_OK);
+         PQclear(result);
+         return ok;
       }
       
       void close()
@@ -100,18 +100,23 @@ class ConnectionManager : public singleton <ConnectionManager,CreateStatic>
     typedef std::map<std::string,boost::shared_ptr<PoolType> > ContType;
     typedef boost::shared_ptr<Connection> HolderType;   
     ContType pools_;
+#ifdef MAPNIK_THREADSAFE
+    mutex mutex_;
+#endif
 
 public:
         
-    bool registerPool(const ConnectionCreator<Connection>& creator,unsigned initialSize,unsigned maxSize) 
+    bool registerPool(const ConnectionCreator<Connection>& creator,unsigned initialSize,unsigned maxSize,
+                      double timeout=0.0, double ping_interval=0.0) 
     {       
 #ifdef MAPNIK_THREADSAFE
-        //mutex::scoped_lock lock(mutex_);
+        mutex::scoped_lock lock(mutex_);
 #endif
         if (pools_.find(creator.id())==pools_.end())
         {
             return pools_.insert(std::make_pair(creator.id(),
-                                                boost::shared_ptr<PoolType>(new PoolType(creator,initialSize,maxSize)))).second;
+                                                boost::shared_ptr<PoolType>(new PoolType(creator,initialSize,maxSize,
+                                                                                         timeout,ping_interval)))).second;
         }
 
         return false;
@@ -121,7 +126,7 @@ public:
     boost::shared_ptr<PoolType> getPool(std::string const& key) 
     {
 #ifdef MAPNIK_THREADSAFE
-        //mutex::scoped_lock lock(mutex_);
+        mutex::scoped_lock lock(mutex_);
 #endif 
         ContType::const_iterator itr=pools_.find(key);
         if (itr!=pools_.end())
@@ -134,13 +139,10 @@ public:
         
     HolderType get(std::string const& key)
     {
-#ifdef MAPNIK_THREADSAFE
-        //mutex::scoped_lock lock(mutex_);
-#endif 
-        ContType::const_iterator itr=pools_.find(key);
-        if (itr!=pools_.end()) 
+        // borrowing may wait, so not under mutex_
+        boost::shared_ptr<PoolType> pool=getPool(key);
+        if (pool) 
         {
-            boost::shared_ptr<PoolType> pool=itr->second;
             return pool->borrowObject();
         }
         return HolderType();
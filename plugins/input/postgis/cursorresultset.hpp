@@ -4,9 +4,17 @@
 #include "connection.hpp"
 #include "resultset.hpp"
 
+// boost
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+// stl
+#include <algorithm>
+
 class CursorResultSet : public IResultSet
 {
 private:
+    enum { fetch_bytes = 4 * 1024 * 1024 };
+
     boost::shared_ptr<Connection> conn_;
     std::string cursorName_;
     boost::shared_ptr<ResultSet> rs_;
@@ -21,11 +29,26 @@ private:
 #ifdef MAPNIK_DEBUG
         std::clog << "Postgis Plugin: " << s.str() << std::endl;
 #endif
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
         rs_ = conn_->executeQuery(s.str());
         is_closed_ = false;
 #ifdef MAPNIK_DEBUG
         std::clog << "Postgis Plugin: FETCH result (" << cursorName_ << "): " << rs_->size() << " rows" << std::endl;
 #endif
+        boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+        adapt_fetch_size(elapsed.total_microseconds() * 1e-6);
+    }
+
+    // the next FETCH doubles while round trips stay quick, up to about
+    // fetch_bytes worth of rows as wide as the ones just fetched
+    void adapt_fetch_size(double seconds)
+    {
+        int rows = rs_->size();
+        if (rows < fetch_size_) return; // no more rows to come
+        double row_bytes = std::max(1.0, double(rs_->bytes()) / rows);
+        int by_width = std::max(1, int(fetch_bytes / row_bytes));
+        int next = (seconds < 0.25) ? fetch_size_ * 2 : fetch_size_;
+        fetch_size_ = std::min(next, by_width);
     }
     
 public:
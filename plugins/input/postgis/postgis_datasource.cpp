@@ -110,9 +110,13 @@ void postgis_datasource::bind() const
     
     boost::optional<int> initial_size = params_.get<int>("initial_size",1);
     boost::optional<int> max_size = params_.get<int>("max_size",10);
+    // seconds to wait for a connection when all max_size are in use
+    boost::optional<double> borrow_timeout = params_.get<double>("borrow_timeout",2.0);
+    // seconds a connection may be idle before it is pinged on borrow
+    boost::optional<double> ping_interval = params_.get<double>("ping_interval",30.0);
 
     ConnectionManager *mgr=ConnectionManager::instance();   
-    mgr->registerPool(creator_, *initial_size, *max_size);
+    mgr->registerPool(creator_, *initial_size, *max_size, *borrow_timeout, *ping_interval);
     
     shared_ptr<Pool<Connection,ConnectionCreator> > pool=mgr->getPool(creator_.id());
     if (pool)
@@ -480,6 +484,16 @@ featureset_ptr postgis_datasource::features(const query& q) const
             boost::shared_ptr<IResultSet> rs = get_resultset(conn, s.str());
             return boost::make_shared<postgis_featureset>(rs,desc_.get_encoding(),multiple_geometries_,!key_field_.empty(),props.size());
         }
+        else if (!conn)
+        {
+            mapnik::pool_stats stats = pool->stats();
+            std::ostringstream s;
+            s << "Postgis Plugin: no connection available, pool exhausted "
+              << stats.timeouts << " times (" << stats.waited << " of "
+              << stats.borrowed << " borrows waited, longest for "
+              << stats.max_borrow_time << "s)";
+            throw mapnik::datasource_exception(s.str());
+        }
         else 
         {
             throw mapnik::datasource_exception("Postgis Plugin: bad connection");
@@ -667,6 +681,8 @@ postgis_datasource::~postgis_datasource()
             shared_ptr<Connection> conn = pool->borrowObject();
             if (conn)
             {
+                // dropped by the pool once closed
+                PoolGuard<shared_ptr<Connection>,shared_ptr<Pool<Connection,ConnectionCreator> > > guard(conn,pool);
                 conn->close();
             }
         }
@@ -34,16 +34,13 @@
 #include "cursorresultset.hpp"
 
 // boost
-#include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
 
 // stl
 #include <sstream>
 #include <string>
+#include <cctype>
 
-using boost::lexical_cast;
-using boost::bad_lexical_cast;
-using boost::trim_copy;
 using mapnik::geometry_type;
 using mapnik::byte;
 using mapnik::geometry_utils;
@@ -60,7 +57,24 @@ postgis_featureset::postgis_featureset(boost::shared_ptr<IResultSet> const& rs,
       tr_(new transcoder(encoding)),
       totalGeomSize_(0),
       feature_id_(1),
-      key_field_(key_field)  {}
+      key_field_(key_field),
+      columns_resolved_(false)  {}
+
+void postgis_featureset::resolve_columns()
+{
+    // geometry first, then the key field if any
+    int first = key_field_ ? 2 : 1;
+    int count = rs_->getNumFields();
+    columns_.reserve(num_attrs_);
+    for (int pos = first; pos < count; ++pos)
+    {
+        column col;
+        col.name = rs_->getFieldName(pos);
+        col.oid = rs_->getTypeOID(pos);
+        columns_.push_back(col);
+    }
+    columns_resolved_ = true;
+}
 
 feature_ptr postgis_featureset::next()
 {
@@ -104,75 +118,80 @@ feature_ptr postgis_featureset::next()
         geometry_utils::from_wkb(*feature,data,size,multiple_geometries_);
         totalGeomSize_+=size;
           
-        for ( ;pos<num_attrs_+1;++pos)
+        if (!columns_resolved_) resolve_columns();
+
+        for (std::vector<column>::const_iterator col = columns_.begin(); col != columns_.end(); ++col, ++pos)
         {
-            std::string name = rs_->getFieldName(pos);
+            if (rs_->isNull(pos)) continue;
 
-            if (!rs_->isNull(pos))
+            const char* buf = rs_->getValue(pos);
+            switch (col->oid)
             {
-                const char* buf = rs_->getValue(pos);
-                int oid = rs_->getTypeOID(pos);
-           
-                if (oid==16) //bool
-                {
-                    boost::put(*feature,name,buf[0] != 0);
-                }
-                else if (oid==23) //int4
-                {
-                    int val = int4net(buf);
-                    boost::put(*feature,name,val);
-                }
-                else if (oid==21) //int2
-                {
-                    int val = int2net(buf);
-                    boost::put(*feature,name,val);
-                }
-                else if (oid==20) //int8/BigInt
-                {
-                    int val = int8net(buf);
-                    boost::put(*feature,name,val);
-                }
-                else if (oid == 700) // float4
-                {
-                    float val;
-                    float4net(val,buf);
-                    boost::put(*feature,name,val);
-                }
-                else if (oid == 701) // float8
-                {
-                    double val;
-                    float8net(val,buf);
-                    boost::put(*feature,name,val);
-                }
-                else if (oid==25 || oid==1043) // text or varchar
-                {
-                    UnicodeString ustr = tr_->transcode(buf);
-                    boost::put(*feature,name,ustr);
-                }
-                else if (oid==1042)
-                {
-                    UnicodeString ustr = tr_->transcode(trim_copy(std::string(buf)).c_str()); // bpchar
-                    boost::put(*feature,name,ustr);
-                }
-                else if (oid == 1700) // numeric
+            case 16: //bool
+                boost::put(*feature,col->name,buf[0] != 0);
+                break;
+            case 23: //int4
+            {
+                int val = int4net(buf);
+                boost::put(*feature,col->name,val);
+                break;
+            }
+            case 21: //int2
+            {
+                int val = int2net(buf);
+                boost::put(*feature,col->name,val);
+                break;
+            }
+            case 20: //int8/BigInt
+            {
+                int val = int8net(buf);
+                boost::put(*feature,col->name,val);
+                break;
+            }
+            case 700: // float4
+            {
+                float val;
+                float4net(val,buf);
+                boost::put(*feature,col->name,val);
+                break;
+            }
+            case 701: // float8
+            {
+                double val;
+                float8net(val,buf);
+                boost::put(*feature,col->name,val);
+                break;
+            }
+            case 25: // text
+            case 1043: // varchar
+            {
+                UnicodeString ustr = tr_->transcode(buf,rs_->getFieldLength(pos));
+                boost::put(*feature,col->name,ustr);
+                break;
+            }
+            case 1042: // bpchar
+            {
+                const char* end = buf + rs_->getFieldLength(pos);
+                while (buf < end && std::isspace((unsigned char)*buf)) ++buf;
+                while (end > buf && std::isspace((unsigned char)*(end - 1))) --end;
+                UnicodeString ustr = tr_->transcode(buf,end - buf);
+                boost::put(*feature,col->name,ustr);
+                break;
+            }
+            case 1700: // numeric
+            {
+                double val;
+                if (mapnik::numeric2double(buf,val))
                 {
-                    std::string str = mapnik::numeric2string(buf);
-                    try 
-                    {
-                        double val = boost::lexical_cast<double>(str);
-                        boost::put(*feature,name,val);
-                    }
-                    catch (boost::bad_lexical_cast & ex)
-                    {
-                        std::clog << ex.what() << "\n"; 
-                    }
+                    boost::put(*feature,col->name,val);
                 }
-                else 
-                {
+                break;
+            }
+            default:
 #ifdef MAPNIK_DEBUG
-                    std::clog << "Postgis Plugin: uknown OID = " << oid << " FIXME " << std::endl;
+                std::clog << "Postgis Plugin: uknown OID = " << col->oid << " FIXME " << std::endl;
 #endif
-                }
+                break;
             }
         }
         return feature;
@@ -33,6 +33,10 @@
 
 #include <boost/scoped_ptr.hpp>
 
+// stl
+#include <string>
+#include <vector>
+
 using mapnik::Featureset;
 using mapnik::box2d;
 using mapnik::feature_ptr;
@@ -50,6 +54,15 @@ private:
     int totalGeomSize_;
     int feature_id_;
     bool key_field_;
+    // attribute columns, resolved from the first row
+    struct column
+    {
+        std::string name;
+        int oid;
+    };
+    std::vector<column> columns_;
+    bool columns_resolved_;
+    void resolve_columns();
 public:
     postgis_featureset(boost::shared_ptr<IResultSet> const& rs,
                        std::string const& encoding,
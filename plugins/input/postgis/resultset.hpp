@@ -120,6 +120,21 @@ public:
         return numTuples_;
     }
 
+    // bytes of all values, the width of the rows fetched
+    long bytes() const
+    {
+        long total = 0;
+        int fields = PQnfields(res_);
+        for (int row = 0; row < numTuples_; ++row)
+        {
+            for (int col = 0; col < fields; ++col)
+            {
+                total += PQgetlength(res_,row,col);
+            }
+        }
+        return total;
+    }
+
     virtual bool next()
     {
         return (++pos_<numTuples_);
@@ -51,7 +51,15 @@ shape_index_featureset<filterT>::shape_index_featureset(const filterT& filter,
 {
     shape_.shp().skip(100);
     boost::shared_ptr<shape_file> index = shape_.index();
-    if (index)
+    if (shape_.rtree_index())
+    {
+        mapnik::mapped_region_ptr const& region = *shape_.rtree_index();
+        shp_rtree::query(filter,
+                         static_cast<const char*>(region->get_address()),
+                         region->get_size(),
+                         ids_);
+    }
+    else if (index)
     {
 #ifdef SHAPE_MEMORY_MAPPED_FILE
         //shp_index<filterT,stream<mapped_file_source> >::query(filter,index->file(),ids_);
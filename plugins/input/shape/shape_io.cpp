@@ -55,6 +55,17 @@ shape_io::shape_io(const std::string& shape_name, bool open_index)
         {
             
             index_= boost::make_shared<shape_file>(shape_name + INDEX);
+            if (index_->is_open())
+            {
+                char header[shp_rtree::header_size];
+                index_->file().read(header, shp_rtree::header_size);
+                if (index_->file() && shp_rtree::is_rtree(header, shp_rtree::header_size))
+                {
+                    rtree_ = mapnik::mapped_memory_cache::find(shape_name + INDEX, true);
+                }
+                index_->file().clear();
+                index_->seek(0);
+            }
         }
         catch (...)
         {
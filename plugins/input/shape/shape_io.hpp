@@ -30,6 +30,7 @@
 // boost
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/optional.hpp>
 
 struct shape_io : boost::noncopyable
 {
@@ -42,6 +43,8 @@ struct shape_io : boost::noncopyable
     //shape_file shx_;
     dbf_file   dbf_;
     boost::shared_ptr<shape_file>  index_;
+    // mapped version 2 (packed R-tree) index
+    boost::optional<mapnik::mapped_region_ptr> rtree_;
     unsigned reclength_;
     unsigned id_;
     box2d<double> cur_extent_;
@@ -80,6 +83,11 @@ public:
     {
         return (index_ && index_->is_open());
     }
+
+    inline boost::optional<mapnik::mapped_region_ptr> const& rtree_index() const
+    {
+        return rtree_;
+    }
     void move_to(int id);
     int type() const;
     const box2d<double>& current_extent() const;
@@ -26,9 +26,13 @@
 // st
 #include <fstream>
 #include <vector>
+#include <cstring>
 // mapnik
+#include <mapnik/global.hpp>
 #include <mapnik/box2d.hpp>
 #include <mapnik/query.hpp>
+// boost
+#include <boost/cstdint.hpp>
 
 using mapnik::box2d;
 using mapnik::query;
@@ -102,4 +106,84 @@ void shp_index<filterT,IStream>::read_envelope(IStream & file,box2d<double>& env
 }
 
 
+/*
+ * Index format version 2, a packed R-tree bulk loaded from the shapes
+ * sorted along a Hilbert curve (see utils/shapeindex/packed_rtree.hpp).
+ * The file is an array of fixed size nodes, the header filling node 0:
+ *
+ *   header : "mapnik" 6 bytes, format version (2) 1 byte, 1 byte unused,
+ *            node_size, num_items, num_nodes, num_leaves (int32 NDR)
+ *   nodes  : node_size entries each, root first and leaves last
+ *   entry  : minx, miny, maxx, maxy (double NDR), value (int32 NDR),
+ *            4 bytes unused
+ *
+ * For leaves the value is the offset of the shape in the .shp file,
+ * for inner nodes the number of the child node. Entries are packed at
+ * the front of a node and the remaining ones have a negative value.
+ * Nodes are read in place, typically from a memory mapped file.
+ */
+struct shp_rtree
+{
+    enum
+    {
+        version = 2,
+        header_size = 24,
+        entry_size = 40,
+        min_node_size = 2,
+        max_node_size = 1024
+    };
+
+    static bool is_rtree(const char* data, size_t size)
+    {
+        return size >= unsigned(header_size)
+            && std::memcmp(data, "mapnik", 6) == 0
+            && data[6] == version;
+    }
+
+    template <typename filterT>
+    static void query(const filterT& filter, const char* data, size_t size, std::vector<int>& pos)
+    {
+        if (!is_rtree(data, size)) return;
+
+        boost::int32_t node_size, num_nodes, num_leaves;
+        mapnik::read_int32_ndr(data + 8, node_size);
+        mapnik::read_int32_ndr(data + 16, num_nodes);
+        mapnik::read_int32_ndr(data + 20, num_leaves);
+
+        if (node_size < min_node_size || node_size > max_node_size
+            || num_leaves > num_nodes || num_nodes <= 0) return;
+
+        const size_t node_bytes = size_t(node_size) * entry_size;
+        // truncated files are ignored rather than read out of bounds
+        if ((size_t(num_nodes) + 1) * node_bytes > size) return;
+
+        const boost::int32_t first_leaf = num_nodes - num_leaves;
+        std::vector<boost::int32_t> nodes;
+        nodes.push_back(0);
+        while (!nodes.empty())
+        {
+            const boost::int32_t node = nodes.back();
+            nodes.pop_back();
+            const bool leaf = node >= first_leaf;
+            const char* entry = data + (size_t(node) + 1) * node_bytes;
+            for (int i = 0; i < node_size; ++i, entry += entry_size)
+            {
+                boost::int32_t value;
+                mapnik::read_int32_ndr(entry + 32, value);
+                if (value < 0) break;
+
+                double minx, miny, maxx, maxy;
+                mapnik::read_double_ndr(entry, minx);
+                mapnik::read_double_ndr(entry + 8, miny);
+                mapnik::read_double_ndr(entry + 16, maxx);
+                mapnik::read_double_ndr(entry + 24, maxy);
+                if (!filter.pass(box2d<double>(minx, miny, maxx, maxy))) continue;
+
+                if (leaf) pos.push_back(value);
+                else if (value > node && value < num_nodes) nodes.push_back(value);
+            }
+        }
+    }
+};
+
 #endif //SHP_INDEX_HH
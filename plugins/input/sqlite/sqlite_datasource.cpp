@@ -114,7 +114,25 @@ void sqlite_datasource::bind() const
     if (!boost::filesystem::exists(dataset_name_))
         throw datasource_exception("Sqlite Plugin: " + dataset_name_ + " does not exist");
           
-    dataset_ = new sqlite_connection (dataset_name_);
+    dataset_ = boost::make_shared<sqlite_connection>(dataset_name_);
+
+    // optional tuning, e.g. a larger page cache for big tables or
+    // memory mapped reads (sqlite >= 3.7.17 only, ignored before)
+    boost::optional<int> cache_size = params_.get<int>("cache_size");
+    if (cache_size)
+    {
+        std::ostringstream s;
+        s << "PRAGMA cache_size=" << *cache_size;
+        dataset_->execute (s.str());
+    }
+
+    boost::optional<int> mmap_size = params_.get<int>("mmap_size");
+    if (mmap_size)
+    {
+        std::ostringstream s;
+        s << "PRAGMA mmap_size=" << *mmap_size;
+        dataset_->execute (s.str());
+    }
 
     if(geometry_table_.empty())
     {
@@ -326,10 +344,6 @@ void sqlite_datasource::bind() const
 
 sqlite_datasource::~sqlite_datasource()
 {
-    if (is_bound_) 
-    {
-        delete dataset_;
-    }
 }
 
 std::string sqlite_datasource::name()
@@ -354,63 +368,104 @@ layer_descriptor sqlite_datasource::get_descriptor() const
    return desc_;
 }
 
-featureset_ptr sqlite_datasource::features(query const& q) const
+std::string sqlite_datasource::select_sql(std::vector<std::string> const& names) const
 {
-   if (!is_bound_) bind();
-   if (dataset_)
-   {
-        mapnik::box2d<double> const& e = q.get_bbox();
+    const bool plain_table = boost::algorithm::iequals(table_, geometry_table_);
+    const std::string index_table = "idx_" + geometry_table_ + "_" + geometry_field_;
 
-        std::ostringstream s;
-        
-        s << "SELECT " << geometry_field_ << "," << key_field_;
-        std::set<std::string> const& props = q.property_names();
-        std::set<std::string>::const_iterator pos = props.begin();
-        std::set<std::string>::const_iterator end = props.end();
-        while (pos != end)
-        {
-            s << ",\"" << *pos << "\"";
-            ++pos;
-        }       
-        
-        s << " FROM "; 
-        
-        std::string query (table_); 
-        
-        if (use_spatial_index_)
+    std::ostringstream s;
+
+    // columns are qualified when joining the index, its xmin/.../pkid
+    // columns could clash with the ones of the table
+    std::string prefix;
+    if (use_spatial_index_ && plain_table) prefix = table_ + ".";
+
+    s << "SELECT " << prefix << geometry_field_ << "," << prefix << key_field_;
+    std::vector<std::string>::const_iterator pos = names.begin();
+    std::vector<std::string>::const_iterator end = names.end();
+    while (pos != end)
+    {
+        s << "," << prefix << "\"" << *pos << "\" AS \"" << *pos << "\"";
+        ++pos;
+    }
+
+    s << " FROM ";
+
+    std::string query (table_);
+
+    // the bbox is bound as parameters 1-4 (minx, maxx, miny, maxy),
+    // so the statement text only depends on the requested columns
+    // and its compiled form can be reused
+    if (use_spatial_index_)
+    {
+        if (plain_table)
         {
-           std::ostringstream spatial_sql;
-           spatial_sql << std::setprecision(16);
-           spatial_sql << " WHERE " << key_field_ << " IN (SELECT pkid FROM idx_" << geometry_table_ << "_" << geometry_field_;
-           spatial_sql << " WHERE xmax>=" << e.minx() << " AND xmin<=" << e.maxx() ;
-           spatial_sql << " AND ymax>=" << e.miny() << " AND ymin<=" << e.maxy() << ")";
-           if (boost::algorithm::ifind_first(query, "WHERE"))
-           {
-              boost::algorithm::ireplace_first(query, "WHERE", spatial_sql.str() + " AND ");
-           }
-           else if (boost::algorithm::ifind_first(query, geometry_table_))  
-           {
-              boost::algorithm::ireplace_first(query, table_, table_ + " " + spatial_sql.str());
-           }
+            // drive the scan from the rtree and look up matching rows,
+            // CROSS JOIN keeps sqlite from reordering the loops
+            query = index_table + " CROSS JOIN " + table_
+                + " WHERE " + table_ + "." + key_field_ + "=" + index_table + ".pkid"
+                + " AND " + index_table + ".xmax>=?1 AND " + index_table + ".xmin<=?2"
+                + " AND " + index_table + ".ymax>=?3 AND " + index_table + ".ymin<=?4";
         }
-        
-        s << query ;
-        
-        if (row_limit_ > 0) {
-            s << " LIMIT " << row_limit_;
+        else
+        {
+            // subqueries are filtered in place
+            std::ostringstream spatial_sql;
+            spatial_sql << " WHERE " << key_field_ << " IN (SELECT pkid FROM " << index_table;
+            spatial_sql << " WHERE xmax>=?1 AND xmin<=?2 AND ymax>=?3 AND ymin<=?4)";
+            if (boost::algorithm::ifind_first(query, "WHERE"))
+            {
+                boost::algorithm::ireplace_first(query, "WHERE", spatial_sql.str() + " AND ");
+            }
+            else if (boost::algorithm::ifind_first(query, geometry_table_))
+            {
+                boost::algorithm::ireplace_first(query, table_, table_ + " " + spatial_sql.str());
+            }
         }
+    }
 
-        if (row_offset_ > 0) {
-            s << " OFFSET " << row_offset_;
-        }
+    s << query ;
+
+    if (row_limit_ > 0) {
+        s << " LIMIT " << row_limit_;
+    }
+
+    if (row_offset_ > 0) {
+        s << " OFFSET " << row_offset_;
+    }
+
+    return s.str();
+}
+
+featureset_ptr sqlite_datasource::query_features(box2d<double> const& e, std::vector<std::string> const& names) const
+{
+    std::string sql = select_sql(names);
 
 #ifdef MAPNIK_DEBUG
-        std::clog << "Sqlite Plugin: " << s.str() << std::endl;
+    std::clog << "Sqlite Plugin: " << sql << std::endl;
 #endif
 
-        boost::shared_ptr<sqlite_resultset> rs (dataset_->execute_query (s.str()));
+    boost::shared_ptr<sqlite_resultset> rs (dataset_->execute_prepared_query (sql));
+    if (use_spatial_index_)
+    {
+        rs->bind_double (1, e.minx());
+        rs->bind_double (2, e.maxx());
+        rs->bind_double (3, e.miny());
+        rs->bind_double (4, e.maxy());
+    }
+
+    return boost::make_shared<sqlite_featureset>(rs, desc_.get_encoding(), format_, multiple_geometries_);
+}
+
+featureset_ptr sqlite_datasource::features(query const& q) const
+{
+   if (!is_bound_) bind();
+   if (dataset_)
+   {
+        std::set<std::string> const& props = q.property_names();
+        std::vector<std::string> names (props.begin(), props.end());
 
-        return boost::make_shared<sqlite_featureset>(rs, desc_.get_encoding(), format_, multiple_geometries_);
+        return query_features(q.get_bbox(), names);
    }
 
    return featureset_ptr();
@@ -425,58 +480,19 @@ featureset_ptr sqlite_datasource::features_at_point(coord2d const& pt) const
         // TODO - need tolerance
         mapnik::box2d<double> const e(pt.x,pt.y,pt.x,pt.y);
 
-        std::ostringstream s;
-        s << "SELECT " << geometry_field_ << "," << key_field_;
+        std::vector<std::string> names;
         std::vector<attribute_descriptor>::const_iterator itr = desc_.get_descriptors().begin();
         std::vector<attribute_descriptor>::const_iterator end = desc_.get_descriptors().end();
         while (itr != end)
         {
             std::string fld_name = itr->get_name();
             if (fld_name != key_field_)
-                s << ",\"" << itr->get_name() << "\"";
+                names.push_back(fld_name);
             ++itr;
         }
-        
-        s << " FROM "; 
-        
-        std::string query (table_); 
-        
-        if (use_spatial_index_)
-        {
-           std::ostringstream spatial_sql;
-           spatial_sql << std::setprecision(16);
-           spatial_sql << " WHERE " << key_field_ << " IN (SELECT pkid FROM idx_" << geometry_table_ << "_" << geometry_field_;
-           spatial_sql << " WHERE xmax>=" << e.minx() << " AND xmin<=" << e.maxx() ;
-           spatial_sql << " AND ymax>=" << e.miny() << " AND ymin<=" << e.maxy() << ")";
-           if (boost::algorithm::ifind_first(query, "WHERE"))
-           {
-              boost::algorithm::ireplace_first(query, "WHERE", spatial_sql.str() + " AND ");
-           }
-           else if (boost::algorithm::ifind_first(query, geometry_table_))  
-           {
-              boost::algorithm::ireplace_first(query, table_, table_ + " " + spatial_sql.str());
-           }
-        }
-        
-        s << query ;
-        
-        if (row_limit_ > 0) {
-            s << " LIMIT " << row_limit_;
-        }
-
-        if (row_offset_ > 0) {
-            s << " OFFSET " << row_offset_;
-        }
-
-#ifdef MAPNIK_DEBUG
-        std::clog << "Sqlite Plugin: " << s.str() << std::endl;
-#endif
 
-        boost::shared_ptr<sqlite_resultset> rs (dataset_->execute_query (s.str()));
-
-        return boost::make_shared<sqlite_featureset>(rs, desc_.get_encoding(), format_, multiple_geometries_);
+        return query_features(e, names);
    }
       
    return featureset_ptr();
 }
-
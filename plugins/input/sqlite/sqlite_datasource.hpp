@@ -34,6 +34,10 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 
+// stl
+#include <string>
+#include <vector>
+
 // sqlite
 #include "sqlite_types.hpp"
 
@@ -50,11 +54,13 @@ class sqlite_datasource : public mapnik::datasource
       mapnik::layer_descriptor get_descriptor() const;
       void bind() const;
    private:
+      std::string select_sql(std::vector<std::string> const& names) const;
+      mapnik::featureset_ptr query_features(mapnik::box2d<double> const& e, std::vector<std::string> const& names) const;
       mutable mapnik::box2d<double> extent_;
       mutable bool extent_initialized_;
       int type_;
       std::string dataset_name_;
-      mutable sqlite_connection* dataset_;
+      mutable boost::shared_ptr<sqlite_connection> dataset_;
       std::string table_;
       std::string fields_;
       std::string metadata_;
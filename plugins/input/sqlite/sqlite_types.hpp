@@ -29,6 +29,16 @@
 
 // boost
 #include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/utility.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
+
+// stl
+#include <map>
+#include <sstream>
+#include <string>
 
 // sqlite
 extern "C" {
@@ -36,6 +46,8 @@ extern "C" {
 }
 
 
+class sqlite_connection;
+
 class sqlite_resultset
 {
 public:
@@ -45,10 +57,22 @@ public:
     {
     }
 
-    ~sqlite_resultset ()
+    // a statement borrowed from the cache of conn, given back
+    // (instead of finalized) when the resultset is destroyed
+    sqlite_resultset (sqlite3_stmt* stmt,
+                      boost::shared_ptr<sqlite_connection> const& conn,
+                      std::string const& sql)
+        : stmt_(stmt),
+          conn_(conn),
+          sql_(sql)
     {
-        if (stmt_)
-            sqlite3_finalize (stmt_);
+    }
+
+    ~sqlite_resultset ();
+
+    void bind_double (int index, double value)
+    {
+        sqlite3_bind_double (stmt_, index, value);
     }
 
     bool is_valid ()
@@ -111,33 +135,106 @@ public:
 private:
 
     sqlite3_stmt* stmt_;
+    boost::shared_ptr<sqlite_connection> conn_;
+    std::string sql_;
 };
 
 
 
-class sqlite_connection
+// The database is opened read-only in serialized mode, so a single
+// connection can be shared by every thread rendering the datasource.
+class sqlite_connection : public boost::enable_shared_from_this<sqlite_connection>,
+                          private boost::noncopyable
 {
 public:
 
     sqlite_connection (const std::string& file)
         : db_(0)
     {
-        if (sqlite3_open (file.c_str(), &db_))
+        if (sqlite3_open_v2 (file.c_str(), &db_, SQLITE_OPEN_READONLY | SQLITE_OPEN_FULLMUTEX, 0))
         {
             std::ostringstream s;
             s << "Sqlite Plugin: ";
-            throw mapnik::datasource_exception (sqlite3_errmsg (db_));
+            if (db_)
+            {
+                s << sqlite3_errmsg (db_);
+                sqlite3_close (db_);
+                db_ = 0;
+            }
+            else
+                s << "could not open '" << file << "'";
+            throw mapnik::datasource_exception (s.str());
         }
         //sqlite3_enable_load_extension(db_, 1);
     }
 
     ~sqlite_connection ()
     {
+        for (statement_cache::iterator itr = statements_.begin(); itr != statements_.end(); ++itr)
+            sqlite3_finalize (itr->second);
         if (db_)
             sqlite3_close (db_);
     }
 
     sqlite_resultset* execute_query(const std::string& sql)
+    {
+        return new sqlite_resultset (prepare (sql));
+    }
+
+    // Same as execute_query but the compiled statement is kept for the
+    // next query with the same sql. Parameters are bound on the result.
+    boost::shared_ptr<sqlite_resultset> execute_prepared_query(const std::string& sql)
+    {
+        sqlite3_stmt* stmt = 0;
+        {
+#ifdef MAPNIK_THREADSAFE
+            boost::mutex::scoped_lock lock(mutex_);
+#endif
+            statement_cache::iterator itr = statements_.find (sql);
+            if (itr != statements_.end())
+            {
+                stmt = itr->second;
+                statements_.erase (itr);
+            }
+        }
+
+        if (! stmt)
+            stmt = prepare (sql);
+
+        return boost::shared_ptr<sqlite_resultset>(new sqlite_resultset (stmt, shared_from_this(), sql));
+    }
+
+    void release_statement(const std::string& sql, sqlite3_stmt* stmt)
+    {
+        sqlite3_reset (stmt);
+        sqlite3_clear_bindings (stmt);
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        statements_.insert (std::make_pair (sql, stmt));
+    }
+
+    void execute(const std::string& sql)
+    {
+        char* err = 0;
+        if (sqlite3_exec (db_, sql.c_str(), 0, 0, &err) != SQLITE_OK)
+        {
+            std::ostringstream s;
+            s << "Sqlite Plugin: '" << (err ? err : "unknown error") << "'";
+            s << "\nFull sql was: '" <<  sql << "'\n";
+            sqlite3_free (err);
+            throw mapnik::datasource_exception( s.str() );
+        }
+    }
+
+    sqlite3* operator*()
+    {
+        return db_;
+    }
+
+private:
+
+    sqlite3_stmt* prepare(const std::string& sql)
     {
         sqlite3_stmt* stmt = 0;
 
@@ -155,18 +252,28 @@ public:
             throw mapnik::datasource_exception( s.str() );
         }
 
-        return new sqlite_resultset (stmt);
-  }
-
-    sqlite3* operator*()
-    {
-        return db_;
+        return stmt;
     }
 
-private:
+    typedef std::multimap<std::string, sqlite3_stmt*> statement_cache;
 
     sqlite3* db_;
+    // idle prepared statements, keyed by their sql
+    statement_cache statements_;
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex mutex_;
+#endif
 };
 
-#endif //SQLITE_TYPES_HPP
+inline sqlite_resultset::~sqlite_resultset ()
+{
+    if (stmt_)
+    {
+        if (conn_)
+            conn_->release_statement (sql_, stmt_);
+        else
+            sqlite3_finalize (stmt_);
+    }
+}
 
+#endif //SQLITE_TYPES_HPP
@@ -24,6 +24,7 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/agg_pattern_cache.hpp>
 #include <mapnik/marker_cache.hpp>
 #include <mapnik/unicode.hpp>
 #include <mapnik/placement_finder.hpp>
@@ -84,33 +85,6 @@
 
 namespace mapnik
 {
-class pattern_source : private boost::noncopyable
-{
-public:
-    pattern_source(image_data_32 const& pattern)
-        : pattern_(pattern) {}
-
-    unsigned int width() const
-    {
-        return pattern_.width();
-    }
-    unsigned int height() const
-    {
-        return pattern_.height();
-    }
-    agg::rgba8 pixel(int x, int y) const
-    {
-        unsigned c = pattern_(x,y);
-        return agg::rgba8(c & 0xff,
-                          (c >> 8) & 0xff,
-                          (c >> 16) & 0xff,
-                          (c >> 24) & 0xff);
-    }
-private:
-    image_data_32 const& pattern_;
-};
-
-
 template <typename T>
 agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, unsigned offset_x, unsigned offset_y)
     : feature_style_processor<agg_renderer>(m, scale_factor),
@@ -122,7 +96,37 @@ agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, uns
       font_engine_(),
       font_manager_(font_engine_),
       detector_(box2d<double>(-m.buffer_size(), -m.buffer_size(), m.width() + m.buffer_size() ,m.height() + m.buffer_size())),
-      ras_ptr(new rasterizer)
+      ras_ptr(new rasterizer),
+      pattern_cache_(new agg_pattern_cache)
+{
+    setup(m);
+#ifdef MAPNIK_DEBUG
+    std::clog << "scale=" << m.scale() << "\n";
+#endif
+}
+
+template <typename T>
+agg_renderer<T>::agg_renderer(Map const& m, request const& req, T & pixmap, double scale_factor, unsigned offset_x, unsigned offset_y)
+    : feature_style_processor<agg_renderer>(m, req, scale_factor),
+      pixmap_(pixmap),
+      width_(pixmap_.width()),
+      height_(pixmap_.height()),
+      scale_factor_(scale_factor),
+      t_(req.width(),req.height(),req.extent(),offset_x,offset_y),
+      font_engine_(),
+      font_manager_(font_engine_),
+      detector_(box2d<double>(-req.buffer_size(), -req.buffer_size(), req.width() + req.buffer_size() ,req.height() + req.buffer_size())),
+      ras_ptr(new rasterizer),
+      pattern_cache_(new agg_pattern_cache)
+{
+    setup(m);
+#ifdef MAPNIK_DEBUG
+    std::clog << "scale=" << req.scale() << "\n";
+#endif
+}
+
+template <typename T>
+void agg_renderer<T>::setup(Map const& m)
 {
     boost::optional<color> const& bg = m.background();
     if (bg) pixmap_.set_background(*bg);
@@ -151,9 +155,6 @@ agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, uns
             }
         }
     }
-#ifdef MAPNIK_DEBUG
-    std::clog << "scale=" << m.scale() << "\n";
-#endif
 }
 
 template <typename T>
@@ -175,6 +176,7 @@ void agg_renderer<T>::start_map_processing(Map const& /*map*/)
 template <typename T>
 void agg_renderer<T>::end_map_processing(Map const& )
 {
+    flush_polygons();
 #ifdef MAPNIK_DEBUG
     std::clog << "end map processing\n";
 #endif
@@ -196,6 +198,7 @@ void agg_renderer<T>::start_layer_processing(layer const& lay)
 template <typename T>
 void agg_renderer<T>::end_layer_processing(layer const&)
 {
+    flush_polygons();
 #ifdef MAPNIK_DEBUG
     std::clog << "end layer processing\n";
 #endif
@@ -204,6 +207,7 @@ void agg_renderer<T>::end_layer_processing(layer const&)
 template <typename T>
 void agg_renderer<T>::render_marker(const int x, const int y, marker &marker, const agg::trans_affine & tr, double opacity)
 {
+    flush_polygons();
     if (marker.is_vector())
     {
         typedef agg::pixfmt_rgba32_plain pixfmt;
@@ -24,10 +24,7 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
-#include <mapnik/segment.hpp>
-
-// boost
-#include <boost/scoped_ptr.hpp>
+#include <mapnik/building_extrusion.hpp>
 
 // agg
 #include "agg_basics.h"
@@ -46,8 +43,10 @@ void agg_renderer<T>::process(building_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
-    typedef  coord_transform2<CoordTransform,geometry_type> path_type;
-    typedef  coord_transform3<CoordTransform,geometry_type> path_type_roof;
+    flush_polygons();
+    typedef building_walls<building_faces::const_iterator> walls_type;
+    typedef building_frame<geometry_type> frame_type;
+    typedef building_roof<geometry_type> roof_type;
     typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
     typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
 
@@ -67,83 +66,54 @@ void agg_renderer<T>::process(building_symbolizer const& sym,
     ras_ptr->gamma(agg::gamma_linear());
     
     double height = sym.height() * scale_factor_;
-    
+    agg::rgba8 wall_color(int(r*0.8), int(g*0.8), int(b*0.8), int(a * sym.get_opacity()));
+    // the walls share one color, when it is opaque painting them back to
+    // front looks the same as filling them all at once
+    bool single_sweep = int(a * sym.get_opacity()) == 255;
+
     for (unsigned i=0;i<feature.num_geometries();++i)
     {
         geometry_type const& geom = feature.get_geometry(i);
         if (geom.num_points() > 2)
         {
-            boost::scoped_ptr<geometry_type> frame(new geometry_type(LineString));
-            boost::scoped_ptr<geometry_type> roof(new geometry_type(Polygon));
-            std::deque<segment_t> face_segments;
-            double x0(0);
-            double y0(0);
-            unsigned cm = geom.vertex(&x0,&y0);
-            for (unsigned j=1;j<geom.num_points();++j)
-            {
-                double x(0);
-                double y(0);
-                cm = geom.vertex(&x,&y);
-                if (cm == SEG_MOVETO)
-                {
-                    frame->move_to(x,y);
-                }
-                else if (cm == SEG_LINETO)
-                {
-                    frame->line_to(x,y);
-                    face_segments.push_back(segment_t(x0,y0,x,y));
-                }
-                
-                x0 = x;
-                y0 = y;
-            }
-            std::sort(face_segments.begin(),face_segments.end(), y_order);
-            std::deque<segment_t>::const_iterator itr=face_segments.begin();
-            for (;itr!=face_segments.end();++itr)
+            building_wall_segments(geom, wall_faces_);
+            ren.color(wall_color);
+            if (single_sweep)
             {
-                boost::scoped_ptr<geometry_type> faces(new geometry_type(Polygon));
-                faces->move_to(itr->get<0>(),itr->get<1>());
-                faces->line_to(itr->get<2>(),itr->get<3>());
-                faces->line_to(itr->get<2>(),itr->get<3>() + height);
-                faces->line_to(itr->get<0>(),itr->get<1>() + height);
-
-                path_type faces_path (t_,*faces,prj_trans);
-                ras_ptr->add_path(faces_path);
-                ren.color(agg::rgba8(int(r*0.8), int(g*0.8), int(b*0.8), int(a * sym.get_opacity())));
+                walls_type walls(wall_faces_.begin(), wall_faces_.end(), height);
+                coord_transform2<CoordTransform,walls_type> walls_path(t_,walls,prj_trans);
+                ras_ptr->add_path(walls_path);
                 agg::render_scanlines(*ras_ptr, sl, ren);
                 ras_ptr->reset();
-
-                frame->move_to(itr->get<0>(),itr->get<1>());
-                frame->line_to(itr->get<0>(),itr->get<1>()+height);
             }
-
-            geom.rewind(0);
-            for (unsigned j=0;j<geom.num_points();++j)
+            else
             {
-                double x,y;
-                unsigned cm = geom.vertex(&x,&y);
-                if (cm == SEG_MOVETO)
+                building_faces::const_iterator itr = wall_faces_.begin();
+                building_faces::const_iterator end = wall_faces_.end();
+                for (;itr!=end;++itr)
                 {
-                    frame->move_to(x,y+height);
-                    roof->move_to(x,y+height);
-                }
-                else if (cm == SEG_LINETO)
-                {
-                    frame->line_to(x,y+height);
-                    roof->line_to(x,y+height);
+                    walls_type face(itr, itr + 1, height);
+                    coord_transform2<CoordTransform,walls_type> face_path(t_,face,prj_trans);
+                    ras_ptr->add_path(face_path);
+                    agg::render_scanlines(*ras_ptr, sl, ren);
+                    ras_ptr->reset();
                 }
             }
-            path_type path(t_,*frame,prj_trans);
-            agg::conv_stroke<path_type> stroke(path);
+
+            frame_type frame(geom, wall_faces_, height);
+            coord_transform2<CoordTransform,frame_type> frame_path(t_,frame,prj_trans);
+            agg::conv_stroke<coord_transform2<CoordTransform,frame_type> > stroke(frame_path);
             ras_ptr->add_path(stroke);
             ren.color(agg::rgba8(int(r*0.8), int(g*0.8), int(b*0.8), int(255 * sym.get_opacity())));
             agg::render_scanlines(*ras_ptr, sl, ren);
             ras_ptr->reset();
 
-            path_type roof_path (t_,*roof,prj_trans);
+            roof_type roof(geom, height);
+            coord_transform2<CoordTransform,roof_type> roof_path(t_,roof,prj_trans);
             ras_ptr->add_path(roof_path);
             ren.color(agg::rgba8(r, g, b, int(a * sym.get_opacity())));
             agg::render_scanlines(*ras_ptr, sl, ren);
+            ras_ptr->reset();
         }
     }
 }
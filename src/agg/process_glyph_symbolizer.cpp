@@ -38,6 +38,7 @@ void agg_renderer<T>::process(glyph_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    flush_polygons();
     face_set_ptr faces = font_manager_.get_face_set(sym.get_face_name());
     stroker_ptr strk = font_manager_.get_stroker();
     if (faces->size() > 0 && strk)
@@ -24,6 +24,7 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/clipped_path.hpp>
 
 // agg
 #include "agg_basics.h"
@@ -49,8 +50,10 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    flush_polygons();
     typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
+    typedef clipped_path<path_type> clipped_path_type;
     //typedef agg::renderer_outline_aa<ren_base> renderer_oaa;
     //typedef agg::rasterizer_outline_aa<renderer_oaa> rasterizer_outline_aa;
     typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
@@ -77,10 +80,13 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
         if (geom.num_points() > 1)
         {
             path_type path(t_,geom,prj_trans);
+            clipped_path_type clipped(path, clipped_path_type::polyline);
+            setup_clipped_line(clipped, sym, stroke_, width_, height_,
+                               scale_factor_, 4.0);
 
             if (stroke_.has_dash())
             {
-                agg::conv_dash<path_type> dash(path);
+                agg::conv_dash<clipped_path_type> dash(clipped);
                 dash_array const& d = stroke_.get_dash_array();
                 dash_array::const_iterator itr = d.begin();
                 dash_array::const_iterator end = d.end();
@@ -90,7 +96,7 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
                                   itr->second * scale_factor_);
                 }
 
-                agg::conv_stroke<agg::conv_dash<path_type > > stroke(dash);
+                agg::conv_stroke<agg::conv_dash<clipped_path_type> > stroke(dash);
 
                 line_join_e join=stroke_.get_line_join();
                 if ( join == MITER_JOIN)
@@ -118,7 +124,7 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
             }
             else
             {
-                agg::conv_stroke<path_type>  stroke(path);
+                agg::conv_stroke<clipped_path_type>  stroke(clipped);
                 line_join_e join=stroke_.get_line_join();
                 if ( join == MITER_JOIN)
                     stroke.generator().line_join(agg::miter_join);
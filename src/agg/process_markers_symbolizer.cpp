@@ -48,6 +48,7 @@ void agg_renderer<T>::process(markers_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    flush_polygons();
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
     typedef agg::pixfmt_rgba32_plain pixfmt;
     typedef agg::renderer_base<pixfmt> renderer_base;
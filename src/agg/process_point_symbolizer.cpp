@@ -47,6 +47,7 @@ void agg_renderer<T>::process(point_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    flush_polygons();
     std::string filename = path_processor_type::evaluate(*sym.get_filename(), feature);
     
     boost::optional<mapnik::marker_ptr> marker;
@@ -24,7 +24,7 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
-#include <mapnik/marker_cache.hpp>
+#include <mapnik/agg_pattern_cache.hpp>
 
 // agg
 #include "agg_basics.h"
@@ -47,6 +47,7 @@ void agg_renderer<T>::process(polygon_pattern_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    flush_polygons();
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
     typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
     typedef agg::wrap_mode_repeat wrap_x_type;
@@ -73,21 +74,13 @@ void agg_renderer<T>::process(polygon_pattern_symbolizer const& sym,
     ras_ptr->gamma(agg::gamma_linear());
 
     std::string filename = path_processor_type::evaluate( *sym.get_filename(), feature);
-    boost::optional<mapnik::marker_ptr> marker;
-    if ( !filename.empty() )
-    {
-        marker = marker_cache::instance()->find(filename, true);
-    }
-
-    if (!marker || !(*marker)->is_bitmap()) return;
-
-    boost::optional<image_ptr> pat = (*marker)->get_bitmap_data();
+    image_ptr const& pat = pattern_cache_->find_image(filename);
 
     if (!pat) return;
     
-    unsigned w=(*pat)->width();
-    unsigned h=(*pat)->height();
-    agg::row_accessor<agg::int8u> pattern_rbuf((agg::int8u*)(*pat)->getBytes(),w,h,w*4);
+    unsigned w=pat->width();
+    unsigned h=pat->height();
+    agg::row_accessor<agg::int8u> pattern_rbuf((agg::int8u*)pat->getBytes(),w,h,w*4);
     agg::span_allocator<agg::rgba8> sa;
     agg::pixfmt_alpha_blend_rgba<agg::blender_rgba32,
         agg::row_accessor<agg::int8u>, agg::pixel32_type> pixf_pattern(pattern_rbuf);
@@ -24,6 +24,7 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/clipped_path.hpp>
 
 // agg
 #include "agg_basics.h"
@@ -39,42 +40,117 @@
 
 namespace mapnik {
 
+namespace {
+
+// upper bound on the vertices swept at once, keeps the rasterizer
+// cell storage well below agg's cell_block_limit
+const unsigned max_batch_vertices = 1 << 16;
+
+// orientation of the rings of geom, from the sign of their summed area
+bool is_clockwise(geometry_type const& geom)
+{
+    double area = 0.0;
+    double x0 = 0, y0 = 0; // first vertex, all others relative to it
+    double xs = 0, ys = 0; // start of the current ring
+    double xp = 0, yp = 0; // previous vertex
+    geom.rewind(0);
+    unsigned cmd = geom.vertex(&x0, &y0);
+    double x = x0, y = y0;
+    for (; cmd != SEG_END; cmd = geom.vertex(&x, &y))
+    {
+        if (cmd == SEG_MOVETO)
+        {
+            area += xp * ys - xs * yp;
+            x -= x0; y -= y0;
+            xs = xp = x;
+            ys = yp = y;
+        }
+        else if (cmd == SEG_LINETO)
+        {
+            x -= x0; y -= y0;
+            area += xp * y - x * yp;
+            xp = x;
+            yp = y;
+        }
+    }
+    area += xp * ys - xs * yp;
+    return area < 0;
+}
+
+}
+
 template <typename T>
 void agg_renderer<T>::process(polygon_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
-    typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
-    typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
+    typedef clipped_path<path_type> clipped_path_type;
 
     color const& fill_ = sym.get_fill();
-    agg::scanline_u8 sl;
-
-    agg::rendering_buffer buf(pixmap_.raw_data(),width_,height_, width_ * 4);
-    agg::pixfmt_rgba32_plain pixf(buf);
+    int a = int(fill_.alpha() * sym.get_opacity());
+    color fill(fill_.red(), fill_.green(), fill_.blue(), a < 0 ? 0 : (a > 255 ? 255 : a));
+    double gamma = sym.get_gamma();
+    // opaque fills look the same whether overlapping polygons are swept
+    // together or one after another, so consecutive features sharing fill,
+    // gamma and ring orientation (opposite windings would cancel out under
+    // the non-zero rule) are accumulated and swept once. Translucent fills
+    // are still rendered per feature.
+    bool batch = (fill.alpha() == 255);
+    bool started = false;
 
-    ren_base renb(pixf);
-    unsigned r=fill_.red();
-    unsigned g=fill_.green();
-    unsigned b=fill_.blue();
-    unsigned a=fill_.alpha();
-    renderer ren(renb);
-
-    ras_ptr->reset();
-    ras_ptr->gamma(agg::gamma_linear(0.0, sym.get_gamma()));
     metawriter_with_properties writer = sym.get_metawriter();
     for (unsigned i=0;i<feature.num_geometries();++i)
     {
         geometry_type const& geom=feature.get_geometry(i);
         if (geom.num_points() > 2)
         {
+            bool clockwise = batch && is_clockwise(geom);
+            if (batch ? (!polygons_.pending ||
+                         !(polygons_.fill == fill) ||
+                         polygons_.gamma != gamma ||
+                         polygons_.clockwise != clockwise ||
+                         polygons_.vertices > max_batch_vertices)
+                      : !started)
+            {
+                flush_polygons();
+                ras_ptr->reset();
+                ras_ptr->gamma(agg::gamma_linear(0.0, gamma));
+                polygons_.pending = true;
+                polygons_.fill = fill;
+                polygons_.gamma = gamma;
+                polygons_.clockwise = clockwise;
+                polygons_.vertices = 0;
+                started = true;
+            }
             path_type path(t_,geom,prj_trans);
-            ras_ptr->add_path(path);
+            clipped_path_type clipped(path, clipped_path_type::polygon);
+            setup_clipped_path(clipped, sym, width_, height_, 1.0);
+            ras_ptr->add_path(clipped);
+            polygons_.vertices += geom.num_points();
             if (writer.first) writer.first->add_polygon(path, feature, t_, writer.second);
         }
     }
-    ren.color(agg::rgba8(r, g, b, int(a * sym.get_opacity())));
+    if (!batch) flush_polygons();
+}
+
+template <typename T>
+void agg_renderer<T>::flush_polygons()
+{
+    typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
+    typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
+
+    if (!polygons_.pending) return;
+    polygons_.pending = false;
+
+    agg::scanline_u8 sl;
+    agg::rendering_buffer buf(pixmap_.raw_data(),width_,height_, width_ * 4);
+    agg::pixfmt_rgba32_plain pixf(buf);
+    ren_base renb(pixf);
+    renderer ren(renb);
+
+    color const& fill = polygons_.fill;
+    ren.color(agg::rgba8(fill.red(), fill.green(), fill.blue(), fill.alpha()));
     agg::render_scanlines(*ras_ptr, sl, ren);
 }
 
@@ -83,5 +159,6 @@ template void agg_renderer<image_32>::process(polygon_symbolizer const&,
                                               Feature const&,
                                               proj_transform const&);
 
+template void agg_renderer<image_32>::flush_polygons();
+
 }
- 
@@ -37,6 +37,7 @@ void agg_renderer<T>::process(raster_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    flush_polygons();
     raster_ptr const& raster=feature.get_raster();
     if (raster)
     {
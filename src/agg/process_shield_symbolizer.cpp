@@ -43,6 +43,7 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
                                Feature const& feature,
                                proj_transform const& prj_trans)
 {
+    flush_polygons();
     typedef  coord_transform2<CoordTransform,geometry_type> path_type;
 
 
@@ -166,6 +167,8 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
                                                          sym.get_line_spacing(),
                                                          sym.get_character_spacing());
 
+                            if (this->stats()) this->stats()->add_label_attempt(!text_placement.placements.empty());
+
                             // check to see if image overlaps anything too, there is only ever 1 placement found for points and verticies
                             if( text_placement.placements.size() > 0)
                             {
@@ -215,6 +218,7 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
 
                         text_placement.avoid_edges = sym.get_avoid_edges();
                         finder.find_point_placements<path_type>(text_placement, placement_options, path);
+                        if (this->stats()) this->stats()->add_label_attempt(!text_placement.placements.empty());
 
                         position const&  pos = sym.get_displacement();
                         for (unsigned int ii = 0; ii < text_placement.placements.size(); ++ ii)
@@ -32,6 +32,7 @@ void agg_renderer<T>::process(text_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    flush_polygons();
     typedef  coord_transform2<CoordTransform,geometry_type> path_type;
 
     bool placement_found = false;
@@ -135,6 +136,7 @@ void agg_renderer<T>::process(text_symbolizer const& sym,
                     finder.find_line_placements<path_type>(text_placement, placement_options, path);
                 }
 
+                if (this->stats()) this->stats()->add_label_attempt(!text_placement.placements.empty());
                 if (!text_placement.placements.size()) continue;
                 placement_found = true;
 
@@ -36,6 +36,7 @@
 #include <mapnik/svg/svg_path_adapter.hpp>
 #include <mapnik/svg/svg_path_attributes.hpp>
 #include <mapnik/segment.hpp>
+#include <mapnik/clipped_path.hpp>
 
 // cairo
 #include <cairomm/context.h>
@@ -45,47 +46,58 @@
 // boost
 #include <boost/utility.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
 
 // stl
 #ifdef MAPNIK_DEBUG
 #include <iostream>
 #endif
+#include <vector>
 
 namespace mapnik
 {
+// converts image into premultiplied ARGB32, as expected by cairo
+static void premultiply(image_data_32 const& data, unsigned int * out_ptr)
+{
+    int pixels = data.width() * data.height();
+    const unsigned int *in_ptr = data.getData();
+    const unsigned int *in_end = in_ptr + pixels;
+
+    while (in_ptr < in_end)
+    {
+        unsigned int in = *in_ptr++;
+        unsigned int r = (in >> 0) & 0xff;
+        unsigned int g = (in >> 8) & 0xff;
+        unsigned int b = (in >> 16) & 0xff;
+        unsigned int a = (in >> 24) & 0xff;
+
+        r = r * a / 255;
+        g = g * a / 255;
+        b = b * a / 255;
+
+        *out_ptr++ = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
 class cairo_pattern : private boost::noncopyable
 {
 public:
     cairo_pattern(image_data_32 const& data)
     {
-        int pixels = data.width() * data.height();
-        const unsigned int *in_ptr = data.getData();
-        const unsigned int *in_end = in_ptr + pixels;
-        unsigned int *out_ptr;
-
         surface_ = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, data.width(), data.height());
-
-        out_ptr = reinterpret_cast<unsigned int *>(surface_->get_data());
-
-        while (in_ptr < in_end)
-        {
-            unsigned int in = *in_ptr++;
-            unsigned int r = (in >> 0) & 0xff;
-            unsigned int g = (in >> 8) & 0xff;
-            unsigned int b = (in >> 16) & 0xff;
-            unsigned int a = (in >> 24) & 0xff;
-
-            r = r * a / 255;
-            g = g * a / 255;
-            b = b * a / 255;
-
-            *out_ptr++ = (a << 24) | (r << 16) | (g << 8) | b;
-        }
+        premultiply(data, reinterpret_cast<unsigned int *>(surface_->get_data()));
         // mark the surface as dirty as we've modified it behind cairo's back
         surface_->mark_dirty();
         pattern_ = Cairo::SurfacePattern::create(surface_);
     }
 
+    cairo_pattern(Cairo::RefPtr<Cairo::ImageSurface> const& surface)
+        : surface_(surface),
+          pattern_(Cairo::SurfacePattern::create(surface)) {}
+
     ~cairo_pattern(void)
     {
     }
@@ -186,14 +198,13 @@ private:
 class cairo_face : private boost::noncopyable
 {
 public:
-    cairo_face(boost::shared_ptr<freetype_engine> const& engine, face_ptr const& face)
-        : face_(face)
+    explicit cairo_face(face_ptr const& face)
     {
         static cairo_user_data_key_t key;
         cairo_font_face_t *c_face;
 
         c_face = cairo_ft_font_face_create_for_ft_face(face->get_face(), FT_LOAD_NO_HINTING);
-        cairo_font_face_set_user_data(c_face, &key, new handle(engine, face), destroy);
+        cairo_font_face_set_user_data(c_face, &key, new face_ptr(face), destroy);
 
         cairo_face_ = Cairo::RefPtr<Cairo::FontFace>(new Cairo::FontFace(c_face));
     }
@@ -204,29 +215,56 @@ public:
     }
 
 private:
-    class handle
+    // the freetype face (and so its library) lives as long as cairo uses it
+    static void destroy(void *data)
     {
-    public:
-        handle(boost::shared_ptr<freetype_engine> const& engine, face_ptr const& face)
-            : engine_(engine), face_(face) {}
+        delete static_cast<face_ptr *>(data);
+    }
 
-    private:
-        boost::shared_ptr<freetype_engine> engine_;
-        face_ptr face_;
-    };
+    Cairo::RefPtr<Cairo::FontFace> cairo_face_;
+};
 
-    static void destroy(void *data)
+/*
+ * Cairo font faces shared by every cairo renderer of the process.
+ * freetype_engine hands out one face per font and thread, so a cairo
+ * face is never used by two threads at the same time.
+ */
+class cairo_face_cache : private boost::noncopyable
+{
+public:
+    static cairo_face_ptr find(face_ptr const& face)
     {
-        handle *h = static_cast<handle *>(data);
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        face_map::const_iterator itr = faces_.find(face);
+        if (itr != faces_.end()) return itr->second;
 
-        delete h;
+        // forget the faces only referenced from here (the key and the
+        // cairo face user data), their thread has released them
+        for (face_map::iterator i = faces_.begin(); i != faces_.end();)
+        {
+            if (i->first.use_count() <= 2) faces_.erase(i++);
+            else ++i;
+        }
+        cairo_face_ptr entry = boost::make_shared<cairo_face>(face);
+        faces_.insert(std::make_pair(face, entry));
+        return entry;
     }
 
 private:
-    face_ptr face_;
-    Cairo::RefPtr<Cairo::FontFace> cairo_face_;
+    typedef std::map<face_ptr,cairo_face_ptr> face_map;
+#ifdef MAPNIK_THREADSAFE
+    static boost::mutex mutex_;
+#endif
+    static face_map faces_;
 };
 
+#ifdef MAPNIK_THREADSAFE
+boost::mutex cairo_face_cache::mutex_;
+#endif
+cairo_face_cache::face_map cairo_face_cache::faces_;
+
 cairo_face_manager::cairo_face_manager(boost::shared_ptr<freetype_engine> engine,
                                        face_manager<freetype_engine> & manager)
     : font_engine_(engine),
@@ -236,7 +274,7 @@ cairo_face_manager::cairo_face_manager(boost::shared_ptr<freetype_engine> engine
 
 cairo_face_ptr cairo_face_manager::get_face(face_ptr face)
 {
-    cairo_face_cache::iterator itr = cache_.find(face);
+    face_map::iterator itr = cache_.find(face);
     cairo_face_ptr entry;
 
     if (itr != cache_.end())
@@ -245,7 +283,7 @@ cairo_face_ptr cairo_face_manager::get_face(face_ptr face)
     }
     else
     {
-        entry = cairo_face_ptr(new cairo_face(font_engine_, face));
+        entry = cairo_face_cache::find(face);
 
         cache_.insert(std::make_pair(face, entry));
     }
@@ -253,6 +291,53 @@ cairo_face_ptr cairo_face_manager::get_face(face_ptr face)
     return entry;
 }
 
+/*
+ * Premultiplied copies of marker bitmaps shared by every cairo renderer
+ * of the process. Each renderer wraps them in its own surface: cairo
+ * attaches snapshots to source surfaces, which is not safe to do from
+ * several threads on the same surface.
+ */
+class cairo_image_cache : private boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<std::vector<unsigned int> > pixels_ptr;
+
+    static pixels_ptr find(image_ptr const& image)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        image_map::iterator itr = images_.find(image.get());
+        // a different image may have been allocated at the same address
+        if (itr != images_.end() && itr->second.first.lock() == image)
+        {
+            return itr->second.second;
+        }
+
+        for (image_map::iterator i = images_.begin(); i != images_.end();)
+        {
+            if (i->second.first.expired()) images_.erase(i++);
+            else ++i;
+        }
+        pixels_ptr pixels = boost::make_shared<std::vector<unsigned int> >(image->width() * image->height());
+        if (!pixels->empty()) premultiply(*image, &(*pixels)[0]);
+        images_[image.get()] = std::make_pair(boost::weak_ptr<image_data_32>(image), pixels);
+        return pixels;
+    }
+
+private:
+    typedef std::map<image_data_32 const*, std::pair<boost::weak_ptr<image_data_32>, pixels_ptr> > image_map;
+#ifdef MAPNIK_THREADSAFE
+    static boost::mutex mutex_;
+#endif
+    static image_map images_;
+};
+
+#ifdef MAPNIK_THREADSAFE
+boost::mutex cairo_image_cache::mutex_;
+#endif
+cairo_image_cache::image_map cairo_image_cache::images_;
+
 class cairo_context : private boost::noncopyable
 {
 public:
@@ -493,13 +578,13 @@ public:
     void add_image(double x, double y, image_data_32 & data, double opacity = 1.0)
     {
         cairo_pattern pattern(data);
+        add_pattern(x, y, pattern, opacity);
+    }
 
-        pattern.set_origin(x, y);
-
-        context_->save();
-        context_->set_source(pattern.pattern());
-        context_->paint_with_alpha(opacity);
-        context_->restore();
+    void add_image(double x, double y, Cairo::RefPtr<Cairo::ImageSurface> const& surface, double opacity = 1.0)
+    {
+        cairo_pattern pattern(surface);
+        add_pattern(x, y, pattern, opacity);
     }
 
     void set_font_face(cairo_face_manager & manager, face_ptr face)
@@ -648,6 +733,16 @@ public:
 
 
 private:
+    void add_pattern(double x, double y, cairo_pattern & pattern, double opacity)
+    {
+        pattern.set_origin(x, y);
+
+        context_->save();
+        context_->set_source(pattern.pattern());
+        context_->paint_with_alpha(opacity);
+        context_->restore();
+    }
+
     Cairo::RefPtr<Cairo::Context> context_;
 };
 
@@ -681,6 +776,28 @@ cairo_renderer<Cairo::Surface>::cairo_renderer(Map const& m, Cairo::RefPtr<Cairo
 
 cairo_renderer_base::~cairo_renderer_base() {}
 
+static void release_pixels(void *data)
+{
+    delete static_cast<cairo_image_cache::pixels_ptr *>(data);
+}
+
+Cairo::RefPtr<Cairo::ImageSurface> cairo_renderer_base::image_surface(image_ptr const& image)
+{
+    std::map<image_ptr, Cairo::RefPtr<Cairo::ImageSurface> >::const_iterator itr = image_surfaces_.find(image);
+    if (itr != image_surfaces_.end()) return itr->second;
+
+    static cairo_user_data_key_t key;
+    cairo_image_cache::pixels_ptr pixels = cairo_image_cache::find(image);
+    unsigned char * data = pixels->empty() ? 0 : reinterpret_cast<unsigned char *>(&(*pixels)[0]);
+    Cairo::RefPtr<Cairo::ImageSurface> surface =
+        Cairo::ImageSurface::create(data, Cairo::FORMAT_ARGB32, image->width(), image->height(), image->width() * 4);
+    // the pixels must outlive the surface, which may be referenced by the
+    // output (a pdf page for instance) after the renderer is gone
+    cairo_surface_set_user_data(surface->cobj(), &key, new cairo_image_cache::pixels_ptr(pixels), release_pixels);
+    image_surfaces_.insert(std::make_pair(image, surface));
+    return surface;
+}
+
 #ifdef MAPNIK_DEBUG
 void cairo_renderer_base::start_map_processing(Map const& map)
 {
@@ -747,6 +864,7 @@ void cairo_renderer_base::process(polygon_symbolizer const& sym,
                                   proj_transform const& prj_trans)
 {
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
+    typedef clipped_path<path_type> clipped_path_type;
 
     cairo_context context(context_);
 
@@ -759,8 +877,10 @@ void cairo_renderer_base::process(polygon_symbolizer const& sym,
         if (geom.num_points() > 2)
         {
             path_type path(t_, geom, prj_trans);
+            clipped_path_type clipped(path, clipped_path_type::polygon);
+            setup_clipped_path(clipped, sym, m_.width(), m_.height(), 1.0);
 
-            context.add_path(path);
+            context.add_path(clipped);
             context.fill();
         }
     }
@@ -875,6 +995,7 @@ void cairo_renderer_base::process(line_symbolizer const& sym,
                                   proj_transform const& prj_trans)
 {
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
+    typedef clipped_path<path_type> clipped_path_type;
 
     cairo_context context(context_);
     mapnik::stroke const& stroke_ = sym.get_stroke();
@@ -889,6 +1010,9 @@ void cairo_renderer_base::process(line_symbolizer const& sym,
         {
             cairo_context context(context_);
             path_type path(t_, geom, prj_trans);
+            clipped_path_type clipped(path, clipped_path_type::polyline);
+            setup_clipped_line(clipped, sym, stroke_, m_.width(), m_.height(),
+                               1.0, 4.0);
 
             if (stroke_.has_dash())
             {
@@ -899,7 +1023,7 @@ void cairo_renderer_base::process(line_symbolizer const& sym,
             context.set_line_cap(stroke_.get_line_cap());
             context.set_miter_limit(4.0);
             context.set_line_width(stroke_.get_width());
-            context.add_path(path);
+            context.add_path(clipped);
             context.stroke();
         }
     }
@@ -1002,7 +1126,7 @@ void cairo_renderer_base::render_marker(const int x, const int y, marker &marker
     }
     else if (marker.is_bitmap())
     {
-        context.add_image(x, y, **marker.get_bitmap_data(), opacity);
+        context.add_image(x, y, image_surface(*marker.get_bitmap_data()), opacity);
     }
 }
 
@@ -1184,6 +1308,7 @@ void cairo_renderer_base::process(shield_symbolizer const& sym,
                                                         label_x, label_y, 0.0,
                                                         sym.get_line_spacing(),
                                                         sym.get_character_spacing());
+                            if (stats()) stats()->add_label_attempt(!text_placement.placements.empty());
 
                             for (unsigned int ii = 0; ii < text_placement.placements.size(); ++ ii)
                             {
@@ -1240,6 +1365,7 @@ void cairo_renderer_base::process(shield_symbolizer const& sym,
 
                         text_placement.avoid_edges = sym.get_avoid_edges();
                         finder.find_point_placements<path_type>(text_placement, placement_options, path);
+                        if (stats()) stats()->add_label_attempt(!text_placement.placements.empty());
 
                         position const&  pos = sym.get_displacement();
                         for (unsigned int ii = 0; ii < text_placement.placements.size(); ++ ii)
@@ -1280,13 +1406,13 @@ void cairo_renderer_base::process(line_pattern_symbolizer const& sym,
     
     std::string filename = path_processor_type::evaluate( *sym.get_filename(), feature);
     boost::optional<mapnik::marker_ptr> marker = mapnik::marker_cache::instance()->find(filename,true);
-    if (!marker && !(*marker)->is_bitmap()) return;
+    if (!marker || !(*marker)->is_bitmap()) return;
     
     unsigned width((*marker)->width());
     unsigned height((*marker)->height());
 
     cairo_context context(context_);
-    cairo_pattern pattern(**((*marker)->get_bitmap_data()));
+    cairo_pattern pattern(image_surface(*(*marker)->get_bitmap_data()));
 
     pattern.set_extend(Cairo::EXTEND_REPEAT);
     pattern.set_filter(Cairo::FILTER_BILINEAR);
@@ -1350,9 +1476,9 @@ void cairo_renderer_base::process(polygon_pattern_symbolizer const& sym,
     cairo_context context(context_);
     std::string filename = path_processor_type::evaluate( *sym.get_filename(), feature);
     boost::optional<mapnik::marker_ptr> marker = mapnik::marker_cache::instance()->find(filename,true);
-    if (!marker && !(*marker)->is_bitmap()) return;
+    if (!marker || !(*marker)->is_bitmap()) return;
 
-    cairo_pattern pattern(**((*marker)->get_bitmap_data()));
+    cairo_pattern pattern(image_surface(*(*marker)->get_bitmap_data()));
 
     pattern.set_extend(Cairo::EXTEND_REPEAT);
 
@@ -1610,6 +1736,7 @@ void cairo_renderer_base::process(text_symbolizer const& sym,
                     finder.find_line_placements<path_type>(text_placement, placement_options, path);
                 }
 
+                if (stats()) stats()->add_label_attempt(!text_placement.placements.empty());
                 if (!text_placement.placements.size()) continue;
                 placement_found = true;
 
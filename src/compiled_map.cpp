@@ -0,0 +1,1456 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+// $Id$
+
+// mapnik
+#include <mapnik/compiled_map.hpp>
+#include <mapnik/load_map.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/version.hpp>
+#include <mapnik/config_error.hpp>
+#include <mapnik/datasource_cache.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/raster_colorizer.hpp>
+#include <mapnik/metawriter_factory.hpp>
+#include <mapnik/text_placements_simple.hpp>
+
+// boost
+#include <boost/cstdint.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+
+// stl
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WINDOWS
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace mapnik
+{
+using boost::property_tree::ptree;
+
+namespace {
+
+// bump whenever the layout below changes
+const boost::uint32_t compiled_map_format = 2;
+const char compiled_map_magic[8] = { 'M','A','P','N','I','K','C','M' };
+const boost::uint32_t byte_order_mark = 0x01020304;
+
+struct source_stamp
+{
+    source_stamp()
+        : size(0), hash(0) {}
+    boost::uint64_t size;
+    boost::uint64_t hash;
+};
+
+// FNV-1a over the whole stylesheet, cheap next to parsing it
+bool stamp_source(std::string const& filename, source_stamp & stamp)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file) return false;
+    boost::uint64_t hash = 14695981039346656037ULL;
+    boost::uint64_t size = 0;
+    char buf[8192];
+    while (file)
+    {
+        file.read(buf, sizeof(buf));
+        std::streamsize n = file.gcount();
+        for (std::streamsize i = 0; i < n; ++i)
+        {
+            hash ^= static_cast<unsigned char>(buf[i]);
+            hash *= 1099511628211ULL;
+        }
+        size += n;
+    }
+    stamp.size = size;
+    stamp.hash = hash;
+    return true;
+}
+
+class compiled_map_writer
+{
+public:
+    explicit compiled_map_writer(std::string & buf)
+        : buf_(buf) {}
+
+    template <typename T>
+    void write_pod(T const& v)
+    {
+        buf_.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void write(bool v) { write_pod(static_cast<boost::uint8_t>(v ? 1 : 0)); }
+    void write(boost::int32_t v) { write_pod(v); }
+    void write(boost::uint32_t v) { write_pod(v); }
+    void write(boost::uint64_t v) { write_pod(v); }
+    void write(float v) { write_pod(v); }
+    void write(double v) { write_pod(v); }
+
+    void write(std::string const& str)
+    {
+        write(static_cast<boost::uint32_t>(str.size()));
+        buf_.append(str);
+    }
+
+    void write(UnicodeString const& ustr)
+    {
+        std::string utf8;
+        to_utf8(ustr, utf8);
+        write(utf8);
+    }
+
+    void write(color const& c)
+    {
+        write_pod(static_cast<boost::uint8_t>(c.red()));
+        write_pod(static_cast<boost::uint8_t>(c.green()));
+        write_pod(static_cast<boost::uint8_t>(c.blue()));
+        write_pod(static_cast<boost::uint8_t>(c.alpha()));
+    }
+
+    void write(box2d<double> const& box)
+    {
+        write(box.minx());
+        write(box.miny());
+        write(box.maxx());
+        write(box.maxy());
+    }
+
+    template <typename ENUM, int MAX>
+    void write(enumeration<ENUM,MAX> const& e)
+    {
+        write(static_cast<boost::int32_t>(static_cast<ENUM>(e)));
+    }
+
+private:
+    std::string & buf_;
+};
+
+class compiled_map_reader
+{
+public:
+    compiled_map_reader(const char * begin, const char * end)
+        : pos_(begin), end_(end) {}
+
+    template <typename T>
+    void read_pod(T & v)
+    {
+        need(sizeof(T));
+        std::memcpy(&v, pos_, sizeof(T));
+        pos_ += sizeof(T);
+    }
+
+    template <typename T>
+    T get()
+    {
+        T v;
+        read(v);
+        return v;
+    }
+
+    void read(bool & v)
+    {
+        boost::uint8_t b;
+        read_pod(b);
+        v = (b != 0);
+    }
+    void read(boost::int32_t & v) { read_pod(v); }
+    void read(boost::uint32_t & v) { read_pod(v); }
+    void read(boost::uint64_t & v) { read_pod(v); }
+    void read(float & v) { read_pod(v); }
+    void read(double & v) { read_pod(v); }
+
+    void read(std::string & str)
+    {
+        boost::uint32_t size = get<boost::uint32_t>();
+        need(size);
+        str.assign(pos_, size);
+        pos_ += size;
+    }
+
+    void read(UnicodeString & ustr)
+    {
+        std::string utf8 = get<std::string>();
+        ustr = UnicodeString::fromUTF8(utf8);
+    }
+
+    void read(color & c)
+    {
+        boost::uint8_t r, g, b, a;
+        read_pod(r);
+        read_pod(g);
+        read_pod(b);
+        read_pod(a);
+        c = color(r, g, b, a);
+    }
+
+    void read(box2d<double> & box)
+    {
+        double minx = get<double>();
+        double miny = get<double>();
+        double maxx = get<double>();
+        double maxy = get<double>();
+        box.init(minx, miny, maxx, maxy);
+    }
+
+    template <typename ENUM, int MAX>
+    void read(enumeration<ENUM,MAX> & e)
+    {
+        boost::int32_t v = get<boost::int32_t>();
+        if (v < 0 || v >= MAX)
+            throw config_error("compiled map: enumeration value out of range");
+        e = static_cast<ENUM>(v);
+    }
+
+    bool at_end() const { return pos_ == end_; }
+
+private:
+    void need(std::size_t n) const
+    {
+        if (static_cast<std::size_t>(end_ - pos_) < n)
+            throw config_error("compiled map: unexpected end of file");
+    }
+
+    const char * pos_;
+    const char * end_;
+};
+
+// expressions
+
+enum expr_tag
+{
+    EXPR_NULL = 0,
+    EXPR_BOOL,
+    EXPR_INT,
+    EXPR_DOUBLE,
+    EXPR_STRING,
+    EXPR_ATTRIBUTE,
+    EXPR_BINARY,
+    EXPR_NOT,
+    EXPR_MATCH,
+    EXPR_REPLACE
+};
+
+enum binary_op
+{
+    OP_PLUS = 0,
+    OP_MINUS,
+    OP_MULT,
+    OP_DIV,
+    OP_MOD,
+    OP_LESS,
+    OP_LESS_EQUAL,
+    OP_GREATER,
+    OP_GREATER_EQUAL,
+    OP_EQUAL_TO,
+    OP_NOT_EQUAL_TO,
+    OP_AND,
+    OP_OR
+};
+
+template <typename Tag> struct binary_op_traits;
+template <> struct binary_op_traits<tags::plus> { static const int op = OP_PLUS; };
+template <> struct binary_op_traits<tags::minus> { static const int op = OP_MINUS; };
+template <> struct binary_op_traits<tags::mult> { static const int op = OP_MULT; };
+template <> struct binary_op_traits<tags::div> { static const int op = OP_DIV; };
+template <> struct binary_op_traits<tags::mod> { static const int op = OP_MOD; };
+template <> struct binary_op_traits<tags::less> { static const int op = OP_LESS; };
+template <> struct binary_op_traits<tags::less_equal> { static const int op = OP_LESS_EQUAL; };
+template <> struct binary_op_traits<tags::greater> { static const int op = OP_GREATER; };
+template <> struct binary_op_traits<tags::greater_equal> { static const int op = OP_GREATER_EQUAL; };
+template <> struct binary_op_traits<tags::equal_to> { static const int op = OP_EQUAL_TO; };
+template <> struct binary_op_traits<tags::not_equal_to> { static const int op = OP_NOT_EQUAL_TO; };
+template <> struct binary_op_traits<tags::logical_and> { static const int op = OP_AND; };
+template <> struct binary_op_traits<tags::logical_or> { static const int op = OP_OR; };
+
+struct write_value : public boost::static_visitor<>
+{
+    explicit write_value(compiled_map_writer & out)
+        : out_(out) {}
+
+    void operator() (value_null const&) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_NULL));
+    }
+
+    void operator() (bool val) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_BOOL));
+        out_.write(val);
+    }
+
+    void operator() (int val) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_INT));
+        out_.write(static_cast<boost::int32_t>(val));
+    }
+
+    void operator() (double val) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_DOUBLE));
+        out_.write(val);
+    }
+
+    void operator() (UnicodeString const& val) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_STRING));
+        out_.write(val);
+    }
+
+    compiled_map_writer & out_;
+};
+
+struct write_expression : public boost::static_visitor<>
+{
+    explicit write_expression(compiled_map_writer & out)
+        : out_(out) {}
+
+    void operator() (value_type const& x) const
+    {
+        boost::apply_visitor(write_value(out_), x.base());
+    }
+
+    void operator() (attribute const& attr) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_ATTRIBUTE));
+        out_.write(attr.name());
+    }
+
+    template <typename Tag>
+    void operator() (binary_node<Tag> const& x) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_BINARY));
+        out_.write(static_cast<boost::uint32_t>(binary_op_traits<Tag>::op));
+        boost::apply_visitor(*this, x.left);
+        boost::apply_visitor(*this, x.right);
+    }
+
+    template <typename Tag>
+    void operator() (unary_node<Tag> const& x) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_NOT));
+        boost::apply_visitor(*this, x.expr);
+    }
+
+    void operator() (regex_match_node const& x) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_MATCH));
+        boost::apply_visitor(*this, x.expr);
+#if defined(BOOST_REGEX_HAS_ICU)
+        out_.write(UnicodeString::fromUTF32(&x.pattern.str()[0], x.pattern.str().length()));
+#else
+        out_.write(x.pattern.str());
+#endif
+    }
+
+    void operator() (regex_replace_node const& x) const
+    {
+        out_.write(static_cast<boost::uint32_t>(EXPR_REPLACE));
+        boost::apply_visitor(*this, x.expr);
+#if defined(BOOST_REGEX_HAS_ICU)
+        out_.write(UnicodeString::fromUTF32(&x.pattern.str()[0], x.pattern.str().length()));
+#else
+        out_.write(x.pattern.str());
+#endif
+        out_.write(x.format);
+    }
+
+    compiled_map_writer & out_;
+};
+
+expr_node read_expression(compiled_map_reader & in)
+{
+    switch (in.get<boost::uint32_t>())
+    {
+    case EXPR_NULL:
+        return expr_node(value_type());
+    case EXPR_BOOL:
+        return expr_node(value_type(in.get<bool>()));
+    case EXPR_INT:
+        return expr_node(value_type(static_cast<int>(in.get<boost::int32_t>())));
+    case EXPR_DOUBLE:
+        return expr_node(value_type(in.get<double>()));
+    case EXPR_STRING:
+        return expr_node(value_type(in.get<UnicodeString>()));
+    case EXPR_ATTRIBUTE:
+        return expr_node(attribute(in.get<std::string>()));
+    case EXPR_BINARY:
+    {
+        boost::uint32_t op = in.get<boost::uint32_t>();
+        expr_node left = read_expression(in);
+        expr_node right = read_expression(in);
+        switch (op)
+        {
+        case OP_PLUS: return binary_node<tags::plus>(left, right);
+        case OP_MINUS: return binary_node<tags::minus>(left, right);
+        case OP_MULT: return binary_node<tags::mult>(left, right);
+        case OP_DIV: return binary_node<tags::div>(left, right);
+        case OP_MOD: return binary_node<tags::mod>(left, right);
+        case OP_LESS: return binary_node<tags::less>(left, right);
+        case OP_LESS_EQUAL: return binary_node<tags::less_equal>(left, right);
+        case OP_GREATER: return binary_node<tags::greater>(left, right);
+        case OP_GREATER_EQUAL: return binary_node<tags::greater_equal>(left, right);
+        case OP_EQUAL_TO: return binary_node<tags::equal_to>(left, right);
+        case OP_NOT_EQUAL_TO: return binary_node<tags::not_equal_to>(left, right);
+        case OP_AND: return binary_node<tags::logical_and>(left, right);
+        case OP_OR: return binary_node<tags::logical_or>(left, right);
+        }
+        break;
+    }
+    case EXPR_NOT:
+        return unary_node<tags::logical_not>(read_expression(in));
+    case EXPR_MATCH:
+    {
+        expr_node expr = read_expression(in);
+#if defined(BOOST_REGEX_HAS_ICU)
+        return regex_match_node(expr, in.get<UnicodeString>());
+#else
+        return regex_match_node(expr, in.get<std::string>());
+#endif
+    }
+    case EXPR_REPLACE:
+    {
+        expr_node expr = read_expression(in);
+#if defined(BOOST_REGEX_HAS_ICU)
+        UnicodeString pattern = in.get<UnicodeString>();
+        UnicodeString format = in.get<UnicodeString>();
+#else
+        std::string pattern = in.get<std::string>();
+        std::string format = in.get<std::string>();
+#endif
+        return regex_replace_node(expr, pattern, format);
+    }
+    }
+    throw config_error("compiled map: unknown expression node");
+}
+
+void write_expression_ptr(compiled_map_writer & out, expression_ptr const& expr)
+{
+    out.write(static_cast<bool>(expr));
+    if (expr) boost::apply_visitor(write_expression(out), *expr);
+}
+
+expression_ptr read_expression_ptr(compiled_map_reader & in)
+{
+    if (!in.get<bool>()) return expression_ptr();
+    return boost::make_shared<expr_node>(read_expression(in));
+}
+
+// path expressions
+
+struct write_path_component : public boost::static_visitor<>
+{
+    explicit write_path_component(compiled_map_writer & out)
+        : out_(out) {}
+
+    void operator() (std::string const& token) const
+    {
+        out_.write(false);
+        out_.write(token);
+    }
+
+    void operator() (attribute const& attr) const
+    {
+        out_.write(true);
+        out_.write(attr.name());
+    }
+
+    compiled_map_writer & out_;
+};
+
+void write_path_ptr(compiled_map_writer & out, path_expression_ptr const& path)
+{
+    out.write(static_cast<bool>(path));
+    if (!path) return;
+    out.write(static_cast<boost::uint32_t>(path->size()));
+    for (path_expression::const_iterator itr = path->begin(); itr != path->end(); ++itr)
+    {
+        boost::apply_visitor(write_path_component(out), *itr);
+    }
+}
+
+path_expression_ptr read_path_ptr(compiled_map_reader & in)
+{
+    if (!in.get<bool>()) return path_expression_ptr();
+    path_expression_ptr path = boost::make_shared<path_expression>();
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        bool is_attribute = in.get<bool>();
+        std::string str = in.get<std::string>();
+        if (is_attribute)
+            path->push_back(attribute(str));
+        else
+            path->push_back(str);
+    }
+    return path;
+}
+
+// misc value types
+
+void write_params(compiled_map_writer & out, parameters const& params)
+{
+    out.write(static_cast<boost::uint32_t>(params.size()));
+    for (parameters::const_iterator itr = params.begin(); itr != params.end(); ++itr)
+    {
+        out.write(itr->first);
+        value_holder const& val = itr->second;
+        out.write(static_cast<boost::uint32_t>(val.which()));
+        if (int const* i = boost::get<int>(&val))
+            out.write(static_cast<boost::int32_t>(*i));
+        else if (double const* d = boost::get<double>(&val))
+            out.write(*d);
+        else
+            out.write(boost::get<std::string>(val));
+    }
+}
+
+void read_params(compiled_map_reader & in, parameters & params)
+{
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        std::string name = in.get<std::string>();
+        switch (in.get<boost::uint32_t>())
+        {
+        case 0:
+            params[name] = static_cast<int>(in.get<boost::int32_t>());
+            break;
+        case 1:
+            params[name] = in.get<double>();
+            break;
+        case 2:
+            params[name] = in.get<std::string>();
+            break;
+        default:
+            throw config_error("compiled map: unknown parameter type");
+        }
+    }
+}
+
+void write_ptree(compiled_map_writer & out, ptree const& pt)
+{
+    out.write(pt.data());
+    out.write(static_cast<boost::uint32_t>(pt.size()));
+    for (ptree::const_iterator itr = pt.begin(); itr != pt.end(); ++itr)
+    {
+        out.write(itr->first);
+        write_ptree(out, itr->second);
+    }
+}
+
+void read_ptree(compiled_map_reader & in, ptree & pt)
+{
+    pt.data() = in.get<std::string>();
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        std::string key = in.get<std::string>();
+        ptree & child = pt.push_back(ptree::value_type(key, ptree()))->second;
+        read_ptree(in, child);
+    }
+}
+
+void write_fontset(compiled_map_writer & out, font_set const& fset)
+{
+    out.write(fset.get_name());
+    std::vector<std::string> const& faces = fset.get_face_names();
+    out.write(static_cast<boost::uint32_t>(faces.size()));
+    for (unsigned i = 0; i < faces.size(); ++i)
+    {
+        out.write(faces[i]);
+    }
+}
+
+font_set read_fontset(compiled_map_reader & in)
+{
+    font_set fset(in.get<std::string>());
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        fset.add_face_name(in.get<std::string>());
+    }
+    return fset;
+}
+
+void write_stroke(compiled_map_writer & out, stroke const& s)
+{
+    out.write(s.get_color());
+    out.write(s.get_width());
+    out.write(s.get_opacity());
+    out.write(s.get_line_cap());
+    out.write(s.get_line_join());
+    out.write(s.get_gamma());
+    dash_array const& dash = s.get_dash_array();
+    out.write(static_cast<boost::uint32_t>(dash.size()));
+    for (unsigned i = 0; i < dash.size(); ++i)
+    {
+        out.write(dash[i].first);
+        out.write(dash[i].second);
+    }
+    out.write(s.dash_offset());
+}
+
+stroke read_stroke(compiled_map_reader & in)
+{
+    stroke s;
+    s.set_color(in.get<color>());
+    s.set_width(in.get<double>());
+    s.set_opacity(in.get<double>());
+    s.set_line_cap(in.get<line_cap_e>());
+    s.set_line_join(in.get<line_join_e>());
+    s.set_gamma(in.get<double>());
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        double dash = in.get<double>();
+        double gap = in.get<double>();
+        s.add_dash(dash, gap);
+    }
+    s.set_dash_offset(in.get<double>());
+    return s;
+}
+
+void write_colorizer(compiled_map_writer & out, raster_colorizer_ptr const& colorizer)
+{
+    out.write(static_cast<bool>(colorizer));
+    if (!colorizer) return;
+    out.write(colorizer->get_default_mode());
+    out.write(colorizer->get_default_color());
+    out.write(colorizer->get_epsilon());
+    colorizer_stops const& stops = colorizer->get_stops();
+    out.write(static_cast<boost::uint32_t>(stops.size()));
+    for (unsigned i = 0; i < stops.size(); ++i)
+    {
+        out.write(stops[i].get_value());
+        out.write(stops[i].get_mode());
+        out.write(stops[i].get_color());
+    }
+}
+
+raster_colorizer_ptr read_colorizer(compiled_map_reader & in)
+{
+    if (!in.get<bool>()) return raster_colorizer_ptr();
+    colorizer_mode mode = in.get<colorizer_mode>();
+    color default_color = in.get<color>();
+    raster_colorizer_ptr colorizer = boost::make_shared<raster_colorizer>(mode, default_color);
+    colorizer->set_epsilon(in.get<float>());
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        float value = in.get<float>();
+        colorizer_mode stop_mode = in.get<colorizer_mode>();
+        color stop_color = in.get<color>();
+        colorizer->add_stop(colorizer_stop(value, stop_mode, stop_color));
+    }
+    return colorizer;
+}
+
+// symbolizers, in the order of the symbolizer variant
+
+void write_base(compiled_map_writer & out, symbolizer_base const& sym)
+{
+    out.write(sym.get_metawriter_name());
+    metawriter_properties const& props = sym.get_metawriter_properties_overrides();
+    out.write(static_cast<boost::uint32_t>(props.size()));
+    for (metawriter_properties::const_iterator itr = props.begin(); itr != props.end(); ++itr)
+    {
+        out.write(*itr);
+    }
+    out.write(sym.get_clip());
+    out.write(sym.get_simplify_tolerance());
+}
+
+void read_base(compiled_map_reader & in, symbolizer_base & sym)
+{
+    std::string name = in.get<std::string>();
+    metawriter_properties props;
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        props.insert(in.get<std::string>());
+    }
+    if (!name.empty()) sym.add_metawriter(name, props);
+    sym.set_clip(in.get<bool>());
+    sym.set_simplify_tolerance(in.get<double>());
+}
+
+void write_image(compiled_map_writer & out, symbolizer_with_image const& sym)
+{
+    write_path_ptr(out, sym.get_filename());
+    out.write(sym.get_opacity());
+    transform_type const& tr = sym.get_transform();
+    for (unsigned i = 0; i < tr.size(); ++i)
+    {
+        out.write(tr[i]);
+    }
+}
+
+void read_image(compiled_map_reader & in, symbolizer_with_image & sym)
+{
+    // the filename was consumed by the constructor
+    sym.set_opacity(in.get<float>());
+    transform_type tr;
+    for (unsigned i = 0; i < tr.size(); ++i)
+    {
+        tr[i] = in.get<double>();
+    }
+    sym.set_transform(tr);
+}
+
+void write_text(compiled_map_writer & out, text_symbolizer const& sym)
+{
+    // placements first, text size, displacement and alignments live there
+    text_placements_ptr placements = sym.get_placement_options();
+    text_placements_simple const* simple =
+        dynamic_cast<text_placements_simple const*>(placements.get());
+    out.write(simple != 0);
+    if (simple) out.write(simple->get_positions());
+
+    write_expression_ptr(out, sym.get_name());
+    write_expression_ptr(out, sym.get_orientation());
+    out.write(sym.get_face_name());
+    write_fontset(out, sym.get_fontset());
+    out.write(static_cast<boost::uint32_t>(sym.get_text_ratio()));
+    out.write(static_cast<boost::uint32_t>(sym.get_wrap_width()));
+    out.write(static_cast<boost::uint32_t>(sym.get_wrap_char()));
+    out.write(sym.get_text_transform());
+    out.write(static_cast<boost::uint32_t>(sym.get_line_spacing()));
+    out.write(static_cast<boost::uint32_t>(sym.get_character_spacing()));
+    out.write(static_cast<boost::uint32_t>(sym.get_label_spacing()));
+    out.write(static_cast<boost::uint32_t>(sym.get_label_position_tolerance()));
+    out.write(sym.get_force_odd_labels());
+    out.write(sym.get_max_char_angle_delta());
+    out.write(static_cast<boost::uint32_t>(sym.get_text_size()));
+    out.write(sym.get_fill());
+    out.write(sym.get_halo_fill());
+    out.write(sym.get_halo_radius());
+    out.write(sym.get_label_placement());
+    out.write(sym.get_vertical_alignment());
+    out.write(sym.get_horizontal_alignment());
+    out.write(sym.get_justify_alignment());
+    out.write(boost::get<0>(sym.get_anchor()));
+    out.write(boost::get<1>(sym.get_anchor()));
+    out.write(boost::get<0>(sym.get_displacement()));
+    out.write(boost::get<1>(sym.get_displacement()));
+    out.write(sym.get_avoid_edges());
+    out.write(sym.get_minimum_distance());
+    out.write(sym.get_minimum_padding());
+    out.write(sym.get_allow_overlap());
+    out.write(sym.get_text_opacity());
+    out.write(sym.get_wrap_before());
+    write_base(out, sym);
+}
+
+text_placements_ptr read_placements(compiled_map_reader & in)
+{
+    if (in.get<bool>())
+        return text_placements_ptr(new text_placements_simple(in.get<std::string>()));
+    return text_placements_ptr(new text_placements_dummy());
+}
+
+void read_text(compiled_map_reader & in, text_symbolizer & sym)
+{
+    sym.set_orientation(read_expression_ptr(in));
+    sym.set_face_name(in.get<std::string>());
+    sym.set_fontset(read_fontset(in));
+    sym.set_text_ratio(in.get<boost::uint32_t>());
+    sym.set_wrap_width(in.get<boost::uint32_t>());
+    sym.set_wrap_char(static_cast<unsigned char>(in.get<boost::uint32_t>()));
+    sym.set_text_transform(in.get<text_transform_e>());
+    sym.set_line_spacing(in.get<boost::uint32_t>());
+    sym.set_character_spacing(in.get<boost::uint32_t>());
+    sym.set_label_spacing(in.get<boost::uint32_t>());
+    sym.set_label_position_tolerance(in.get<boost::uint32_t>());
+    sym.set_force_odd_labels(in.get<bool>());
+    sym.set_max_char_angle_delta(in.get<double>());
+    sym.set_text_size(in.get<boost::uint32_t>());
+    sym.set_fill(in.get<color>());
+    sym.set_halo_fill(in.get<color>());
+    sym.set_halo_radius(in.get<double>());
+    sym.set_label_placement(in.get<label_placement_e>());
+    sym.set_vertical_alignment(in.get<vertical_alignment_e>());
+    sym.set_horizontal_alignment(in.get<horizontal_alignment_e>());
+    sym.set_justify_alignment(in.get<justify_alignment_e>());
+    double ax = in.get<double>();
+    double ay = in.get<double>();
+    sym.set_anchor(ax, ay);
+    double dx = in.get<double>();
+    double dy = in.get<double>();
+    sym.set_displacement(dx, dy);
+    sym.set_avoid_edges(in.get<bool>());
+    sym.set_minimum_distance(in.get<double>());
+    sym.set_minimum_padding(in.get<double>());
+    sym.set_allow_overlap(in.get<bool>());
+    sym.set_text_opacity(in.get<double>());
+    sym.set_wrap_before(in.get<bool>());
+    read_base(in, sym);
+}
+
+class write_symbolizer : public boost::static_visitor<>
+{
+public:
+    explicit write_symbolizer(compiled_map_writer & out)
+        : out_(out) {}
+
+    void operator() (point_symbolizer const& sym) const
+    {
+        write_image(out_, sym);
+        out_.write(sym.get_allow_overlap());
+        out_.write(sym.get_point_placement());
+        out_.write(sym.get_ignore_placement());
+        write_base(out_, sym);
+    }
+
+    void operator() (line_symbolizer const& sym) const
+    {
+        write_stroke(out_, sym.get_stroke());
+        write_base(out_, sym);
+    }
+
+    void operator() (line_pattern_symbolizer const& sym) const
+    {
+        write_image(out_, sym);
+        write_base(out_, sym);
+    }
+
+    void operator() (polygon_symbolizer const& sym) const
+    {
+        out_.write(sym.get_fill());
+        out_.write(sym.get_opacity());
+        out_.write(sym.get_gamma());
+        write_base(out_, sym);
+    }
+
+    void operator() (polygon_pattern_symbolizer const& sym) const
+    {
+        write_image(out_, sym);
+        out_.write(sym.get_alignment());
+        write_base(out_, sym);
+    }
+
+    void operator() (raster_symbolizer const& sym) const
+    {
+        out_.write(sym.get_mode());
+        out_.write(sym.get_scaling());
+        out_.write(sym.get_opacity());
+        out_.write(sym.get_filter_factor());
+        write_colorizer(out_, sym.get_colorizer());
+        write_base(out_, sym);
+    }
+
+    void operator() (shield_symbolizer const& sym) const
+    {
+        write_image(out_, sym);
+        write_text(out_, sym);
+        out_.write(sym.get_unlock_image());
+        out_.write(sym.get_no_text());
+        out_.write(boost::get<0>(sym.get_shield_displacement()));
+        out_.write(boost::get<1>(sym.get_shield_displacement()));
+    }
+
+    void operator() (text_symbolizer const& sym) const
+    {
+        write_text(out_, sym);
+    }
+
+    void operator() (building_symbolizer const& sym) const
+    {
+        out_.write(sym.get_fill());
+        out_.write(sym.height());
+        out_.write(sym.get_opacity());
+        write_base(out_, sym);
+    }
+
+    void operator() (markers_symbolizer const& sym) const
+    {
+        write_image(out_, sym);
+        out_.write(sym.get_allow_overlap());
+        out_.write(sym.get_spacing());
+        out_.write(sym.get_max_error());
+        out_.write(sym.get_fill());
+        out_.write(sym.get_width());
+        out_.write(sym.get_height());
+        write_stroke(out_, sym.get_stroke());
+        out_.write(sym.get_marker_placement());
+        out_.write(sym.get_marker_type());
+        write_base(out_, sym);
+    }
+
+    void operator() (glyph_symbolizer const& sym) const
+    {
+        out_.write(sym.get_face_name());
+        write_expression_ptr(out_, sym.get_char());
+        write_expression_ptr(out_, sym.get_angle());
+        write_expression_ptr(out_, sym.get_value());
+        write_expression_ptr(out_, sym.get_size());
+        write_expression_ptr(out_, sym.get_color());
+        write_colorizer(out_, sym.get_colorizer());
+        out_.write(sym.get_allow_overlap());
+        out_.write(sym.get_avoid_edges());
+        out_.write(boost::get<0>(sym.get_displacement()));
+        out_.write(boost::get<1>(sym.get_displacement()));
+        out_.write(sym.get_halo_fill());
+        out_.write(static_cast<boost::uint32_t>(sym.get_halo_radius()));
+        out_.write(sym.get_angle_mode());
+        write_base(out_, sym);
+    }
+
+private:
+    compiled_map_writer & out_;
+};
+
+symbolizer read_symbolizer(compiled_map_reader & in, unsigned which)
+{
+    switch (which)
+    {
+    case 0:
+    {
+        point_symbolizer sym(read_path_ptr(in));
+        read_image(in, sym);
+        sym.set_allow_overlap(in.get<bool>());
+        sym.set_point_placement(in.get<point_placement_e>());
+        sym.set_ignore_placement(in.get<bool>());
+        read_base(in, sym);
+        return sym;
+    }
+    case 1:
+    {
+        line_symbolizer sym(read_stroke(in));
+        read_base(in, sym);
+        return sym;
+    }
+    case 2:
+    {
+        line_pattern_symbolizer sym(read_path_ptr(in));
+        read_image(in, sym);
+        read_base(in, sym);
+        return sym;
+    }
+    case 3:
+    {
+        polygon_symbolizer sym(in.get<color>());
+        sym.set_opacity(in.get<double>());
+        sym.set_gamma(in.get<double>());
+        read_base(in, sym);
+        return sym;
+    }
+    case 4:
+    {
+        polygon_pattern_symbolizer sym(read_path_ptr(in));
+        read_image(in, sym);
+        sym.set_alignment(in.get<pattern_alignment_e>());
+        read_base(in, sym);
+        return sym;
+    }
+    case 5:
+    {
+        raster_symbolizer sym;
+        sym.set_mode(in.get<std::string>());
+        sym.set_scaling(in.get<std::string>());
+        sym.set_opacity(in.get<float>());
+        sym.set_filter_factor(in.get<double>());
+        sym.set_colorizer(read_colorizer(in));
+        read_base(in, sym);
+        return sym;
+    }
+    case 6:
+    {
+        path_expression_ptr file = read_path_ptr(in);
+        float opacity = in.get<float>();
+        transform_type tr;
+        for (unsigned i = 0; i < tr.size(); ++i)
+        {
+            tr[i] = in.get<double>();
+        }
+        text_placements_ptr placements = read_placements(in);
+        expression_ptr name = read_expression_ptr(in);
+        shield_symbolizer sym(name, 10, color(0,0,0), file);
+        sym.set_opacity(opacity);
+        sym.set_transform(tr);
+        sym.set_placement_options(placements);
+        read_text(in, sym);
+        sym.set_unlock_image(in.get<bool>());
+        sym.set_no_text(in.get<bool>());
+        double dx = in.get<double>();
+        double dy = in.get<double>();
+        sym.set_shield_displacement(dx, dy);
+        return sym;
+    }
+    case 7:
+    {
+        text_placements_ptr placements = read_placements(in);
+        expression_ptr name = read_expression_ptr(in);
+        text_symbolizer sym(name, 10, color(0,0,0), placements);
+        read_text(in, sym);
+        return sym;
+    }
+    case 8:
+    {
+        color fill = in.get<color>();
+        double height = in.get<double>();
+        building_symbolizer sym(fill, height);
+        sym.set_opacity(in.get<double>());
+        read_base(in, sym);
+        return sym;
+    }
+    case 9:
+    {
+        markers_symbolizer sym(read_path_ptr(in));
+        read_image(in, sym);
+        sym.set_allow_overlap(in.get<bool>());
+        sym.set_spacing(in.get<double>());
+        sym.set_max_error(in.get<double>());
+        sym.set_fill(in.get<color>());
+        sym.set_width(in.get<double>());
+        sym.set_height(in.get<double>());
+        sym.set_stroke(read_stroke(in));
+        sym.set_marker_placement(in.get<marker_placement_e>());
+        sym.set_marker_type(in.get<marker_type_e>());
+        read_base(in, sym);
+        return sym;
+    }
+    case 10:
+    {
+        std::string face_name = in.get<std::string>();
+        glyph_symbolizer sym(face_name, read_expression_ptr(in));
+        sym.set_angle(read_expression_ptr(in));
+        sym.set_value(read_expression_ptr(in));
+        sym.set_size(read_expression_ptr(in));
+        sym.set_color(read_expression_ptr(in));
+        sym.set_colorizer(read_colorizer(in));
+        sym.set_allow_overlap(in.get<bool>());
+        sym.set_avoid_edges(in.get<bool>());
+        double dx = in.get<double>();
+        double dy = in.get<double>();
+        sym.set_displacement(dx, dy);
+        sym.set_halo_fill(in.get<color>());
+        sym.set_halo_radius(in.get<boost::uint32_t>());
+        sym.set_angle_mode(in.get<angle_mode_e>());
+        read_base(in, sym);
+        return sym;
+    }
+    }
+    throw config_error("compiled map: unknown symbolizer type");
+}
+
+// styles and layers
+
+void write_rule(compiled_map_writer & out, rule const& r)
+{
+    out.write(r.get_name());
+    out.write(r.get_title());
+    out.write(r.get_abstract());
+    out.write(r.get_min_scale());
+    out.write(r.get_max_scale());
+    write_expression_ptr(out, r.get_filter());
+    out.write(r.has_else_filter());
+    rule::symbolizers const& syms = r.get_symbolizers();
+    out.write(static_cast<boost::uint32_t>(syms.size()));
+    write_symbolizer visitor(out);
+    for (rule::symbolizers::const_iterator itr = syms.begin(); itr != syms.end(); ++itr)
+    {
+        out.write(static_cast<boost::uint32_t>(itr->which()));
+        boost::apply_visitor(visitor, *itr);
+    }
+}
+
+rule read_rule(compiled_map_reader & in)
+{
+    rule r;
+    r.set_name(in.get<std::string>());
+    r.set_title(in.get<std::string>());
+    r.set_abstract(in.get<std::string>());
+    r.set_min_scale(in.get<double>());
+    r.set_max_scale(in.get<double>());
+    expression_ptr filter = read_expression_ptr(in);
+    if (filter) r.set_filter(filter);
+    r.set_else(in.get<bool>());
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        r.append(read_symbolizer(in, in.get<boost::uint32_t>()));
+    }
+    return r;
+}
+
+void write_style(compiled_map_writer & out, feature_type_style const& style)
+{
+    out.write(style.get_filter_mode());
+    rules const& rs = style.get_rules();
+    out.write(static_cast<boost::uint32_t>(rs.size()));
+    for (rules::const_iterator itr = rs.begin(); itr != rs.end(); ++itr)
+    {
+        write_rule(out, *itr);
+    }
+}
+
+feature_type_style read_style(compiled_map_reader & in)
+{
+    feature_type_style style;
+    style.set_filter_mode(in.get<filter_mode_e>());
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        style.add_rule(read_rule(in));
+    }
+    return style;
+}
+
+void write_layer(compiled_map_writer & out, layer const& lyr)
+{
+    out.write(lyr.name());
+    out.write(lyr.title());
+    out.write(lyr.abstract());
+    out.write(lyr.srs());
+    out.write(lyr.getMinZoom());
+    out.write(lyr.getMaxZoom());
+    out.write(lyr.isActive());
+    out.write(lyr.isQueryable());
+    out.write(lyr.clear_label_cache());
+    out.write(lyr.cache_features());
+    std::vector<std::string> const& styles = lyr.styles();
+    out.write(static_cast<boost::uint32_t>(styles.size()));
+    for (unsigned i = 0; i < styles.size(); ++i)
+    {
+        out.write(styles[i]);
+    }
+    datasource_ptr ds = lyr.datasource();
+    out.write(static_cast<bool>(ds));
+    if (ds) write_params(out, ds->params());
+}
+
+layer read_layer(compiled_map_reader & in)
+{
+    std::string name = in.get<std::string>();
+    layer lyr(name);
+    lyr.set_title(in.get<std::string>());
+    lyr.set_abstract(in.get<std::string>());
+    lyr.set_srs(in.get<std::string>());
+    lyr.setMinZoom(in.get<double>());
+    lyr.setMaxZoom(in.get<double>());
+    lyr.setActive(in.get<bool>());
+    lyr.setQueryable(in.get<bool>());
+    lyr.set_clear_label_cache(in.get<bool>());
+    lyr.set_cache_features(in.get<bool>());
+    boost::uint32_t size = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < size; ++i)
+    {
+        lyr.add_style(in.get<std::string>());
+    }
+    if (in.get<bool>())
+    {
+        parameters params;
+        read_params(in, params);
+        try
+        {
+            lyr.set_datasource(datasource_cache::instance()->create(params));
+        }
+        catch (const mapnik::datasource_exception & ex)
+        {
+            throw config_error(ex.what());
+        }
+    }
+    return lyr;
+}
+
+void write_header(compiled_map_writer & out, source_stamp const& stamp)
+{
+    for (unsigned i = 0; i < sizeof(compiled_map_magic); ++i)
+    {
+        out.write_pod(compiled_map_magic[i]);
+    }
+    out.write(byte_order_mark);
+    out.write(compiled_map_format);
+    out.write(static_cast<boost::uint32_t>(MAPNIK_VERSION));
+    out.write(stamp.size);
+    out.write(stamp.hash);
+}
+
+bool read_header(compiled_map_reader & in, source_stamp const& stamp)
+{
+    for (unsigned i = 0; i < sizeof(compiled_map_magic); ++i)
+    {
+        char c;
+        in.read_pod(c);
+        if (c != compiled_map_magic[i])
+            throw config_error("compiled map: not a compiled map file");
+    }
+    if (in.get<boost::uint32_t>() != byte_order_mark) return false;
+    if (in.get<boost::uint32_t>() != compiled_map_format) return false;
+    if (in.get<boost::uint32_t>() != static_cast<boost::uint32_t>(MAPNIK_VERSION)) return false;
+    boost::uint64_t size = in.get<boost::uint64_t>();
+    boost::uint64_t hash = in.get<boost::uint64_t>();
+    return size == stamp.size && hash == stamp.hash;
+}
+
+void serialize_map(compiled_map_writer & out, Map const& map)
+{
+    out.write(map.srs());
+    out.write(static_cast<boost::int32_t>(map.buffer_size()));
+    out.write(map.base_path());
+    out.write(static_cast<boost::int32_t>(map.get_aspect_fix_mode()));
+
+    boost::optional<color> const& bg = map.background();
+    out.write(static_cast<bool>(bg));
+    if (bg) out.write(*bg);
+
+    boost::optional<std::string> const& bg_image = map.background_image();
+    out.write(static_cast<bool>(bg_image));
+    if (bg_image) out.write(*bg_image);
+
+    boost::optional<box2d<double> > const& max_extent = map.maximum_extent();
+    out.write(static_cast<bool>(max_extent));
+    if (max_extent) out.write(*max_extent);
+
+    write_params(out, map.get_extra_attributes());
+
+    std::map<std::string,font_set> const& fontsets = map.fontsets();
+    out.write(static_cast<boost::uint32_t>(fontsets.size()));
+    for (std::map<std::string,font_set>::const_iterator itr = fontsets.begin();
+         itr != fontsets.end(); ++itr)
+    {
+        out.write(itr->first);
+        write_fontset(out, itr->second);
+    }
+
+    std::map<std::string,metawriter_ptr> const& writers = map.metawriters();
+    out.write(static_cast<boost::uint32_t>(writers.size()));
+    for (std::map<std::string,metawriter_ptr>::const_iterator itr = writers.begin();
+         itr != writers.end(); ++itr)
+    {
+        ptree pt;
+        metawriter_save(itr->second, pt, true);
+        out.write(itr->first);
+        write_ptree(out, pt);
+    }
+
+    std::map<std::string,feature_type_style> const& styles = map.styles();
+    out.write(static_cast<boost::uint32_t>(styles.size()));
+    for (Map::const_style_iterator itr = styles.begin(); itr != styles.end(); ++itr)
+    {
+        out.write(itr->first);
+        write_style(out, itr->second);
+    }
+
+    std::vector<layer> const& layers = map.layers();
+    out.write(static_cast<boost::uint32_t>(layers.size()));
+    for (unsigned i = 0; i < layers.size(); ++i)
+    {
+        write_layer(out, layers[i]);
+    }
+}
+
+void deserialize_map(compiled_map_reader & in, Map & map)
+{
+    map.set_srs(in.get<std::string>());
+    map.set_buffer_size(in.get<boost::int32_t>());
+    map.set_base_path(in.get<std::string>());
+    boost::int32_t afm = in.get<boost::int32_t>();
+    if (afm < 0 || afm >= Map::aspect_fix_mode_MAX)
+        throw config_error("compiled map: enumeration value out of range");
+    map.set_aspect_fix_mode(static_cast<Map::aspect_fix_mode>(afm));
+
+    if (in.get<bool>()) map.set_background(in.get<color>());
+    if (in.get<bool>()) map.set_background_image(in.get<std::string>());
+    if (in.get<bool>()) map.set_maximum_extent(in.get<box2d<double> >());
+
+    parameters extra_attr;
+    read_params(in, extra_attr);
+    map.set_extra_attributes(extra_attr);
+
+    boost::uint32_t count = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < count; ++i)
+    {
+        std::string name = in.get<std::string>();
+        map.insert_fontset(name, read_fontset(in));
+    }
+
+    count = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < count; ++i)
+    {
+        std::string name = in.get<std::string>();
+        ptree pt;
+        read_ptree(in, pt);
+        map.insert_metawriter(name, metawriter_create(pt));
+    }
+
+    count = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < count; ++i)
+    {
+        std::string name = in.get<std::string>();
+        map.insert_style(name, read_style(in));
+    }
+
+    count = in.get<boost::uint32_t>();
+    for (boost::uint32_t i = 0; i < count; ++i)
+    {
+        map.addLayer(read_layer(in));
+    }
+
+    if (!in.at_end())
+        throw config_error("compiled map: trailing data");
+    map.init_metawriters();
+}
+
+std::string font_directory(Map const& map, std::string const& source)
+{
+    boost::optional<std::string> dir = map.get_extra_attributes().get<std::string>("font-directory");
+    if (!dir) return "";
+    boost::filesystem::path rel_path(*dir);
+    if (rel_path.has_root_path() || source.empty()) return *dir;
+    // same resolution load_map applies to relative paths
+#if (BOOST_FILESYSTEM_VERSION == 3)
+    return boost::filesystem::absolute(boost::filesystem::path(source).parent_path()/rel_path).string();
+#else // v2
+    return boost::filesystem::complete(boost::filesystem::path(source).branch_path()/rel_path).normalize().string();
+#endif
+}
+
+// <filename>.<pid>.<n>.tmp, unique within and across processes
+std::string unique_temp_name(std::string const& filename)
+{
+    static boost::mutex mutex;
+    static unsigned counter = 0;
+    unsigned n;
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        n = counter++;
+    }
+#ifdef _WINDOWS
+    int pid = _getpid();
+#else
+    int pid = ::getpid();
+#endif
+    return filename + "." + boost::lexical_cast<std::string>(pid)
+        + "." + boost::lexical_cast<std::string>(n) + ".tmp";
+}
+
+// atomically replaces dest with src, dest may exist
+bool replace_file(std::string const& src, std::string const& dest)
+{
+#ifdef _WINDOWS
+    return MoveFileExA(src.c_str(), dest.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(src.c_str(), dest.c_str()) == 0;
+#endif
+}
+
+}
+
+void save_compiled_map(Map const& map, std::string const& filename, std::string const& source)
+{
+    source_stamp stamp;
+    if (!source.empty() && !stamp_source(source, stamp))
+    {
+        throw config_error("Could not read '" + source + "'");
+    }
+
+    std::string buf;
+    compiled_map_writer out(buf);
+    write_header(out, stamp);
+    serialize_map(out, map);
+
+    // write next to the target and rename over it, readers never see
+    // half a file and concurrent writers never share a temp file
+    std::string tmp = unique_temp_name(filename);
+    {
+        std::ofstream file(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            throw config_error("Could not write compiled map to '" + filename + "'");
+        }
+        file.write(buf.data(), buf.size());
+        if (!file)
+        {
+            file.close();
+            std::remove(tmp.c_str());
+            throw config_error("Could not write compiled map to '" + filename + "'");
+        }
+    }
+    if (!replace_file(tmp, filename))
+    {
+        std::remove(tmp.c_str());
+        throw config_error("Could not write compiled map to '" + filename + "'");
+    }
+}
+
+bool load_compiled_map(Map & map, std::string const& filename, std::string const& source)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file) return false;
+    std::string buf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    source_stamp stamp;
+    if (!source.empty() && !stamp_source(source, stamp)) return false;
+
+    compiled_map_reader in(buf.data(), buf.data() + buf.size());
+    if (!read_header(in, stamp)) return false;
+
+    // build into a copy so a broken file leaves the map as it was
+    Map tmp(map);
+    deserialize_map(in, tmp);
+    std::string font_dir = font_directory(tmp, source);
+    if (!font_dir.empty())
+    {
+        freetype_engine::register_fonts(font_dir, false);
+    }
+    map = tmp;
+    return true;
+}
+
+void load_map_cached(Map & map, std::string const& filename, std::string const& cache_filename, bool strict)
+{
+    try
+    {
+        if (load_compiled_map(map, cache_filename, filename))
+            return;
+    }
+    catch (const config_error & ex)
+    {
+        std::clog << "### WARNING: ignoring compiled map '" << cache_filename
+                  << "': " << ex.what() << std::endl;
+    }
+
+    load_map(map, filename, strict);
+    try
+    {
+        save_compiled_map(map, cache_filename, filename);
+    }
+    catch (const std::exception & ex)
+    {
+        std::clog << "### WARNING: could not write compiled map '" << cache_filename
+                  << "': " << ex.what() << std::endl;
+    }
+}
+
+}
@@ -58,8 +58,20 @@ datasource_cache::~datasource_cache()
     lt_dlexit();
 }
 
-std::map<string,boost::shared_ptr<PluginInfo> > datasource_cache::plugins_;
+boost::shared_ptr<datasource_cache::plugin_map const> datasource_cache::plugins_ =
+    boost::make_shared<datasource_cache::plugin_map>();
+#ifdef MAPNIK_THREADSAFE
+mutex datasource_cache::plugins_mutex_;
+#endif
 bool datasource_cache::registered_=false;
+
+boost::shared_ptr<datasource_cache::plugin_map const> datasource_cache::plugins()
+{
+#ifdef MAPNIK_THREADSAFE
+    mutex::scoped_lock lock(plugins_mutex_);
+#endif
+    return plugins_;
+}
 std::vector<std::string> datasource_cache::plugin_directories_;
     
 datasource_ptr datasource_cache::create(const parameters& params, bool bind) 
@@ -72,29 +84,14 @@ datasource_ptr datasource_cache::create(const parameters& params, bool bind)
     }
 
     datasource_ptr ds;
-    std::map<string,boost::shared_ptr<PluginInfo> >::iterator itr=plugins_.find(*type);
-    if ( itr == plugins_.end() )
+    boost::shared_ptr<plugin_map const> plugins = datasource_cache::plugins();
+    plugin_map::const_iterator itr=plugins->find(*type);
+    if ( itr == plugins->end() )
     {
         throw config_error(string("Could not create datasource. No plugin ") +
                            "found for type '" + * type + "' (searched in: " + plugin_directories() + ")");
     }
-    if ( ! itr->second->handle())
-    {
-        throw std::runtime_error(string("Cannot load library: ") +
-                                 lt_dlerror());
-    }
-    // http://www.mr-edd.co.uk/blog/supressing_gcc_warnings
-    #ifdef __GNUC__
-    __extension__
-    #endif
-    create_ds* create_datasource = 
-        reinterpret_cast<create_ds*>(lt_dlsym(itr->second->handle(), "create"));
-
-    if ( ! create_datasource)
-    {
-        throw std::runtime_error(string("Cannot load symbols: ") +
-                                 lt_dlerror());
-    }
+    create_ds* create_datasource = itr->second.create;
 #ifdef MAPNIK_DEBUG
     std::clog << "size = " << params.size() << "\n";
     parameters::const_iterator i = params.begin();
@@ -111,10 +108,31 @@ datasource_ptr datasource_cache::create(const parameters& params, bool bind)
     return ds;
 }
 
-bool datasource_cache::insert(const std::string& type,const lt_dlhandle module)
+bool datasource_cache::insert(plugin_map & plugins, const std::string& type,const lt_dlhandle module)
 {
-    return plugins_.insert(make_pair(type,boost::make_shared<PluginInfo>
-                                     (type,module))).second;
+    if (plugins.find(type) != plugins.end())
+    {
+        lt_dlclose(module);
+        return false;
+    }
+
+    // http://www.mr-edd.co.uk/blog/supressing_gcc_warnings
+    #ifdef __GNUC__
+    __extension__
+    #endif
+    create_ds* create_datasource = 
+        reinterpret_cast<create_ds*>(lt_dlsym(module, "create"));
+    if ( ! create_datasource)
+    {
+        std::clog << "Datasource loader: cannot load symbols of " << type << ": " << lt_dlerror() << std::endl;
+        lt_dlclose(module);
+        return false;
+    }
+    plugin_entry entry;
+    entry.info = boost::make_shared<PluginInfo>(type,module);
+    entry.create = create_datasource;
+    plugins.insert(make_pair(type,entry));
+    return true;
 }
 
 std::string datasource_cache::plugin_directories()
@@ -125,8 +143,9 @@ std::string datasource_cache::plugin_directories()
 std::vector<std::string> datasource_cache::plugin_names ()
 {
     std::vector<std::string> names;
-    std::map<std::string,boost::shared_ptr<PluginInfo> >::const_iterator itr;
-    for (itr = plugins_.begin();itr!=plugins_.end();++itr)
+    boost::shared_ptr<plugin_map const> plugins = datasource_cache::plugins();
+    plugin_map::const_iterator itr;
+    for (itr = plugins->begin();itr!=plugins->end();++itr)
     {
         names.push_back(itr->first);
     }
@@ -139,9 +158,15 @@ void datasource_cache::register_datasources(const std::string& str)
     mutex::scoped_lock lock(mapnik::singleton<mapnik::datasource_cache,
                             mapnik::CreateStatic>::mutex_);
 #endif
+    // every plugin of a directory is already open once it has been scanned
+    if (std::find(plugin_directories_.begin(),plugin_directories_.end(),str) != plugin_directories_.end())
+    {
+        return;
+    }
     boost::filesystem::path path(str);
     plugin_directories_.push_back(str);
     boost::filesystem::directory_iterator end_itr;
+    boost::shared_ptr<plugin_map> plugins = boost::make_shared<plugin_map>(*datasource_cache::plugins());
  
     if (exists(path) && is_directory(path))
     {
@@ -211,7 +236,12 @@ void datasource_cache::register_datasources(const std::string& str)
                         #endif
                         datasource_name* ds_name = 
                             reinterpret_cast<datasource_name*>(lt_dlsym(module, "datasource_name"));
-                        if (ds_name && insert(ds_name(),module))
+                        if (!ds_name)
+                        {
+                            lt_dlclose(module);
+                        }
+                        // insert() closes the module if it is not kept
+                        else if (insert(*plugins,ds_name(),module))
                         {            
 #ifdef MAPNIK_DEBUG
                             std::clog << "Datasource loader: registered: " << ds_name() << std::endl;
@@ -234,5 +264,11 @@ void datasource_cache::register_datasources(const std::string& str)
             }
         }
     }
+    // publish the new map once it is complete, readers still holding
+    // the old one keep it alive until they are done
+#ifdef MAPNIK_THREADSAFE
+    mutex::scoped_lock publish_lock(plugins_mutex_);
+#endif
+    plugins_ = plugins;
 }
 }
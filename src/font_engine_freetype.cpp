@@ -27,21 +27,59 @@
 // boost
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/tss.hpp>
+#endif
+
+// stl
+#include <fstream>
 
 namespace mapnik
 {
-freetype_engine::freetype_engine()
+
+namespace {
+
+// FreeType library and faces of the calling thread
+struct font_cache : private boost::noncopyable
 {
-    FT_Error error = FT_Init_FreeType( &library_ );
-    if (error)
+    font_cache()
+    {
+        FT_Library library;
+        FT_Error error = FT_Init_FreeType(&library);
+        if (error)
+        {
+            throw std::runtime_error("can not load FreeType2 library");
+        }
+        library_ = ft_library_ptr(library, FT_Done_FreeType);
+    }
+
+    ft_library_ptr library_;
+    std::map<std::string,face_ptr> faces_;
+};
+
+font_cache & thread_font_cache()
+{
+#ifdef MAPNIK_THREADSAFE
+    static boost::thread_specific_ptr<font_cache> cache;
+    if (!cache.get())
     {
-        throw std::runtime_error("can not load FreeType2 library");
+        cache.reset(new font_cache);
     }
+    return *cache;
+#else
+    static font_cache cache;
+    return cache;
+#endif
+}
+
+}
+
+freetype_engine::freetype_engine()
+{
 }
    
 freetype_engine::~freetype_engine()
 {   
-    FT_Done_FreeType(library_);   
 }
 
 bool freetype_engine::is_font_file(std::string const& file_name)
@@ -58,69 +96,93 @@ bool freetype_engine::is_font_file(std::string const& file_name)
         boost::algorithm::ends_with(fn,std::string(".dfont"));
 }
 
-bool freetype_engine::register_font(std::string const& file_name)
+bool freetype_engine::add_font_file(std::string const& file_name)
 {
     if (!boost::filesystem::is_regular_file(file_name) || !is_font_file(file_name)) return false;
-#ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(mutex_);
-#endif
-    FT_Library library;
-    FT_Error error = FT_Init_FreeType(&library);
-    if (error)
-    {
-        throw std::runtime_error("Failed to initialize FreeType2 library");
-    }
-      
     FT_Face face;
-    error = FT_New_Face (library,file_name.c_str(),0,&face);
+    FT_Error error = FT_New_Face (thread_font_cache().library_.get(),file_name.c_str(),0,&face);
     if (error)
     {
-        FT_Done_FreeType(library);
         return false;
     }
     std::string name = std::string(face->family_name) + " " + std::string(face->style_name);
     name2file_.insert(std::make_pair(name,file_name));
     FT_Done_Face(face );   
-    FT_Done_FreeType(library);
     return true;
 }
 
-bool freetype_engine::register_fonts(std::string const& dir, bool recurse)
+void freetype_engine::scan_fonts(std::string const& dir, bool recurse)
 {
-    boost::filesystem::path path(dir);
-    
-    if (!boost::filesystem::exists(path))
-      return false;
-
-    if (!boost::filesystem::is_directory(path))
-      return mapnik::freetype_engine::register_font(dir); 
-    
     boost::filesystem::directory_iterator end_itr;
     for (boost::filesystem::directory_iterator itr(dir); itr != end_itr; ++itr)
     {
-        if (boost::filesystem::is_directory(*itr) && recurse)
-        {
 #if (BOOST_FILESYSTEM_VERSION == 3) 
-          if (!register_fonts(itr->path().string(), true)) return false;
+        std::string file_name = itr->path().string();
 #else // v2
-          if (!register_fonts(itr->string(), true)) return false;
+        std::string file_name = itr->string();
 #endif
+        if (boost::filesystem::is_directory(*itr))
+        {
+            if (recurse) scan_fonts(file_name, true);
         }
-        else 
+        else
         {
-#if (BOOST_FILESYSTEM_VERSION == 3) 
-            mapnik::freetype_engine::register_font(itr->path().string());
-#else // v2
-            mapnik::freetype_engine::register_font(itr->string());  
-#endif
+            add_font_file(file_name);
+        }
+    }
+}
+
+void freetype_engine::index_pending_fonts()
+{
+    // in registration order, so the first font registered under a name wins
+    for (unsigned i = 0; i < pending_dirs_.size(); ++i)
+    {
+        try
+        {
+            scan_fonts(pending_dirs_[i].first, pending_dirs_[i].second);
+        }
+        catch (boost::filesystem::filesystem_error const& ex)
+        {
+            std::clog << "### WARNING: could not register fonts from '"
+                      << pending_dirs_[i].first << "': " << ex.what() << std::endl;
         }
     }
+    pending_dirs_.clear();
+}
+
+bool freetype_engine::register_font(std::string const& file_name)
+{
+#ifdef MAPNIK_THREADSAFE
+    mutex::scoped_lock lock(mutex_);
+#endif
+    index_pending_fonts();
+    return add_font_file(file_name);
+}
+
+bool freetype_engine::register_fonts(std::string const& dir, bool recurse)
+{
+    boost::filesystem::path path(dir);
+    
+    if (!boost::filesystem::exists(path))
+      return false;
+
+    if (!boost::filesystem::is_directory(path))
+      return mapnik::freetype_engine::register_font(dir); 
+    
+#ifdef MAPNIK_THREADSAFE
+    mutex::scoped_lock lock(mutex_);
+#endif
+    pending_dirs_.push_back(std::make_pair(dir, recurse));
     return true;
 }
 
 
 std::vector<std::string> freetype_engine::face_names ()
 {
+#ifdef MAPNIK_THREADSAFE
+    mutex::scoped_lock lock(mutex_);
+#endif
+    index_pending_fonts();
     std::vector<std::string> names;
     std::map<std::string,std::string>::const_iterator itr;
     for (itr = name2file_.begin();itr!=name2file_.end();++itr)
@@ -130,30 +192,75 @@ std::vector<std::string> freetype_engine::face_names ()
     return names;
 }
 
-face_ptr freetype_engine::create_face(std::string const& family_name)
+font_data_ptr freetype_engine::font_data(std::string const& file_name)
 {
-    std::map<std::string,std::string>::iterator itr;
-    itr = name2file_.find(family_name);
-    if (itr != name2file_.end())
-    {
-        FT_Face face;
-        FT_Error error = FT_New_Face (library_,itr->second.c_str(),0,&face);
+    std::map<std::string,font_data_ptr>::const_iterator itr = file2data_.find(file_name);
+    if (itr != file2data_.end()) return itr->second;
 
-        if (!error)
+    font_data_ptr data;
+    std::ifstream file(file_name.c_str(), std::ios::in | std::ios::binary);
+    if (file)
+    {
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (size > 0)
         {
-            return face_ptr (new font_face(face));
+            data = boost::make_shared<std::vector<char> >(size);
+            if (!file.read(&(*data)[0], size)) data.reset();
         }
     }
-    return face_ptr();
+    // failures are not remembered, the file is opened from disk instead
+    if (data) file2data_.insert(std::make_pair(file_name, data));
+    return data;
+}
+
+face_ptr freetype_engine::create_face(std::string const& family_name)
+{
+    font_cache & cache = thread_font_cache();
+    std::map<std::string,face_ptr>::const_iterator cached = cache.faces_.find(family_name);
+    if (cached != cache.faces_.end()) return cached->second;
+
+    std::string file_name;
+    font_data_ptr data;
+    {
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(mutex_);
+#endif
+        index_pending_fonts();
+        std::map<std::string,std::string>::const_iterator itr = name2file_.find(family_name);
+        if (itr == name2file_.end()) return face_ptr();
+        file_name = itr->second;
+        data = font_data(file_name);
+    }
+
+    FT_Face face;
+    FT_Error error;
+    if (data)
+    {
+        error = FT_New_Memory_Face(cache.library_.get(),
+                                   reinterpret_cast<FT_Byte const*>(&(*data)[0]),
+                                   data->size(), 0, &face);
+    }
+    else
+    {
+        error = FT_New_Face(cache.library_.get(), file_name.c_str(), 0, &face);
+    }
+    if (error) return face_ptr();
+
+    face_ptr result = boost::make_shared<font_face>(face, cache.library_, data);
+    cache.faces_.insert(std::make_pair(family_name, result));
+    return result;
 }
 
 stroker_ptr freetype_engine::create_stroker()
 {
+    ft_library_ptr library = thread_font_cache().library_;
     FT_Stroker s;
-    FT_Error error = FT_Stroker_New(library_, &s); 
+    FT_Error error = FT_Stroker_New(library.get(), &s); 
     if (!error)
     {
-        return stroker_ptr(new stroker(s));
+        return stroker_ptr(new stroker(s, library));
     }
     return stroker_ptr();
 }
@@ -294,4 +401,6 @@ void font_face_set::get_string_info(string_info & info)
 boost::mutex freetype_engine::mutex_;
 #endif
 std::map<std::string,std::string> freetype_engine::name2file_;
+std::map<std::string,font_data_ptr> freetype_engine::file2data_;
+std::vector<std::pair<std::string,bool> > freetype_engine::pending_dirs_;
 }
@@ -73,6 +73,24 @@ grid_renderer<T>::grid_renderer(Map const& m, T & pixmap, double scale_factor, u
 #endif
 }
 
+template <typename T>
+grid_renderer<T>::grid_renderer(Map const& m, request const& req, T & pixmap, double scale_factor, unsigned offset_x, unsigned offset_y)
+    : feature_style_processor<grid_renderer>(m, req, scale_factor),
+      pixmap_(pixmap),
+      width_(pixmap_.width()),
+      height_(pixmap_.height()),
+      scale_factor_(scale_factor),
+      t_(pixmap_.width(),pixmap_.height(),req.extent(),offset_x,offset_y),
+      font_engine_(),
+      font_manager_(font_engine_),
+      detector_(box2d<double>(-req.buffer_size(), -req.buffer_size(), pixmap_.width() + req.buffer_size(), pixmap_.height() + req.buffer_size())),
+      ras_ptr(new grid_rasterizer)
+{
+#ifdef MAPNIK_DEBUG
+    std::clog << "scale=" << req.scale() << "\n";
+#endif
+}
+
 template <typename T>
 grid_renderer<T>::~grid_renderer() {}
 
@@ -118,6 +136,7 @@ void grid_renderer<T>::end_layer_processing(layer const&)
 template <typename T>
 void grid_renderer<T>::render_marker(Feature const& feature, unsigned int step, const int x, const int y, marker &marker, const agg::trans_affine & tr, double opacity)
 {
+    typename T::value_type feature_id = pixmap_.pixel_id(feature);
     if (marker.is_vector())
     {
         typedef coord_transform2<CoordTransform,geometry_type> path_type;
@@ -151,7 +170,7 @@ void grid_renderer<T>::render_marker(Feature const& feature, unsigned int step,
                      mapnik::pixfmt_gray16> svg_renderer(svg_path,
                              (*marker.get_vector_data())->attributes());
 
-        svg_renderer.render_id(*ras_ptr, sl, renb, feature.id(), mtx, opacity, bbox);
+        svg_renderer.render_id(*ras_ptr, sl, renb, feature_id, mtx, opacity, bbox);
         
     }
     else
@@ -159,7 +178,7 @@ void grid_renderer<T>::render_marker(Feature const& feature, unsigned int step,
         image_data_32 const& data = **marker.get_bitmap_data();
         if (step == 1 && scale_factor_ == 1.0)
         {
-            pixmap_.set_rectangle(feature.id(), data, x, y);    
+            pixmap_.set_rectangle(feature_id, data, x, y);    
         }
         else
         {
@@ -167,7 +186,7 @@ void grid_renderer<T>::render_marker(Feature const& feature, unsigned int step,
             image_data_32 target(ratio * data.width(), ratio * data.height());
             mapnik::scale_image_agg<image_data_32>(target,data, SCALING_NEAR,
                 scale_factor_, 0.0, 0.0, 1.0, ratio);
-            pixmap_.set_rectangle(feature.id(), target, x, y);
+            pixmap_.set_rectangle(feature_id, target, x, y);
         }
     }
     pixmap_.add_feature(feature);
@@ -27,10 +27,7 @@
 #include <mapnik/grid/grid_pixfmt.hpp>
 #include <mapnik/grid/grid_pixel.hpp>
 #include <mapnik/grid/grid.hpp>
-#include <mapnik/segment.hpp>
-
-// boost
-#include <boost/scoped_ptr.hpp>
+#include <mapnik/building_extrusion.hpp>
 
 // agg
 #include "agg_rasterizer_scanline_aa.h"
@@ -46,7 +43,10 @@ void grid_renderer<T>::process(building_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
-    typedef coord_transform2<CoordTransform,geometry_type> path_type;
+    typename T::value_type feature_id = pixmap_.pixel_id(feature);
+    typedef building_walls<building_faces::const_iterator> walls_type;
+    typedef building_frame<geometry_type> frame_type;
+    typedef building_roof<geometry_type> roof_type;
     typedef agg::renderer_base<mapnik::pixfmt_gray16> ren_base;
     typedef agg::renderer_scanline_bin_solid<ren_base> renderer;
     agg::scanline_bin sl;
@@ -61,85 +61,39 @@ void grid_renderer<T>::process(building_symbolizer const& sym,
 
     double height = sym.height() * scale_factor_;
     
+    ren.color(mapnik::gray16(feature_id));
+    bool drawn = false;
+
     for (unsigned i=0;i<feature.num_geometries();++i)
     {
         geometry_type const& geom = feature.get_geometry(i);
         if (geom.num_points() > 2)
         {
-            boost::scoped_ptr<geometry_type> frame(new geometry_type(LineString));
-            boost::scoped_ptr<geometry_type> roof(new geometry_type(Polygon));
-            std::deque<segment_t> face_segments;
-            double x0(0);
-            double y0(0);
-            unsigned cm = geom.vertex(&x0,&y0);
-            for (unsigned j=1;j<geom.num_points();++j)
-            {
-                double x(0);
-                double y(0);
-                cm = geom.vertex(&x,&y);
-                if (cm == SEG_MOVETO)
-                {
-                    frame->move_to(x,y);
-                }
-                else if (cm == SEG_LINETO)
-                {
-                    frame->line_to(x,y);
-                    face_segments.push_back(segment_t(x0,y0,x,y));
-                }
-                
-                x0 = x;
-                y0 = y;
-            }
-            std::sort(face_segments.begin(),face_segments.end(), y_order);
-            std::deque<segment_t>::const_iterator itr=face_segments.begin();
-            for (;itr!=face_segments.end();++itr)
-            {
-                boost::scoped_ptr<geometry_type> faces(new geometry_type(Polygon));
-                faces->move_to(itr->get<0>(),itr->get<1>());
-                faces->line_to(itr->get<2>(),itr->get<3>());
-                faces->line_to(itr->get<2>(),itr->get<3>() + height);
-                faces->line_to(itr->get<0>(),itr->get<1>() + height);
-
-                path_type faces_path (t_,*faces,prj_trans);
-                ras_ptr->add_path(faces_path);
-                ren.color(mapnik::gray16(feature.id()));
-                agg::render_scanlines(*ras_ptr, sl, ren);
-                ras_ptr->reset();
-
-                frame->move_to(itr->get<0>(),itr->get<1>());
-                frame->line_to(itr->get<0>(),itr->get<1>()+height);
-            }
+            building_wall_segments(geom, wall_faces_);
+            walls_type walls(wall_faces_.begin(), wall_faces_.end(), height);
+            coord_transform2<CoordTransform,walls_type> walls_path(t_,walls,prj_trans);
+            ras_ptr->add_path(walls_path);
+            drawn = render_id_scanlines(*ras_ptr, sl, ren) || drawn;
+            ras_ptr->reset();
 
-            geom.rewind(0);
-            for (unsigned j=0;j<geom.num_points();++j)
-            {
-                double x,y;
-                unsigned cm = geom.vertex(&x,&y);
-                if (cm == SEG_MOVETO)
-                {
-                    frame->move_to(x,y+height);
-                    roof->move_to(x,y+height);
-                }
-                else if (cm == SEG_LINETO)
-                {
-                    frame->line_to(x,y+height);
-                    roof->line_to(x,y+height);
-                }
-            }
-            path_type path(t_,*frame,prj_trans);
-            agg::conv_stroke<path_type> stroke(path);
+            frame_type frame(geom, wall_faces_, height);
+            coord_transform2<CoordTransform,frame_type> frame_path(t_,frame,prj_trans);
+            agg::conv_stroke<coord_transform2<CoordTransform,frame_type> > stroke(frame_path);
             ras_ptr->add_path(stroke);
-            ren.color(mapnik::gray16(feature.id()));
-            agg::render_scanlines(*ras_ptr, sl, ren);
+            drawn = render_id_scanlines(*ras_ptr, sl, ren) || drawn;
             ras_ptr->reset();
 
-            path_type roof_path (t_,*roof,prj_trans);
+            roof_type roof(geom, height);
+            coord_transform2<CoordTransform,roof_type> roof_path(t_,roof,prj_trans);
             ras_ptr->add_path(roof_path);
-            ren.color(mapnik::gray16(feature.id()));
-            agg::render_scanlines(*ras_ptr, sl, ren);
+            drawn = render_id_scanlines(*ras_ptr, sl, ren) || drawn;
+            ras_ptr->reset();
         }
     }
-    pixmap_.add_feature(feature);
+    if (drawn)
+    {
+        pixmap_.add_feature(feature);
+    }
 }
 
 template void grid_renderer<grid>::process(building_symbolizer const&,
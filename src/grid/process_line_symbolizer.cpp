@@ -27,6 +27,7 @@
 #include <mapnik/grid/grid_pixfmt.hpp>
 #include <mapnik/grid/grid_pixel.hpp>
 #include <mapnik/grid/grid.hpp>
+#include <mapnik/clipped_path.hpp>
 
 // agg
 #include "agg_rasterizer_scanline_aa.h"
@@ -45,7 +46,9 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    typename T::value_type feature_id = pixmap_.pixel_id(feature);
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
+    typedef clipped_path<path_type> clipped_path_type;
     typedef agg::renderer_base<mapnik::pixfmt_gray16> ren_base;
     typedef agg::renderer_scanline_bin_solid<ren_base> renderer;
     agg::scanline_bin sl;
@@ -66,10 +69,13 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
         if (geom.num_points() > 1)
         {
             path_type path(t_,geom,prj_trans);
+            clipped_path_type clipped(path, clipped_path_type::polyline);
+            setup_clipped_line(clipped, sym, stroke_, width_, height_,
+                               scale_factor_, 4.0);
 
             if (stroke_.has_dash())
             {
-                agg::conv_dash<path_type> dash(path);
+                agg::conv_dash<clipped_path_type> dash(clipped);
                 dash_array const& d = stroke_.get_dash_array();
                 dash_array::const_iterator itr = d.begin();
                 dash_array::const_iterator end = d.end();
@@ -79,7 +85,7 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
                                   itr->second * scale_factor_);
                 }
 
-                agg::conv_stroke<agg::conv_dash<path_type > > stroke(dash);
+                agg::conv_stroke<agg::conv_dash<clipped_path_type> > stroke(dash);
 
                 line_join_e join=stroke_.get_line_join();
                 if ( join == MITER_JOIN)
@@ -107,7 +113,7 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
             }
             else
             {
-                agg::conv_stroke<path_type>  stroke(path);
+                agg::conv_stroke<clipped_path_type>  stroke(clipped);
                 line_join_e join=stroke_.get_line_join();
                 if ( join == MITER_JOIN)
                     stroke.generator().line_join(agg::miter_join);
@@ -134,11 +140,12 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
     }
 
     // render id
-    ren.color(mapnik::gray16(feature.id()));
-    agg::render_scanlines(*ras_ptr, sl, ren);
-
-    // add feature properties to grid cache
-    pixmap_.add_feature(feature);
+    ren.color(mapnik::gray16(feature_id));
+    if (render_id_scanlines(*ras_ptr, sl, ren))
+    {
+        // add feature properties to grid cache
+        pixmap_.add_feature(feature);
+    }
 
 }
 
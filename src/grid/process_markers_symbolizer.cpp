@@ -54,6 +54,7 @@ void grid_renderer<T>::process(markers_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    typename T::value_type feature_id = pixmap_.pixel_id(feature);
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
     typedef agg::renderer_base<mapnik::pixfmt_gray16> ren_base;
     typedef agg::renderer_scanline_bin_solid<ren_base> renderer;
@@ -120,7 +121,7 @@ void grid_renderer<T>::process(markers_symbolizer const& sym,
                 {
                     placed = true;
                     agg::trans_affine matrix = recenter * tr *agg::trans_affine_rotation(angle) * agg::trans_affine_translation(x, y);
-                    svg_renderer.render_id(*ras_ptr, sl, renb, feature.id(), matrix, sym.get_opacity(),bbox);
+                    svg_renderer.render_id(*ras_ptr, sl, renb, feature_id, matrix, sym.get_opacity(),bbox);
                 }
             }
             if (placed)
@@ -258,9 +259,11 @@ void grid_renderer<T>::process(markers_symbolizer const& sym,
             }
 
         }
-        ren.color(mapnik::gray16(feature.id()));
-        agg::render_scanlines(*ras_ptr, sl, ren);
-        pixmap_.add_feature(feature);
+        ren.color(mapnik::gray16(feature_id));
+        if (render_id_scanlines(*ras_ptr, sl, ren))
+        {
+            pixmap_.add_feature(feature);
+        }
     }
 }
 
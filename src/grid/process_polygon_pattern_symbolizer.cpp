@@ -44,6 +44,7 @@ void grid_renderer<T>::process(polygon_pattern_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    typename T::value_type feature_id = pixmap_.pixel_id(feature);
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
     typedef agg::renderer_base<mapnik::pixfmt_gray16> ren_base;
     typedef agg::renderer_scanline_bin_solid<ren_base> renderer;
@@ -68,11 +69,12 @@ void grid_renderer<T>::process(polygon_pattern_symbolizer const& sym,
     }
        
     // render id
-    ren.color(mapnik::gray16(feature.id()));
-    agg::render_scanlines(*ras_ptr, sl, ren);
-
-    // add feature properties to grid cache
-    pixmap_.add_feature(feature);
+    ren.color(mapnik::gray16(feature_id));
+    if (render_id_scanlines(*ras_ptr, sl, ren))
+    {
+        // add feature properties to grid cache
+        pixmap_.add_feature(feature);
+    }
 }
 
 
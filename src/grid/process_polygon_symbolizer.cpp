@@ -27,6 +27,7 @@
 #include <mapnik/grid/grid_pixfmt.hpp>
 #include <mapnik/grid/grid_pixel.hpp>
 #include <mapnik/grid/grid.hpp>
+#include <mapnik/clipped_path.hpp>
 
 // agg
 #include "agg_rasterizer_scanline_aa.h"
@@ -44,7 +45,9 @@ void grid_renderer<T>::process(polygon_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    typename T::value_type feature_id = pixmap_.pixel_id(feature);
     typedef coord_transform2<CoordTransform,geometry_type> path_type;
+    typedef clipped_path<path_type> clipped_path_type;
     typedef agg::renderer_base<mapnik::pixfmt_gray16> ren_base;
     typedef agg::renderer_scanline_bin_solid<ren_base> renderer;
     agg::scanline_bin sl;
@@ -62,16 +65,19 @@ void grid_renderer<T>::process(polygon_symbolizer const& sym,
         if (geom.num_points() > 2)
         {
             path_type path(t_,geom,prj_trans);
-            ras_ptr->add_path(path);
+            clipped_path_type clipped(path, clipped_path_type::polygon);
+            setup_clipped_path(clipped, sym, width_, height_, 1.0);
+            ras_ptr->add_path(clipped);
         }
     }
        
     // render id
-    ren.color(mapnik::gray16(feature.id()));
-    agg::render_scanlines(*ras_ptr, sl, ren);
-
-    // add feature properties to grid cache
-    pixmap_.add_feature(feature);
+    ren.color(mapnik::gray16(feature_id));
+    if (render_id_scanlines(*ras_ptr, sl, ren))
+    {
+        // add feature properties to grid cache
+        pixmap_.add_feature(feature);
+    }
 }
 
 
@@ -43,6 +43,7 @@ void  grid_renderer<T>::process(shield_symbolizer const& sym,
                                Feature const& feature,
                                proj_transform const& prj_trans)
 {
+    typename T::value_type feature_id = pixmap_.pixel_id(feature);
     typedef  coord_transform2<CoordTransform,geometry_type> path_type;
 
     bool placement_found = false;
@@ -196,7 +197,7 @@ void  grid_renderer<T>::process(shield_symbolizer const& sym,
                                     render_marker(feature,pixmap_.get_resolution(),px,py,**marker,tr,sym.get_opacity());
 
                                     box2d<double> dim = ren.prepare_glyphs(&text_placement.placements[0]);
-                                    ren.render_id(feature.id(),x,y,2);
+                                    ren.render_id(feature_id,x,y,2);
                                     detector_.insert(label_ext);
                                     finder.update_detector(text_placement);
                                 }
@@ -226,7 +227,7 @@ void  grid_renderer<T>::process(shield_symbolizer const& sym,
                             render_marker(feature,pixmap_.get_resolution(),px,py,**marker,tr,sym.get_opacity());
 
                             box2d<double> dim = ren.prepare_glyphs(&text_placement.placements[ii]);
-                            ren.render_id(feature.id(),x,y,2);
+                            ren.render_id(feature_id,x,y,2);
                         }
                         finder.update_detector(text_placement);
                     }
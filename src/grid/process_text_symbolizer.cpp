@@ -32,6 +32,7 @@ void grid_renderer<T>::process(text_symbolizer const& sym,
                               Feature const& feature,
                               proj_transform const& prj_trans)
 {
+    typename T::value_type feature_id = pixmap_.pixel_id(feature);
     typedef  coord_transform2<CoordTransform,geometry_type> path_type;
 
     bool placement_found = false;
@@ -139,7 +140,7 @@ void grid_renderer<T>::process(text_symbolizer const& sym,
                     double x = text_placement.placements[ii].starting_x;
                     double y = text_placement.placements[ii].starting_y;
                     ren.prepare_glyphs(&text_placement.placements[ii]);
-                    ren.render_id(feature.id(),x,y,2);
+                    ren.render_id(feature_id,x,y,2);
                 }
             }
         }
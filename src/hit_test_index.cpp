@@ -0,0 +1,192 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/hit_test_index.hpp>
+#include <mapnik/feature_layer_desc.hpp>
+#include <mapnik/geom_util.hpp>
+#include <mapnik/query.hpp>
+
+// stl
+#include <algorithm>
+#include <cmath>
+
+namespace mapnik {
+
+namespace {
+
+// same test as geometry::hit_test but only using get_vertex(pos,...),
+// which does not touch the geometry's iterator state
+bool hit_test(geometry_type const& geom, double x, double y, double tol)
+{
+    unsigned size = geom.num_points();
+    if (size == 1)
+    {
+        double x0, y0;
+        geom.get_vertex(0, &x0, &y0);
+        return distance(x, y, x0, y0) <= std::fabs(tol);
+    }
+    else if (size > 1)
+    {
+        bool inside = false;
+        double x0 = 0;
+        double y0 = 0;
+        geom.get_vertex(0, &x0, &y0);
+        for (unsigned pos = 1; pos < size; ++pos)
+        {
+            double x1, y1;
+            unsigned command = geom.get_vertex(pos, &x1, &y1);
+            if (command == SEG_MOVETO)
+            {
+                x0 = x1;
+                y0 = y1;
+                continue;
+            }
+            if ((((y1 <= y) && (y < y0)) ||
+                 ((y0 <= y) && (y < y1))) &&
+                ( x < (x0 - x1) * (y - y1)/ (y0 - y1) + x1))
+                inside = !inside;
+            x0 = x1;
+            y0 = y1;
+        }
+        return inside;
+    }
+    return false;
+}
+
+// deep copy, the indexed features stay private to the index
+feature_ptr copy_feature(Feature const& feature)
+{
+    feature_ptr copy(new Feature(feature.id()));
+    copy->props() = feature.props();
+    copy->set_raster(feature.get_raster());
+    for (unsigned i = 0; i < feature.num_geometries(); ++i)
+    {
+        geometry_type const& geom = feature.get_geometry(i);
+        geometry_type * geom_copy = new geometry_type(geom.type());
+        unsigned size = geom.num_points();
+        for (unsigned pos = 0; pos < size; ++pos)
+        {
+            double x, y;
+            unsigned command = geom.get_vertex(pos, &x, &y);
+            geom_copy->push_vertex(x, y, static_cast<CommandType>(command));
+        }
+        copy->add_geometry(geom_copy);
+    }
+    return copy;
+}
+
+}
+
+hit_test_index::hit_test_index(datasource_ptr const& ds)
+{
+    box2d<double> extent = ds->envelope();
+    mapnik::query q(extent);
+    std::vector<attribute_descriptor> const& desc = ds->get_descriptor().get_descriptors();
+    std::vector<attribute_descriptor>::const_iterator itr = desc.begin();
+    std::vector<attribute_descriptor>::const_iterator end = desc.end();
+    for (; itr != end; ++itr)
+    {
+        q.add_property_name(itr->get_name());
+    }
+
+    featureset_ptr fs = ds->features(q);
+    if (fs)
+    {
+        feature_ptr feature;
+        while ((feature = fs->next()))
+        {
+            if (feature->num_geometries() == 0) continue;
+            box2d<double> box = feature->envelope();
+            if (envelopes_.empty() && !extent.valid()) extent = box;
+            else extent.expand_to_include(box);
+            features_.push_back(feature);
+            envelopes_.push_back(box);
+        }
+    }
+
+    tree_.reset(new quad_tree<unsigned>(extent));
+    for (unsigned i = 0; i < envelopes_.size(); ++i)
+    {
+        tree_->insert(i, envelopes_[i]);
+    }
+}
+
+hit_test_index::~hit_test_index() {}
+
+void hit_test_index::query(double x, double y, double tol, std::vector<feature_ptr> & result) const
+{
+    double t = std::fabs(tol);
+    box2d<double> box(x - t, y - t, x + t, y + t);
+    std::vector<unsigned> candidates;
+    tree_->query_in_box(box, candidates);
+    // keep datasource order, as features_at_point would
+    std::sort(candidates.begin(), candidates.end());
+    std::vector<unsigned>::const_iterator itr = candidates.begin();
+    std::vector<unsigned>::const_iterator end = candidates.end();
+    for (; itr != end; ++itr)
+    {
+        if (!envelopes_[*itr].intersects(box)) continue;
+        feature_ptr const& feature = features_[*itr];
+        for (unsigned i = 0; i < feature->num_geometries(); ++i)
+        {
+            if (hit_test(feature->get_geometry(i), x, y, tol))
+            {
+                result.push_back(copy_feature(*feature));
+                break;
+            }
+        }
+    }
+}
+
+std::size_t hit_test_index::size() const
+{
+    return features_.size();
+}
+
+hit_test_index_cache::hit_test_index_cache() {}
+
+hit_test_index_cache::~hit_test_index_cache() {}
+
+hit_test_index_ptr hit_test_index_cache::get(datasource_ptr const& ds)
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+#endif
+    if (!index_ && ds && ds->type() == datasource::Vector)
+    {
+        index_.reset(new hit_test_index(ds));
+    }
+    return index_;
+}
+
+void hit_test_index_cache::reset()
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+#endif
+    index_.reset();
+}
+
+}
@@ -46,7 +46,8 @@ layer::layer(std::string const& name, std::string const& srs)
       queryable_(false),
       clear_label_cache_(false),
       cache_features_(false),
-      ds_() {}
+      ds_(),
+      hit_index_(new hit_test_index_cache) {}
     
 layer::layer(const layer& rhs)
     : name_(rhs.name_),
@@ -60,7 +61,8 @@ layer::layer(const layer& rhs)
       clear_label_cache_(rhs.clear_label_cache_),
       cache_features_(rhs.cache_features_),
       styles_(rhs.styles_),
-      ds_(rhs.ds_) {}
+      ds_(rhs.ds_),
+      hit_index_(rhs.hit_index_) {}
     
 layer& layer::operator=(const layer& rhs)
 {
@@ -88,6 +90,7 @@ void layer::swap(const layer& rhs)
     cache_features_ = rhs.cache_features_;
     styles_=rhs.styles_;
     ds_=rhs.ds_;
+    hit_index_=rhs.hit_index_;
 }
 
 layer::~layer() {}
@@ -200,6 +203,8 @@ datasource_ptr layer::datasource() const
 void layer::set_datasource(datasource_ptr const& ds)
 {
     ds_ = ds;
+    // copies sharing the old index keep the old datasource
+    hit_index_.reset(new hit_test_index_cache);
 }
     
 box2d<double> layer::envelope() const
@@ -208,6 +213,16 @@ box2d<double> layer::envelope() const
     return box2d<double>();
 }
     
+hit_test_index_ptr layer::hit_index() const
+{
+    return hit_index_->get(ds_);
+}
+
+void layer::reset_hit_index()
+{
+    hit_index_->reset();
+}
+
 void layer::set_clear_label_cache(bool clear)
 {
     clear_label_cache_ = clear;
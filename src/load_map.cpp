@@ -90,6 +90,7 @@ private:
     void parse_layer(Map & map, ptree const & lay);
     void parse_metawriter(Map & map, ptree const & lay);
     void parse_metawriter_in_symbolizer(symbolizer_base &sym, ptree const &pt);
+    void parse_clipping_in_symbolizer(symbolizer_base &sym, ptree const &pt);
 
     void parse_fontset(Map & map, ptree const & fset);
     void parse_font(font_set & fset, ptree const & f);
@@ -837,6 +838,14 @@ void map_parser::parse_metawriter_in_symbolizer(symbolizer_base &sym, ptree cons
     sym.add_metawriter(*writer, output);
 }
 
+void map_parser::parse_clipping_in_symbolizer(symbolizer_base &sym, ptree const &pt)
+{
+    optional<boolean> clip = get_opt_attr<boolean>(pt, "clip");
+    if (clip) sym.set_clip(*clip);
+    optional<double> tolerance = get_opt_attr<double>(pt, "simplify-tolerance");
+    if (tolerance) sym.set_simplify_tolerance(*tolerance);
+}
+
 void map_parser::parse_point_symbolizer( rule & rule, ptree const & sym )
 {
     try
@@ -1769,7 +1778,7 @@ void map_parser::parse_line_symbolizer( rule & rule, ptree const & sym )
     std::stringstream s;
     s << "stroke,stroke-width,stroke-opacity,stroke-linejoin,"
       << "stroke-linecap,stroke-gamma,stroke-dash-offset,stroke-dasharray,"
-      << "meta-writer,meta-output";
+      << "clip,simplify-tolerance,meta-writer,meta-output";
 
     ensure_attrs(sym, "LineSymbolizer", s.str());
     try
@@ -1778,6 +1787,7 @@ void map_parser::parse_line_symbolizer( rule & rule, ptree const & sym )
         parse_stroke(strk,sym);
         line_symbolizer symbol = line_symbolizer(strk);
 
+        parse_clipping_in_symbolizer(symbol, sym);
         parse_metawriter_in_symbolizer(symbol, sym);
         rule.append(symbol);
     }
@@ -1791,7 +1801,7 @@ void map_parser::parse_line_symbolizer( rule & rule, ptree const & sym )
     
 void map_parser::parse_polygon_symbolizer( rule & rule, ptree const & sym )
 {
-    ensure_attrs(sym, "PolygonSymbolizer", "fill,fill-opacity,gamma,meta-writer,meta-output");
+    ensure_attrs(sym, "PolygonSymbolizer", "fill,fill-opacity,gamma,clip,simplify-tolerance,meta-writer,meta-output");
     try
     {
         polygon_symbolizer poly_sym;
@@ -1805,6 +1815,7 @@ void map_parser::parse_polygon_symbolizer( rule & rule, ptree const & sym )
         optional<double> gamma = get_opt_attr<double>(sym, "gamma");
         if (gamma)  poly_sym.set_gamma(*gamma);
 
+        parse_clipping_in_symbolizer(poly_sym, sym);
         parse_metawriter_in_symbolizer(poly_sym, sym);
         rule.append(poly_sym);
     }
@@ -630,6 +630,65 @@ featureset_ptr Map::query_map_point(unsigned index, double x, double y) const
     return featureset_ptr();
 }
 
+void Map::query_points(unsigned index, std::vector<coord2d> const& points,
+                       std::vector<std::vector<feature_ptr> > & result) const
+{
+    query_points_impl(index, points, result, false);
+}
+
+void Map::query_map_points(unsigned index, std::vector<coord2d> const& points,
+                           std::vector<std::vector<feature_ptr> > & result) const
+{
+    query_points_impl(index, points, result, true);
+}
+
+void Map::query_points_impl(unsigned index, std::vector<coord2d> const& points,
+                            std::vector<std::vector<feature_ptr> > & result,
+                            bool pixel_coords) const
+{
+    result.clear();
+    result.resize(points.size());
+    if ( index< layers_.size())
+    {
+        mapnik::layer const& layer = layers_[index];
+        try
+        {
+            hit_test_index_ptr index_ptr = layer.hit_index();
+            if (!index_ptr) return;
+
+            mapnik::projection dest(srs_);
+            mapnik::projection source(layer.srs());
+            proj_transform prj_trans(source,dest);
+            double z = 0;
+
+            double minx = current_extent_.minx();
+            double miny = current_extent_.miny();
+            double maxx = current_extent_.maxx();
+            double maxy = current_extent_.maxy();
+
+            prj_trans.backward(minx,miny,z);
+            prj_trans.backward(maxx,maxy,z);
+            double tol = (maxx - minx) / width_ * 3;
+            CoordTransform tr = view_transform();
+
+            for (std::size_t i = 0; i < points.size(); ++i)
+            {
+                double x = points[i].x;
+                double y = points[i].y;
+                if (pixel_coords) tr.backward(&x,&y);
+                prj_trans.backward(x,y,z);
+                index_ptr->query(x,y,tol,result[i]);
+            }
+        }
+        catch (...)
+        {
+#ifdef MAPNIK_DEBUG
+            std::clog << "exception caught in \"query_points\"\n";
+#endif
+        }
+    }
+}
+
 Map::~Map() {}
 
 void Map::init_metawriters()
@@ -30,40 +30,199 @@
 #include <mapnik/svg/svg_converter.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_reader.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/parse_path.hpp>
 
 // boost
 #include <boost/assert.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
+
+// stl
+#include <list>
+#include <set>
 
 namespace mapnik 
 {
 
-boost::unordered_map<std::string, marker_ptr> marker_cache::cache_;
+namespace {
 
-bool marker_cache::insert (std::string const& uri, marker_ptr path)
+struct cache_entry
 {
+    marker_ptr mark;
+    std::size_t bytes;
+    // added with insert(), not part of the lru list
+    bool pinned;
+    std::list<std::string>::iterator position;
+};
+
+// the byte budget is shared by all shards, so one large marker
+// never exceeds a per shard slice of it
+struct cache_budget
+{
+    cache_budget()
+        : max_bytes(0),
+          lru_bytes(0),
+          next_shard(0) {}
+
+    bool over()
+    {
 #ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(mutex_);
+        boost::mutex::scoped_lock lock(mutex);
 #endif
-    return cache_.insert(std::make_pair(uri,path)).second;
-}
+        return max_bytes > 0 && lru_bytes > max_bytes;
+    }
 
-boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool update_cache)
+    void add(std::size_t bytes)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex);
+#endif
+        lru_bytes += bytes;
+    }
+
+    void remove(std::size_t bytes)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex);
+#endif
+        lru_bytes -= bytes;
+    }
+
+    // round robin over the shards when evicting
+    unsigned shard_to_evict(unsigned num_shards)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex);
+#endif
+        unsigned index = next_shard;
+        next_shard = (next_shard + 1) % num_shards;
+        return index;
+    }
+
+    // never taken before a shard lock, only after
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex mutex;
+#endif
+    std::size_t max_bytes;
+    std::size_t lru_bytes;
+    unsigned next_shard;
+};
+
+cache_budget budget;
+
+struct cache_shard
 {
+    // drops the least recently used marker other than keep,
+    // returns false if there is none
+    bool evict_one(std::string const& keep)
+    {
+        std::list<std::string>::reverse_iterator last = lru.rbegin();
+        if (last != lru.rend() && *last == keep) ++last;
+        if (last == lru.rend()) return false;
+        std::list<std::string>::iterator pos = --last.base();
+        entry_map::iterator itr = entries.find(*pos);
+        budget.remove(itr->second.bytes);
+        stats.bytes -= itr->second.bytes;
+        --stats.entries;
+        ++stats.evictions;
+        entries.erase(itr);
+        lru.erase(pos);
+        return true;
+    }
+
+    typedef boost::unordered_map<std::string, cache_entry> entry_map;
 #ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(mutex_);
+    boost::mutex mutex;
 #endif
-    typedef boost::unordered_map<std::string, marker_ptr>::const_iterator iterator_type;
-    boost::optional<marker_ptr> result;
-    iterator_type itr = cache_.find(uri);
-    if (itr != cache_.end())
+    entry_map entries;
+    // most recently used first
+    std::list<std::string> lru;
+    marker_cache_stats stats;
+};
+
+const unsigned num_shards = 16;
+cache_shard shards[num_shards];
+
+// evicts markers, each shard its least recently used first, until the
+// cache fits its budget again. keep, the marker just added, always stays
+// so a marker larger than the whole budget is still read only once.
+void evict(std::string const& keep)
+{
+    unsigned idle = 0;
+    while (idle < num_shards && budget.over())
     {
-        result.reset(itr->second);
-        return result;
+        cache_shard & shard = shards[budget.shard_to_evict(num_shards)];
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(shard.mutex);
+#endif
+        idle = shard.evict_one(keep) ? 0 : idle + 1;
     }
+}
 
-    // we can't find marker in cache, lets try to load it from filesystem
+cache_shard & shard_for(std::string const& uri)
+{
+    return shards[boost::hash<std::string>()(uri) % num_shards];
+}
+
+std::size_t marker_bytes(marker_ptr const& mark)
+{
+    std::size_t bytes = sizeof(marker);
+    if (mark->is_bitmap())
+    {
+        image_ptr image = *mark->get_bitmap_data();
+        bytes += image->width() * image->height() * sizeof(image_data_32::pixel_type);
+    }
+    else if (mark->is_vector())
+    {
+        path_ptr path = *mark->get_vector_data();
+        bytes += path->source().size() * sizeof(svg_path_storage::value_type);
+        bytes += path->attributes().size() * sizeof(path_attributes);
+    }
+    return bytes;
+}
+
+// adds mark unless uri is already there, returns the cached marker
+// and whether it is mark
+std::pair<marker_ptr,bool> add_entry(std::string const& uri, marker_ptr const& mark, bool pinned)
+{
+    {
+        cache_shard & shard = shard_for(uri);
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(shard.mutex);
+#endif
+        cache_shard::entry_map::iterator itr = shard.entries.find(uri);
+        if (itr != shard.entries.end()) return std::make_pair(itr->second.mark, false);
+
+        cache_entry entry;
+        entry.mark = mark;
+        entry.bytes = marker_bytes(mark);
+        entry.pinned = pinned;
+        entry.position = shard.lru.end();
+        if (!pinned)
+        {
+            shard.lru.push_front(uri);
+            entry.position = shard.lru.begin();
+            budget.add(entry.bytes);
+        }
+        shard.entries.insert(std::make_pair(uri, entry));
+        shard.stats.bytes += entry.bytes;
+        ++shard.stats.entries;
+    }
+    // outside of the shard lock, eviction locks the shards one by one
+    if (!pinned) evict(uri);
+    return std::make_pair(mark, true);
+}
+
+boost::optional<marker_ptr> load_marker(std::string const& uri)
+{
+    boost::optional<marker_ptr> result;
     boost::filesystem::path path(uri);
     if (exists(path))
     {
@@ -86,11 +245,6 @@ boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool upda
 
                 marker_ptr mark(new marker(marker_path));
                 result.reset(mark);
-                if (update_cache)
-                {
-                    cache_.insert(std::make_pair(uri,*result));
-                }
-                return result;
             }
             catch (...)
             {
@@ -111,10 +265,6 @@ boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool upda
                     reader->read(0,0,*image);
                     marker_ptr mark(new marker(image));
                     result.reset(mark);
-                    if (update_cache)
-                    {
-                        cache_.insert(std::make_pair(uri,*result));
-                    }
                 }
             }
 
@@ -131,8 +281,158 @@ boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool upda
     return result;
 }
 
+// collects the constant file names of symbolizers with an image
+struct marker_uri_collector : public boost::static_visitor<>
+{
+    explicit marker_uri_collector(std::set<std::string> & uris)
+        : uris_(uris) {}
+
+    template <typename Symbolizer>
+    void operator() (Symbolizer const& sym) const
+    {
+        collect(sym, boost::is_base_of<symbolizer_with_image, Symbolizer>());
+    }
+
+private:
+    template <typename Symbolizer>
+    void collect(Symbolizer const& /*sym*/, boost::false_type) const {}
+
+    void collect(symbolizer_with_image const& sym, boost::true_type) const
+    {
+        path_expression_ptr filename = sym.get_filename();
+        if (!filename) return;
+        std::set<std::string> attributes;
+        path_processor_type::collect_attributes(*filename, attributes);
+        if (!attributes.empty()) return;
+        std::string uri = path_processor_type::to_string(*filename);
+        if (!uri.empty()) uris_.insert(uri);
+    }
+
+    std::set<std::string> & uris_;
+};
+
+}
+
+bool marker_cache::insert (std::string const& uri, marker_ptr path)
+{
+    return add_entry(uri, path, true).second;
+}
+
+boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool update_cache)
+{
+    boost::optional<marker_ptr> result;
+    {
+        cache_shard & shard = shard_for(uri);
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(shard.mutex);
+#endif
+        cache_shard::entry_map::const_iterator itr = shard.entries.find(uri);
+        if (itr != shard.entries.end())
+        {
+            if (!itr->second.pinned)
+            {
+                shard.lru.splice(shard.lru.begin(), shard.lru, itr->second.position);
+            }
+            ++shard.stats.hits;
+            result.reset(itr->second.mark);
+            return result;
+        }
+        ++shard.stats.misses;
+    }
+
+    // we can't find marker in cache, lets try to load it from filesystem
+    // (without the lock, another thread may be loading it too)
+    result = load_marker(uri);
+    if (result && update_cache)
+    {
+        result.reset(add_entry(uri, *result, false).first);
+    }
+    return result;
+}
+
+void marker_cache::set_max_bytes(std::size_t max_bytes)
+{
+    {
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(budget.mutex);
+#endif
+        budget.max_bytes = max_bytes;
+    }
+    evict(std::string());
+}
+
+std::size_t marker_cache::max_bytes()
+{
+#ifdef MAPNIK_THREADSAFE
+    mutex::scoped_lock lock(budget.mutex);
+#endif
+    return budget.max_bytes;
+}
+
+marker_cache_stats marker_cache::stats()
+{
+    marker_cache_stats result;
+    for (unsigned i = 0; i < num_shards; ++i)
+    {
+        cache_shard & shard = shards[i];
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(shard.mutex);
+#endif
+        result.hits += shard.stats.hits;
+        result.misses += shard.stats.misses;
+        result.evictions += shard.stats.evictions;
+        result.entries += shard.stats.entries;
+        result.bytes += shard.stats.bytes;
+    }
+    return result;
+}
+
+void marker_cache::clear()
+{
+    for (unsigned i = 0; i < num_shards; ++i)
+    {
+        cache_shard & shard = shards[i];
 #ifdef MAPNIK_THREADSAFE
-boost::mutex marker_cache::mutex_;
+        mutex::scoped_lock lock(shard.mutex);
 #endif
+        // markers added with insert() can not be reloaded, keep them
+        BOOST_FOREACH(std::string const& uri, shard.lru)
+        {
+            cache_shard::entry_map::iterator itr = shard.entries.find(uri);
+            budget.remove(itr->second.bytes);
+            shard.stats.bytes -= itr->second.bytes;
+            --shard.stats.entries;
+            shard.entries.erase(itr);
+        }
+        shard.lru.clear();
+        shard.stats.hits = 0;
+        shard.stats.misses = 0;
+        shard.stats.evictions = 0;
+    }
+}
+
+unsigned marker_cache::preload(Map const& map)
+{
+    std::set<std::string> uris;
+    marker_uri_collector collector(uris);
+    Map::const_style_iterator style_itr = map.begin_styles();
+    for (; style_itr != map.end_styles(); ++style_itr)
+    {
+        BOOST_FOREACH(rule const& r, style_itr->second.get_rules())
+        {
+            BOOST_FOREACH(symbolizer const& sym, r.get_symbolizers())
+            {
+                boost::apply_visitor(collector, sym);
+            }
+        }
+    }
+
+    unsigned count = 0;
+    BOOST_FOREACH(std::string const& uri, uris)
+    {
+        if (find(uri, true)) ++count;
+    }
+    return count;
+}
 
 }
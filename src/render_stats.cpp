@@ -0,0 +1,222 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/render_stats.hpp>
+// boost
+#include <boost/variant.hpp>
+// stl
+#include <sys/time.h>
+
+namespace mapnik
+{
+
+namespace {
+
+struct symbolizer_type_name : public boost::static_visitor<std::string const&>
+{
+    std::string const& operator() (point_symbolizer const&) const
+    {
+        static const std::string name("point");
+        return name;
+    }
+
+    std::string const& operator() (line_symbolizer const&) const
+    {
+        static const std::string name("line");
+        return name;
+    }
+
+    std::string const& operator() (line_pattern_symbolizer const&) const
+    {
+        static const std::string name("line_pattern");
+        return name;
+    }
+
+    std::string const& operator() (polygon_symbolizer const&) const
+    {
+        static const std::string name("polygon");
+        return name;
+    }
+
+    std::string const& operator() (polygon_pattern_symbolizer const&) const
+    {
+        static const std::string name("polygon_pattern");
+        return name;
+    }
+
+    std::string const& operator() (raster_symbolizer const&) const
+    {
+        static const std::string name("raster");
+        return name;
+    }
+
+    std::string const& operator() (shield_symbolizer const&) const
+    {
+        static const std::string name("shield");
+        return name;
+    }
+
+    std::string const& operator() (text_symbolizer const&) const
+    {
+        static const std::string name("text");
+        return name;
+    }
+
+    std::string const& operator() (building_symbolizer const&) const
+    {
+        static const std::string name("building");
+        return name;
+    }
+
+    std::string const& operator() (markers_symbolizer const&) const
+    {
+        static const std::string name("markers");
+        return name;
+    }
+
+    std::string const& operator() (glyph_symbolizer const&) const
+    {
+        static const std::string name("glyph");
+        return name;
+    }
+};
+
+}
+
+void render_stats::counters::add(counters const& other)
+{
+    query_time += other.query_time;
+    features_fetched += other.features_fetched;
+    features_matched += other.features_matched;
+    label_attempts += other.label_attempts;
+    label_successes += other.label_successes;
+    bytes_decoded += other.bytes_decoded;
+    symbolizer_map::const_iterator itr = other.symbolizers.begin();
+    for (; itr != other.symbolizers.end(); ++itr)
+    {
+        symbolizer_stats & s = symbolizers[itr->first];
+        s.count += itr->second.count;
+        s.time += itr->second.time;
+    }
+}
+
+render_stats::render_stats()
+    : time_(0.0),
+      map_start_(0.0),
+      layer_start_(0.0),
+      style_start_(0.0),
+      in_style_(false) {}
+
+void render_stats::clear()
+{
+    layers_.clear();
+    current_ = counters();
+    by_type_.clear();
+    time_ = 0.0;
+    in_style_ = false;
+}
+
+std::vector<render_stats::layer_stats> const& render_stats::layers() const
+{
+    return layers_;
+}
+
+double render_stats::time() const
+{
+    return time_;
+}
+
+double render_stats::now()
+{
+    timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec * 1000.0 + t.tv_usec / 1000.0;
+}
+
+std::string const& render_stats::symbolizer_name(symbolizer const& sym)
+{
+    return boost::apply_visitor(symbolizer_type_name(), sym);
+}
+
+void render_stats::start_map()
+{
+    map_start_ = now();
+}
+
+void render_stats::end_map()
+{
+    time_ += now() - map_start_;
+}
+
+void render_stats::start_layer(std::string const& name)
+{
+    layers_.push_back(layer_stats());
+    layers_.back().name = name;
+    layers_.back().time = 0.0;
+    layer_start_ = now();
+}
+
+void render_stats::end_layer()
+{
+    if (layers_.empty()) return;
+    end_style();
+    layers_.back().time = now() - layer_start_;
+}
+
+void render_stats::start_style(std::string const& name)
+{
+    end_style();
+    current_ = counters();
+    by_type_.clear();
+    style_name_ = name;
+    style_start_ = now();
+    in_style_ = true;
+}
+
+void render_stats::end_style()
+{
+    if (!in_style_ || layers_.empty()) return;
+    in_style_ = false;
+
+    for (unsigned type = 0; type < by_type_.size(); ++type)
+    {
+        symbolizer_timing const& t = by_type_[type];
+        if (!t.name) continue;
+        symbolizer_stats & s = current_.symbolizers[*t.name];
+        s.count += t.stats.count;
+        s.time += t.stats.time;
+    }
+
+    style_stats style;
+    static_cast<counters&>(style) = current_;
+    style.name = style_name_;
+    style.time = now() - style_start_;
+
+    layer_stats & layer = layers_.back();
+    layer.add(current_);
+    layer.styles.push_back(style);
+}
+
+}
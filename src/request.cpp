@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+// mapnik
+#include <mapnik/request.hpp>
+#include <mapnik/map.hpp>
+
+namespace mapnik
+{
+
+request::request(unsigned width, unsigned height, box2d<double> const& extent)
+    : width_(width),
+      height_(height),
+      extent_(extent),
+      buffer_size_(0) {}
+
+request::request(Map const& m)
+    : width_(m.width()),
+      height_(m.height()),
+      extent_(m.get_current_extent()),
+      buffer_size_(m.buffer_size()) {}
+
+unsigned request::width() const
+{
+    return width_;
+}
+
+unsigned request::height() const
+{
+    return height_;
+}
+
+void request::set_extent(box2d<double> const& box)
+{
+    extent_ = box;
+}
+
+box2d<double> const& request::extent() const
+{
+    return extent_;
+}
+
+void request::zoom_to_box(box2d<double> const& box)
+{
+    extent_ = box;
+    if (width_ == 0 || height_ == 0 || box.width() <= 0 || box.height() <= 0) return;
+    // like GROW_BBOX, the default aspect_fix_mode of Map
+    double ratio1 = double(width_) / double(height_);
+    double ratio2 = extent_.width() / extent_.height();
+    if (ratio2 > ratio1)
+        extent_.height(extent_.width() / ratio1);
+    else if (ratio2 < ratio1)
+        extent_.width(extent_.height() * ratio1);
+}
+
+void request::set_buffer_size(int buffer_size)
+{
+    buffer_size_ = buffer_size;
+}
+
+int request::buffer_size() const
+{
+    return buffer_size_;
+}
+
+box2d<double> request::get_buffered_extent() const
+{
+    double extra = 2.0 * scale() * buffer_size_;
+    box2d<double> ext(extent_);
+    ext.width(extent_.width() + extra);
+    ext.height(extent_.height() + extra);
+    return ext;
+}
+
+double request::scale() const
+{
+    if (width_ > 0)
+        return extent_.width() / width_;
+    return extent_.width();
+}
+
+}
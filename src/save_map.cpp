@@ -81,6 +81,7 @@ public:
 
         const stroke & strk =  sym.get_stroke();
         add_stroke_attributes(sym_node, strk);
+        add_clipping_attributes(sym_node, sym);
         add_metawriter_attributes(sym_node, sym);
     }
         
@@ -112,6 +113,7 @@ public:
         {
             set_attr( sym_node, "gamma", sym.get_gamma() );
         }
+        add_clipping_attributes(sym_node, sym);
         add_metawriter_attributes(sym_node, sym);
     }
 
@@ -600,6 +602,17 @@ private:
         }
                 
     }
+    void add_clipping_attributes(ptree &node, symbolizer_base const& sym)
+    {
+        symbolizer_base dfl;
+        if (sym.get_clip() != dfl.get_clip() || explicit_defaults_) {
+            set_attr(node, "clip", sym.get_clip());
+        }
+        if (sym.get_simplify_tolerance() != dfl.get_simplify_tolerance() || explicit_defaults_) {
+            set_attr(node, "simplify-tolerance", sym.get_simplify_tolerance());
+        }
+    }
+
     void add_metawriter_attributes(ptree &node, symbolizer_base const& sym)
     {
         if (!sym.get_metawriter_name().empty() || explicit_defaults_) {
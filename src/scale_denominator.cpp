@@ -34,7 +34,12 @@ static const double meters_per_degree = 6378137 * 2 * pi/ 360;
     
 double scale_denominator(Map const& map, bool geographic)
 {
-    double denom = map.scale() / 0.00028;
+    return scale_denominator(map.scale(), geographic);
+}
+
+double scale_denominator(double map_scale, bool geographic)
+{
+    double denom = map_scale / 0.00028;
     if (geographic) denom *= meters_per_degree;
     return denom; 
 }
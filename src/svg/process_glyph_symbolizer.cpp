@@ -37,4 +37,7 @@ namespace mapnik
     template void svg_renderer<std::ostream_iterator<char> >::process(glyph_symbolizer const& sym,
                       Feature const& feature,
                       proj_transform const& prj_trans);
+    template void svg_renderer<std::back_insert_iterator<std::string> >::process(glyph_symbolizer const& sym,
+                      Feature const& feature,
+                      proj_transform const& prj_trans);
 }
@@ -64,5 +64,8 @@ bool svg_renderer<OutputIterator>::process(rule::symbolizers const& syms,
 template bool svg_renderer<std::ostream_iterator<char> >::process(rule::symbolizers const& syms,
                                                                   Feature const& feature,
                                                                   proj_transform const& prj_trans);
+template bool svg_renderer<std::back_insert_iterator<std::string> >::process(rule::symbolizers const& syms,
+                                                                             Feature const& feature,
+                                                                             proj_transform const& prj_trans);
 
 }
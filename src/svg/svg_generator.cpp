@@ -27,13 +27,20 @@
 // boost
 #include <boost/spirit/include/karma.hpp>
 
+// stl
+#include <iterator>
+#include <string>
+
 namespace mapnik { namespace svg {
 
     using namespace boost::spirit;
 
     template <typename OutputIterator>
     svg_generator<OutputIterator>::svg_generator(OutputIterator& output_iterator) 
-      : output_iterator_(output_iterator) {}
+      : output_iterator_(output_iterator),
+        coordinate_precision_(3),
+        data_grammar_(&coordinate_precision_),
+        path_open_(false) {}
 
     template <typename OutputIterator>
     svg_generator<OutputIterator>::~svg_generator() {}
@@ -55,12 +62,14 @@ namespace mapnik { namespace svg {
     template <typename OutputIterator>
     void svg_generator<OutputIterator>::generate_closing_root()
     {
+        flush();
         karma::generate(output_iterator_, lit("</svg>"));
     }
 
     template <typename OutputIterator>
     void svg_generator<OutputIterator>::generate_rect(rect_output_attributes const& rect_attributes)
     {
+        flush();
         rect_attributes_grammar attributes_grammar;
         karma::generate(output_iterator_, lit("<rect ") << attributes_grammar << lit("/>\n"), rect_attributes);
     }
@@ -68,14 +77,45 @@ namespace mapnik { namespace svg {
     template <typename OutputIterator>
     void svg_generator<OutputIterator>::generate_path(path_type const& path, path_output_attributes const& path_attributes) 
     {  
-        path_data_grammar data_grammar(path);
-        path_attributes_grammar attributes_grammar;
-        path_dash_array_grammar dash_array_grammar;
-      
-        karma::generate(output_iterator_, lit("<path ")  << data_grammar, path);
-        karma::generate(output_iterator_, lit(" ") << dash_array_grammar, path_attributes.stroke_dasharray());
-        karma::generate(output_iterator_, lit(" ") << attributes_grammar << lit("/>\n"), path_attributes);
+        // merging filled paths could punch holes where their windings
+        // disagree, so only outlines are coalesced. Translucent outlines
+        // stay separate: within one <path> overlaps would not composite
+        // twice as they do in the agg and cairo output.
+        if (path_open_ && path_attributes.fill_color_ == "none"
+            && path_attributes.stroke_opacity_ >= 1.0
+            && path_attributes == open_path_attributes_)
+        {
+            karma::generate(output_iterator_, lit(' ') << data_grammar_, path);
+            return;
+        }
+
+        flush();
+        karma::generate(output_iterator_, lit("<path d=\"") << data_grammar_, path);
+        open_path_attributes_ = path_attributes;
+        path_open_ = true;
+    }
+
+    template <typename OutputIterator>
+    void svg_generator<OutputIterator>::flush()
+    {
+        if (!path_open_) return;
+        path_open_ = false;
+        karma::generate(output_iterator_, lit("\" ") << dash_array_grammar_, open_path_attributes_.stroke_dasharray_);
+        karma::generate(output_iterator_, lit(' ') << attributes_grammar_ << lit("/>\n"), open_path_attributes_);
+    }
+
+    template <typename OutputIterator>
+    void svg_generator<OutputIterator>::set_coordinate_precision(unsigned precision)
+    {
+        coordinate_precision_ = precision;
+    }
+
+    template <typename OutputIterator>
+    unsigned svg_generator<OutputIterator>::coordinate_precision() const
+    {
+        return coordinate_precision_;
     }
 
     template class svg_generator<std::ostream_iterator<char> >;
+    template class svg_generator<std::back_insert_iterator<std::string> >;
 }}
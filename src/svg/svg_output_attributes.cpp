@@ -149,6 +149,19 @@ namespace mapnik { namespace svg {
         return stroke_dashoffset_;
     }
 
+    bool path_output_attributes::operator==(path_output_attributes const& other) const
+    {
+        return fill_color_ == other.fill_color_
+            && fill_opacity_ == other.fill_opacity_
+            && stroke_color_ == other.stroke_color_
+            && stroke_opacity_ == other.stroke_opacity_
+            && stroke_width_ == other.stroke_width_
+            && stroke_linecap_ == other.stroke_linecap_
+            && stroke_linejoin_ == other.stroke_linejoin_
+            && stroke_dasharray_ == other.stroke_dasharray_
+            && stroke_dashoffset_ == other.stroke_dashoffset_;
+    }
+
     void path_output_attributes::reset()
     {
         fill_color_ = "none";
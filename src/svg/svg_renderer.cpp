@@ -29,6 +29,8 @@
 #include <iostream>
 #endif
 #include <ostream>
+#include <iterator>
+#include <string>
 
 namespace mapnik
 {
@@ -92,10 +94,14 @@ namespace mapnik
     template <typename T>
     void svg_renderer<T>::end_layer_processing(layer const& lay)
     {
+        // paths are never coalesced across layers.
+        generator_.flush();
+
         #ifdef MAPNIK_DEBUG
         std::clog << "end layer processing: " << lay.name() << std::endl;
         #endif
     }
 
     template class svg_renderer<std::ostream_iterator<char> >;
+    template class svg_renderer<std::back_insert_iterator<std::string> >;
 }
@@ -59,6 +59,25 @@ def test_feature_attributes():
     eq_(lyr.datasource.fields(),['AREA', 'EAS_ID', 'PRFEDEA'])
     eq_(lyr.datasource.field_types(),[float,int,str])
 
+def test_feature_columns():
+    ds = mapnik2.Shapefile(file='../data/shp/poly.shp')
+    features = ds.all_features()
+    cols = ds.columns()
+    eq_(list(cols['ids']), [f.id() for f in features])
+    eq_(len(cols['feature_offsets']), len(features) + 1)
+    eq_(cols['ring_offsets'][-1] * 2, len(cols['coords']))
+    eq_(list(cols['attributes']['EAS_ID']), [f['EAS_ID'] for f in features])
+    eq_(cols['attributes']['PRFEDEA'][0], u'35043411')
+    eq_(cols['attributes']['AREA'].typecode, 'd')
+
+def test_ogr_query_property_names():
+    ds = mapnik2.Ogr(file='../data/shp/poly.shp',layer_by_index=0)
+    query = mapnik2.Query(ds.envelope())
+    query.add_property_name('EAS_ID')
+    features = ds.features(query).features
+    eq_(len(features), 10)
+    eq_(features[0].attributes, {'EAS_ID': 168})
+
 def test_hit_grid():
     import os
     from itertools import groupby
@@ -85,5 +104,25 @@ def test_hit_grid():
     eq_(hit_list[:16],'730:|2:Greenland')
     eq_(hit_list[-12:],'1:Chile|812:')
 
+def test_batched_hit_grid():
+    m = mapnik2.Map(256,256);
+    mapnik2.load_map(m,'../data/good_maps/agg_poly_gamma_map.xml');
+    m.zoom_all()
+    join_field = 'NAME'
+    points = [(x,y) for y in range(0, 256, 4) for x in range(0, 256, 4)]
+    results = m.query_map_points(0,points)
+    eq_(len(results),len(points))
+    for (x,y),features in zip(points[::37],results[::37]):
+        expected = [f[join_field] for f in m.query_map_point(0,x,y).features]
+        eq_([f[join_field] for f in features],expected)
+    # results are copies, changing them leaves the index alone
+    i = [len(features) > 0 for features in results].index(True)
+    name = results[i][0][join_field]
+    results[i][0][join_field] = 'changed'
+    eq_(m.query_map_points(0,[points[i]])[0][0][join_field],name)
+    m.layers[0].reset_hit_index()
+    eq_(len(m.query_map_points(0,points)),len(points))
+
 if __name__ == '__main__':
-    test_hit_grid()
\ No newline at end of file
+    test_hit_grid()
+    test_batched_hit_grid()
\ No newline at end of file
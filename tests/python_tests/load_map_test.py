@@ -3,7 +3,7 @@
 from nose.tools import *
 from utilities import execution_path
 
-import os, sys, glob, mapnik2
+import os, sys, glob, tempfile, mapnik2
 
 def setup():
     # All of the paths used are relative, if we run the tests
@@ -48,3 +48,37 @@ def test_good_files():
 
     for file in good_files:
         yield assert_loads_successfully, file
+
+def assert_compiled_map_matches(file):
+    m = mapnik2.Map(512, 512)
+    mapnik2.load_map(m, file, True)
+    expected = mapnik2.save_map_to_string(m)
+
+    (handle, cache) = tempfile.mkstemp(suffix='.mapc', prefix='mapnik-compiled-')
+    os.close(handle)
+    os.remove(cache)
+    try:
+        # first call parses the xml and writes the cache
+        m = mapnik2.Map(512, 512)
+        mapnik2.load_map_cached(m, file, cache, True)
+        eq_(os.path.exists(cache), True)
+        eq_(mapnik2.save_map_to_string(m), expected)
+
+        # second call restores the compiled map
+        m = mapnik2.Map(512, 512)
+        eq_(mapnik2.load_compiled_map(m, cache, file), True)
+        eq_(mapnik2.save_map_to_string(m), expected)
+
+        # a compiled map for another source is stale
+        m = mapnik2.Map(512, 512)
+        eq_(mapnik2.load_compiled_map(m, cache, os.path.abspath(__file__)), False)
+        eq_(len(m.layers), 0)
+    finally:
+        if os.path.exists(cache):
+            os.remove(cache)
+
+def test_compiled_maps():
+    good_files = glob.glob("../data/good_maps/*.xml")
+
+    for file in good_files:
+        yield assert_compiled_map_matches, file
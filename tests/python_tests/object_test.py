@@ -132,6 +132,13 @@ def test_polygonsymbolizer_init():
 
     eq_(p.fill, mapnik2.Color('blue'))
     eq_(p.fill_opacity, 1)
+    eq_(p.clip, True)
+    eq_(p.simplify_tolerance, 0)
+
+    p.clip = False
+    p.simplify_tolerance = 0.5
+    eq_(p.clip, False)
+    eq_(p.simplify_tolerance, 0.5)
 
 # PolygonSymbolizer pickling
 def test_polygonsymbolizer_pickle():
@@ -220,6 +227,13 @@ def test_linesymbolizer_init():
     eq_(l.stroke.color, mapnik2.Color('blue'))
     eq_(l.stroke.line_cap, mapnik2.line_cap.BUTT_CAP)
     eq_(l.stroke.line_join, mapnik2.line_join.MITER_JOIN)
+    eq_(l.clip, True)
+    eq_(l.simplify_tolerance, 0)
+
+    l.clip = False
+    l.simplify_tolerance = 1.5
+    eq_(l.clip, False)
+    eq_(l.simplify_tolerance, 1.5)
 
 # LineSymbolizer pickling
 def test_linesymbolizer_pickle():
@@ -141,7 +141,42 @@ def test_render_grid2():
     eq_(resolve(utf5,25,46),{"Name": "North East"})
     eq_(resolve(utf5,38,10),{"Name": "South West"})
     eq_(resolve(utf5,38,46),{"Name": "South East"})
-    
+
+def test_render_grid_json():
+    """ test native json encoder against python encoder"""
+    width,height = 256,256
+    m = create_grid_map(width,height)
+    ul_lonlat = mapnik2.Coord(142.30,-38.20)
+    lr_lonlat = mapnik2.Coord(143.40,-38.80)
+    m.zoom_to_box(mapnik2.Box2d(ul_lonlat,lr_lonlat))
+    grid = mapnik2.Grid(m.width,m.height,key='Name')
+    mapnik2.render_layer(m,grid,layer=0,fields=['Name'])
+    eq_(json.loads(grid.encode_json(resolution=4)),grid_correct_new)
+    eq_(json.loads(grid.encode_json(resolution=1)),grid.encode('utf',resolution=1))
+    grid_view = grid.view(0,0,width,height)
+    eq_(json.loads(grid_view.encode_json(resolution=4)),grid_correct_new)
+    utf = json.loads(grid.encode_json(add_features=False,resolution=4))
+    eq_(utf['data'],{})
+    eq_(utf['keys'],grid_correct_new['keys'])
+
+def test_render_grid_compact():
+    """ test compact grid matches default grid"""
+    width,height = 256,256
+    m = create_grid_map(width,height)
+    ul_lonlat = mapnik2.Coord(142.30,-38.20)
+    lr_lonlat = mapnik2.Coord(143.40,-38.80)
+    m.zoom_to_box(mapnik2.Box2d(ul_lonlat,lr_lonlat))
+    grid = mapnik2.Grid(m.width,m.height,key='Name')
+    grid.compact = True
+    eq_(grid.compact,True)
+    mapnik2.render_layer(m,grid,layer=0,fields=['Name'])
+    eq_(grid.encode('utf',resolution=4),grid_correct_new)
+    eq_(json.loads(grid.encode_json(resolution=4)),grid_correct_new)
+    grid_view = grid.view(0,0,width,height)
+    eq_(json.loads(grid_view.encode_json(resolution=4)),grid_correct_new)
+
 if __name__ == "__main__":
     test_render_grid()
-    test_render_grid2()
\ No newline at end of file
+    test_render_grid2()
+    test_render_grid_json()
+    test_render_grid_compact()
\ No newline at end of file
@@ -3,7 +3,7 @@
 
 from nose.tools import *
 
-import os, mapnik2
+import os, ctypes, mapnik2
 from utilities import Todo
 
 def test_simplest_render():
@@ -27,6 +27,20 @@ def test_render_image_to_string():
 
     s = i.tostring('png')
 
+def test_image_buffer():
+    im = mapnik2.Image(4, 3)
+    im.background = mapnik2.Color('rgba(255,0,0,1)')
+    buf = memoryview(im)
+    eq_(buf.shape, (3, 4, 4))
+    eq_(buf.tobytes(), im.tostring())
+    # the buffer shares the image pixels: write through a flat byte view
+    pixels = (ctypes.c_ubyte * len(buf.tobytes())).from_buffer(im)
+    pixels[1] = 0xff
+    eq_(im.tostring()[:4], '\xff\xff\x00\xff')
+    eq_(memoryview(im).tobytes()[:4], '\xff\xff\x00\xff')
+    view = im.view(1, 1, 2, 2)
+    eq_(memoryview(view).tobytes(), view.tostring())
+
 def test_setting_alpha():
     w,h = 256,256
     im1 = mapnik2.Image(w,h)
@@ -210,6 +224,77 @@ def test_render_points():
         num_points_rendered = svg.count('<image ')
         eq_(num_points_present, num_points_rendered, "Not all points were rendered (%d instead of %d) at projection %s" % (num_points_rendered, num_points_present, projdescr)) 
 
+def test_render_stats():
+    m = mapnik2.Map(256,256)
+    mapnik2.load_map(m,'../data/good_maps/polygon_symbolizer.xml')
+    m.zoom_all()
+    im = mapnik2.Image(m.width,m.height)
+    stats = mapnik2.RenderStats()
+    mapnik2.render(m,im,stats)
+    eq_(len(stats.layers),1)
+    layer = stats.layers[0]
+    eq_(layer['name'],'lay')
+    eq_(len(layer['styles']),1)
+    style = layer['styles'][0]
+    eq_(style['name'],'test')
+    assert layer['features_fetched'] > 0
+    eq_(style['features_matched'],layer['features_fetched'])
+    eq_(layer['symbolizers']['polygon']['count'],layer['features_fetched'])
+    assert stats.time >= layer['time']
+    stats.clear()
+    eq_(len(stats.layers),0)
+
+def test_marker_cache_preload():
+    m = mapnik2.Map(256, 256)
+    style = mapnik2.Style()
+    rule = mapnik2.Rule()
+    rule.symbols.append(mapnik2.PointSymbolizer(mapnik2.PathExpression('../data/images/dummy.png')))
+    # depends on the feature, can not be preloaded
+    rule.symbols.append(mapnik2.PointSymbolizer(mapnik2.PathExpression('../data/images/[name].png')))
+    style.rules.append(rule)
+    m.append_style('markers', style)
+
+    mapnik2.MarkerCache.clear()
+    eq_(mapnik2.MarkerCache.preload(m), 1)
+    stats = mapnik2.MarkerCache.stats()
+    eq_(stats['entries'], 1)
+    eq_(stats['misses'], 1)
+    assert stats['bytes'] > 0
+    mapnik2.MarkerCache.preload(m)
+    eq_(mapnik2.MarkerCache.stats()['hits'], 1)
+
+    mapnik2.MarkerCache.set_max_bytes(1)
+    stats = mapnik2.MarkerCache.stats()
+    eq_(stats['entries'], 0)
+    eq_(stats['evictions'], 1)
+    # a marker larger than the whole budget stays until the next one comes in
+    mapnik2.MarkerCache.preload(m)
+    eq_(mapnik2.MarkerCache.stats()['entries'], 1)
+    mapnik2.MarkerCache.preload(m)
+    eq_(mapnik2.MarkerCache.stats()['misses'], 2)
+    mapnik2.MarkerCache.set_max_bytes(0)
+
+def test_render_request():
+    m = mapnik2.Map(256,256)
+    mapnik2.load_map(m,'../data/good_maps/polygon_symbolizer.xml')
+    m.zoom_all()
+    extent = m.envelope()
+    req = mapnik2.Request(128,64,extent)
+    req.buffer_size = m.buffer_size
+    req.zoom_to_box(extent)
+    eq_(req.extent.width()/req.extent.height(),2.0)
+    im = mapnik2.Image(req.width,req.height)
+    mapnik2.render(m,im,req)
+    # the map keeps its own size and extent
+    eq_(m.width,256)
+    eq_(m.envelope(),extent)
+    m2 = mapnik2.Map(128,64)
+    mapnik2.load_map(m2,'../data/good_maps/polygon_symbolizer.xml')
+    m2.zoom_to_box(extent)
+    im2 = mapnik2.Image(m2.width,m2.height)
+    mapnik2.render(m2,im2)
+    eq_(im.tostring(),im2.tostring())
+
 
 if __name__ == "__main__":
     test_render_grid()
\ No newline at end of file
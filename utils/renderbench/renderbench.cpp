@@ -0,0 +1,643 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+//$Id$
+
+/*
+ * Rendering benchmark: renders a reproducible sample of tiles from a
+ * stylesheet (or from a generated memory_datasource) a number of times,
+ * from one or more threads, and reports percentiles of the render,
+ * label and encode times as text, json or csv.
+ */
+
+#include <mapnik/map.hpp>
+#include <mapnik/request.hpp>
+#include <mapnik/load_map.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/render_stats.hpp>
+#include <mapnik/datasource_cache.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/expression_grammar.hpp>
+#include <mapnik/unicode.hpp>
+
+#include <boost/program_options.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#endif
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using mapnik::box2d;
+using mapnik::render_stats;
+
+// minimal linear congruential generator, so a seed gives the same
+// workload everywhere (std::rand differs between platforms)
+class lcg
+{
+public:
+    explicit lcg(unsigned seed)
+        : state_(seed) {}
+
+    unsigned next()
+    {
+        state_ = state_ * 1103515245u + 12345u;
+        return (state_ >> 16) & 0x7fff;
+    }
+
+    // uniform in [0,1)
+    double uniform()
+    {
+        // sequenced explicitly, operand evaluation order is unspecified
+        unsigned hi = next();
+        unsigned lo = next();
+        return ((hi << 15) | lo) / double(1 << 30);
+    }
+
+    unsigned below(unsigned n)
+    {
+        return unsigned(uniform() * n);
+    }
+
+private:
+    unsigned state_;
+};
+
+struct bench_options
+{
+    std::string map_file;
+    std::string synthetic;
+    unsigned features;
+    bool labels;
+    unsigned width;
+    unsigned height;
+    double scale_factor;
+    unsigned min_zoom;
+    unsigned max_zoom;
+    unsigned tiles;
+    unsigned seed;
+    unsigned iterations;
+    unsigned warmup;
+    unsigned threads;
+    std::string format;
+    std::string output;
+    std::string name;
+};
+
+// timings of one render, in milliseconds
+struct sample
+{
+    double render;
+    double labels;
+    double encode;
+    double total;
+    unsigned features;
+    unsigned long bytes;
+};
+
+struct summary
+{
+    summary()
+        : count(0), min(0), mean(0), p50(0), p90(0), p95(0), p99(0), max(0) {}
+    unsigned count;
+    double min, mean, p50, p90, p95, p99, max;
+};
+
+// nearest rank percentile of sorted values
+double percentile(std::vector<double> const& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    unsigned rank = unsigned(std::ceil(p / 100.0 * sorted.size()));
+    if (rank > 0) --rank;
+    return sorted[std::min(rank, unsigned(sorted.size() - 1))];
+}
+
+summary summarize(std::vector<double> values)
+{
+    summary s;
+    if (values.empty()) return s;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (unsigned i = 0; i < values.size(); ++i) sum += values[i];
+    s.count = values.size();
+    s.min = values.front();
+    s.max = values.back();
+    s.mean = sum / values.size();
+    s.p50 = percentile(values, 50);
+    s.p90 = percentile(values, 90);
+    s.p95 = percentile(values, 95);
+    s.p99 = percentile(values, 99);
+    return s;
+}
+
+// time spent placing and drawing labels, from the per symbolizer timings
+double label_time(render_stats const& stats)
+{
+    static char const* label_symbolizers[] = { "text", "shield", "glyph" };
+    double time = 0.0;
+    std::vector<render_stats::layer_stats>::const_iterator itr = stats.layers().begin();
+    for (; itr != stats.layers().end(); ++itr)
+    {
+        for (unsigned i = 0; i < sizeof(label_symbolizers) / sizeof(char const*); ++i)
+        {
+            render_stats::symbolizer_map::const_iterator sym = itr->symbolizers.find(label_symbolizers[i]);
+            if (sym != itr->symbolizers.end()) time += sym->second.time;
+        }
+    }
+    return time;
+}
+
+unsigned features_fetched(render_stats const& stats)
+{
+    unsigned count = 0;
+    std::vector<render_stats::layer_stats>::const_iterator itr = stats.layers().begin();
+    for (; itr != stats.layers().end(); ++itr)
+    {
+        count += itr->features_fetched;
+    }
+    return count;
+}
+
+// random points, lines or polygons over the whole world in lon/lat
+void build_synthetic_map(mapnik::Map & m, bench_options const& opts)
+{
+    using namespace mapnik;
+
+    lcg rand(opts.seed);
+    transcoder tr("utf-8");
+    boost::shared_ptr<memory_datasource> ds = boost::make_shared<memory_datasource>();
+
+    eGeomType type = Point;
+    if (opts.synthetic == "lines") type = LineString;
+    else if (opts.synthetic == "polygons") type = Polygon;
+    else if (opts.synthetic != "points")
+    {
+        throw std::runtime_error("unknown synthetic dataset '" + opts.synthetic + "', expected points, lines or polygons");
+    }
+
+    for (unsigned i = 0; i < opts.features; ++i)
+    {
+        feature_ptr feature(feature_factory::create(i + 1));
+        geometry_type * geom = new geometry_type(type);
+        double x = -180.0 + rand.uniform() * 360.0;
+        double y = -85.0 + rand.uniform() * 170.0;
+        geom->move_to(x, y);
+        if (type != Point)
+        {
+            // a small random walk, closed for polygons
+            double start_x = x;
+            double start_y = y;
+            unsigned vertices = 3 + rand.below(30);
+            double size = 0.05 + rand.uniform() * 2.0;
+            double angle = rand.uniform() * 2 * M_PI;
+            for (unsigned j = 1; j < vertices; ++j)
+            {
+                angle += type == Polygon ? 2 * M_PI / vertices : rand.uniform() - 0.5;
+                x += std::cos(angle) * size;
+                y += std::sin(angle) * size;
+                geom->line_to(x, y);
+            }
+            if (type == Polygon) geom->line_to(start_x, start_y);
+        }
+        feature->add_geometry(geom);
+        std::string name = "feature " + boost::lexical_cast<std::string>(i + 1);
+        (*feature)["name"] = tr.transcode(name.c_str());
+        ds->push(feature);
+    }
+
+    rule r;
+    if (type == Point) r.append(point_symbolizer());
+    else if (type == LineString) r.append(line_symbolizer(stroke(color(60, 60, 160), 1.5)));
+    else
+    {
+        r.append(polygon_symbolizer(color(200, 190, 170)));
+        r.append(line_symbolizer(stroke(color(90, 90, 90), 0.5)));
+    }
+    if (opts.labels)
+    {
+        text_symbolizer text(parse_expression("[name]"), "DejaVu Sans Book", 10, color(0, 0, 0));
+        text.set_halo_fill(color(255, 255, 255));
+        text.set_halo_radius(1);
+        r.append(text);
+    }
+    feature_type_style style;
+    style.add_rule(r);
+    m.insert_style("synthetic", style);
+
+    layer lyr("synthetic");
+    lyr.set_datasource(ds);
+    lyr.add_style("synthetic");
+    m.addLayer(lyr);
+    m.set_maximum_extent(box2d<double>(-180, -85, 180, 85));
+}
+
+// a seeded sample of tiles from a pyramid over extent: zoom z splits
+// the extent in 2^z x 2^z tiles
+std::vector<box2d<double> > sample_tiles(box2d<double> const& extent, bench_options const& opts)
+{
+    lcg rand(opts.seed);
+    std::vector<box2d<double> > tiles;
+    unsigned zooms = opts.max_zoom - opts.min_zoom + 1;
+    for (unsigned i = 0; i < opts.tiles; ++i)
+    {
+        unsigned z = opts.min_zoom + i % zooms;
+        unsigned n = 1u << z;
+        unsigned col = rand.below(n);
+        unsigned row = rand.below(n);
+        double w = extent.width() / n;
+        double h = extent.height() / n;
+        double minx = extent.minx() + col * w;
+        double miny = extent.miny() + row * h;
+        tiles.push_back(box2d<double>(minx, miny, minx + w, miny + h));
+    }
+    return tiles;
+}
+
+typedef boost::shared_ptr<mapnik::Map> map_ptr;
+
+class bench_runner
+{
+public:
+    // worker i renders maps[i % maps.size()]
+    bench_runner(std::vector<map_ptr> const& maps,
+                 std::vector<box2d<double> > const& tiles,
+                 bench_options const& opts)
+        : maps_(maps),
+          tiles_(tiles),
+          opts_(opts),
+          next_(0),
+          jobs_((opts.warmup + opts.iterations) * tiles.size()) {}
+
+    void run()
+    {
+#ifdef MAPNIK_THREADSAFE
+        if (opts_.threads > 1)
+        {
+            boost::thread_group threads;
+            for (unsigned i = 0; i < opts_.threads; ++i)
+            {
+                threads.create_thread(boost::bind(&bench_runner::worker, this, i));
+            }
+            threads.join_all();
+            return;
+        }
+#endif
+        worker(0);
+    }
+
+    std::vector<sample> const& samples() const
+    {
+        return samples_;
+    }
+
+private:
+    // jobs are handed out in order: all warmup passes first
+    bool next_job(unsigned & job)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        if (next_ >= jobs_) return false;
+        job = next_++;
+        return true;
+    }
+
+    void worker(unsigned index)
+    {
+        // every thread renders its map through its own request,
+        // like in a tile server
+        mapnik::Map const& map = *maps_[index % maps_.size()];
+        mapnik::request req(opts_.width, opts_.height, map.get_current_extent());
+        req.set_buffer_size(map.buffer_size());
+        mapnik::image_32 image(opts_.width, opts_.height);
+        render_stats stats;
+        std::vector<sample> samples;
+
+        unsigned job;
+        while (next_job(job))
+        {
+            req.zoom_to_box(tiles_[job % tiles_.size()]);
+            image.data().set(0);
+            stats.clear();
+
+            double start = render_stats::now();
+            mapnik::agg_renderer<mapnik::image_32> ren(map, req, image, opts_.scale_factor);
+            ren.set_stats(&stats);
+            ren.apply();
+            double rendered = render_stats::now();
+            unsigned long bytes = 0;
+            if (opts_.format != "none")
+            {
+                bytes = mapnik::save_to_string(image, opts_.format).size();
+            }
+            double encoded = render_stats::now();
+
+            if (job < opts_.warmup * tiles_.size()) continue;
+            sample s;
+            s.render = rendered - start;
+            s.labels = label_time(stats);
+            s.encode = encoded - rendered;
+            s.total = encoded - start;
+            s.features = features_fetched(stats);
+            s.bytes = bytes;
+            samples.push_back(s);
+        }
+
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        samples_.insert(samples_.end(), samples.begin(), samples.end());
+    }
+
+    std::vector<map_ptr> const& maps_;
+    std::vector<box2d<double> > const& tiles_;
+    bench_options const& opts_;
+    unsigned next_;
+    unsigned jobs_;
+    std::vector<sample> samples_;
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex mutex_;
+#endif
+};
+
+struct metric
+{
+    std::string name;
+    summary s;
+};
+
+void print_text(std::ostream & out, bench_options const& opts, std::vector<metric> const& metrics,
+                double wall_time, unsigned renders, double features, double bytes)
+{
+    out << "map: " << (opts.map_file.empty() ? "synthetic " + opts.synthetic : opts.map_file) << "\n"
+        << "renders: " << renders << " (" << opts.tiles << " tiles x " << opts.iterations
+        << " iterations, " << opts.threads << " threads)\n"
+        << "wall time: " << wall_time << " ms, " << renders / (wall_time / 1000.0) << " renders/s\n"
+        << "features per render: " << features << ", bytes per image: " << bytes << "\n\n";
+    out << std::setw(8) << "ms" << std::setw(10) << "min" << std::setw(10) << "mean"
+        << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p95"
+        << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    for (unsigned i = 0; i < metrics.size(); ++i)
+    {
+        summary const& s = metrics[i].s;
+        out << std::setw(8) << metrics[i].name << std::fixed << std::setprecision(3)
+            << std::setw(10) << s.min << std::setw(10) << s.mean << std::setw(10) << s.p50
+            << std::setw(10) << s.p90 << std::setw(10) << s.p95 << std::setw(10) << s.p99
+            << std::setw(10) << s.max << "\n";
+    }
+}
+
+std::string json_string(std::string const& str)
+{
+    std::string result("\"");
+    for (unsigned i = 0; i < str.size(); ++i)
+    {
+        if (str[i] == '"' || str[i] == '\\') result += '\\';
+        result += str[i];
+    }
+    return result + "\"";
+}
+
+void print_json(std::ostream & out, bench_options const& opts, std::vector<metric> const& metrics,
+                double wall_time, unsigned renders, double features, double bytes)
+{
+    out << "{\n"
+        << "  \"name\": " << json_string(opts.name) << ",\n"
+        << "  \"map\": " << json_string(opts.map_file.empty() ? "synthetic:" + opts.synthetic : opts.map_file) << ",\n"
+        << "  \"width\": " << opts.width << ",\n"
+        << "  \"height\": " << opts.height << ",\n"
+        << "  \"scale_factor\": " << opts.scale_factor << ",\n"
+        << "  \"format\": " << json_string(opts.format) << ",\n"
+        << "  \"tiles\": " << opts.tiles << ",\n"
+        << "  \"iterations\": " << opts.iterations << ",\n"
+        << "  \"threads\": " << opts.threads << ",\n"
+        << "  \"seed\": " << opts.seed << ",\n"
+        << "  \"renders\": " << renders << ",\n"
+        << "  \"wall_time\": " << wall_time << ",\n"
+        << "  \"renders_per_second\": " << renders / (wall_time / 1000.0) << ",\n"
+        << "  \"features_per_render\": " << features << ",\n"
+        << "  \"bytes_per_image\": " << bytes << ",\n"
+        << "  \"metrics\": {\n";
+    for (unsigned i = 0; i < metrics.size(); ++i)
+    {
+        summary const& s = metrics[i].s;
+        out << "    " << json_string(metrics[i].name) << ": {"
+            << "\"count\": " << s.count << ", \"min\": " << s.min << ", \"mean\": " << s.mean
+            << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90 << ", \"p95\": " << s.p95
+            << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}"
+            << (i + 1 < metrics.size() ? ",\n" : "\n");
+    }
+    out << "  }\n}\n";
+}
+
+void print_csv(std::ostream & out, bench_options const& opts, std::vector<metric> const& metrics)
+{
+    out << "name,map,threads,metric,count,min,mean,p50,p90,p95,p99,max\n";
+    std::string map_name = opts.map_file.empty() ? "synthetic:" + opts.synthetic : opts.map_file;
+    for (unsigned i = 0; i < metrics.size(); ++i)
+    {
+        summary const& s = metrics[i].s;
+        out << opts.name << "," << map_name << "," << opts.threads << "," << metrics[i].name << ","
+            << s.count << "," << s.min << "," << s.mean << "," << s.p50 << "," << s.p90 << ","
+            << s.p95 << "," << s.p99 << "," << s.max << "\n";
+    }
+}
+
+int main (int argc,char** argv)
+{
+    namespace po = boost::program_options;
+
+    using std::clog;
+    using std::endl;
+
+    bench_options opts;
+    std::vector<std::string> plugin_dirs;
+    std::vector<std::string> font_dirs;
+
+    try
+    {
+        po::options_description desc("renderbench utility");
+        desc.add_options()
+            ("help,h", "produce usage message")
+            ("version,V","print version string")
+            ("map,m", po::value<std::string>(&opts.map_file), "stylesheet to render")
+            ("synthetic", po::value<std::string>(&opts.synthetic),
+             "render generated data instead of a stylesheet: points, lines or polygons")
+            ("features", po::value<unsigned>(&opts.features)->default_value(10000), "features in the synthetic dataset")
+            ("labels", "label the synthetic features (needs the DejaVu fonts)")
+            ("plugins,p", po::value<std::vector<std::string> >(&plugin_dirs), "datasource plugins directory")
+            ("fonts,f", po::value<std::vector<std::string> >(&font_dirs), "fonts directory")
+            ("width", po::value<unsigned>(&opts.width)->default_value(256), "image width")
+            ("height", po::value<unsigned>(&opts.height)->default_value(256), "image height")
+            ("scale-factor", po::value<double>(&opts.scale_factor)->default_value(1.0), "scale factor")
+            ("min-zoom", po::value<unsigned>(&opts.min_zoom)->default_value(0), "first zoom level of the tile sample")
+            ("max-zoom", po::value<unsigned>(&opts.max_zoom)->default_value(4), "last zoom level of the tile sample")
+            ("tiles,t", po::value<unsigned>(&opts.tiles)->default_value(32), "number of tiles sampled")
+            ("seed", po::value<unsigned>(&opts.seed)->default_value(1), "seed of the tile sample and synthetic data")
+            ("iterations,i", po::value<unsigned>(&opts.iterations)->default_value(10), "measured passes over the tiles")
+            ("warmup", po::value<unsigned>(&opts.warmup)->default_value(1), "unmeasured passes over the tiles")
+            // threads share the datasources of a stylesheet, those must return
+            // per-query features (memory_datasource does not, so --synthetic
+            // builds one map per thread)
+            ("threads,j", po::value<unsigned>(&opts.threads)->default_value(1),
+             "rendering threads (datasources must return per-query features)")
+            ("format", po::value<std::string>(&opts.format)->default_value("png"), "image format to encode, or none")
+            ("output,o", po::value<std::string>(&opts.output)->default_value("text"), "report format: text, json or csv")
+            ("name,n", po::value<std::string>(&opts.name)->default_value(""), "name of the run, copied into the report")
+            ;
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+
+        if (vm.count("version"))
+        {
+            clog << "version 0.1.0" << endl;
+            return 1;
+        }
+
+        if (vm.count("help"))
+        {
+            clog << desc << endl;
+            return 1;
+        }
+
+        opts.labels = vm.count("labels") > 0;
+        if (opts.map_file.empty() == opts.synthetic.empty())
+        {
+            clog << "please provide either a stylesheet (--map) or a synthetic dataset (--synthetic)" << endl;
+            return -1;
+        }
+        if (opts.output != "text" && opts.output != "json" && opts.output != "csv")
+        {
+            clog << "unknown report format '" << opts.output << "'" << endl;
+            return -1;
+        }
+        if (opts.max_zoom < opts.min_zoom || opts.max_zoom > 30)
+        {
+            clog << "invalid zoom range" << endl;
+            return -1;
+        }
+        if (opts.tiles == 0 || opts.iterations == 0 || opts.threads == 0)
+        {
+            clog << "tiles, iterations and threads must be positive" << endl;
+            return -1;
+        }
+#ifndef MAPNIK_THREADSAFE
+        if (opts.threads > 1)
+        {
+            clog << "mapnik is built without thread support, using a single thread" << endl;
+            opts.threads = 1;
+        }
+#endif
+
+        for (unsigned i = 0; i < plugin_dirs.size(); ++i)
+        {
+            mapnik::datasource_cache::instance()->register_datasources(plugin_dirs[i]);
+        }
+        for (unsigned i = 0; i < font_dirs.size(); ++i)
+        {
+            mapnik::freetype_engine::register_fonts(font_dirs[i], true);
+        }
+
+        // memory_datasource hands every query the same features, whose
+        // geometry vertex cursors must not be shared between threads:
+        // each thread gets its own, identically seeded, synthetic map
+        std::vector<map_ptr> maps;
+        unsigned num_maps = opts.map_file.empty() ? opts.threads : 1;
+        for (unsigned i = 0; i < num_maps; ++i)
+        {
+            map_ptr map = boost::make_shared<mapnik::Map>(opts.width, opts.height);
+            if (!opts.map_file.empty()) mapnik::load_map(*map, opts.map_file);
+            else build_synthetic_map(*map, opts);
+            maps.push_back(map);
+        }
+        mapnik::Map & m = *maps.front();
+
+        box2d<double> extent;
+        if (m.maximum_extent()) extent = *m.maximum_extent();
+        else
+        {
+            m.zoom_all();
+            extent = m.get_current_extent();
+        }
+
+        std::vector<box2d<double> > tiles = sample_tiles(extent, opts);
+        bench_runner runner(maps, tiles, opts);
+        double start = render_stats::now();
+        runner.run();
+        double wall_time = render_stats::now() - start;
+
+        std::vector<sample> const& samples = runner.samples();
+        std::vector<double> render, labels, encode, total;
+        double features = 0.0;
+        double bytes = 0.0;
+        for (unsigned i = 0; i < samples.size(); ++i)
+        {
+            render.push_back(samples[i].render);
+            labels.push_back(samples[i].labels);
+            encode.push_back(samples[i].encode);
+            total.push_back(samples[i].total);
+            features += samples[i].features;
+            bytes += samples[i].bytes;
+        }
+        if (!samples.empty())
+        {
+            features /= samples.size();
+            bytes /= samples.size();
+        }
+
+        std::vector<metric> metrics;
+        metric met;
+        met.name = "render"; met.s = summarize(render); metrics.push_back(met);
+        met.name = "labels"; met.s = summarize(labels); metrics.push_back(met);
+        met.name = "encode"; met.s = summarize(encode); metrics.push_back(met);
+        met.name = "total"; met.s = summarize(total); metrics.push_back(met);
+
+        if (opts.output == "json") print_json(std::cout, opts, metrics, wall_time, samples.size(), features, bytes);
+        else if (opts.output == "csv") print_csv(std::cout, opts, metrics);
+        else print_text(std::cout, opts, metrics, wall_time, samples.size(), features, bytes);
+    }
+    catch (std::exception const& ex)
+    {
+        clog << "Error: " << ex.what() << endl;
+        return -1;
+    }
+    catch (...)
+    {
+        clog << "Exception of unknown type!" << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*****************************************************************************
+ * 
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2006 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+//$Id$
+
+#ifndef PACKED_RTREE_HPP
+#define PACKED_RTREE_HPP
+// stl
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+// boost
+#include <boost/cstdint.hpp>
+// mapnik
+#include <mapnik/box2d.hpp>
+#include "shp_index.hpp"
+
+using mapnik::box2d;
+using mapnik::coord2d;
+
+// position of (x,y) along a Hilbert curve filling a 2^16 x 2^16 grid
+inline boost::uint32_t hilbert_index(boost::uint32_t x, boost::uint32_t y)
+{
+    const boost::uint32_t n = 1 << 16;
+    boost::uint32_t d = 0;
+    for (boost::uint32_t s = n / 2; s > 0; s /= 2)
+    {
+        boost::uint32_t rx = (x & s) > 0;
+        boost::uint32_t ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Bulk loaded R-tree written in the version 2 index format (see
+// shp_rtree in shp_index.hpp). Items are sorted along a Hilbert curve
+// by the centre of their extent and packed node_size to a node, level
+// after level up to the root.
+class packed_rtree
+{
+public:
+    struct item
+    {
+        box2d<double> ext;
+        boost::int32_t value;
+        boost::uint32_t hilbert;
+    };
+
+    packed_rtree(const box2d<double>& extent,int node_size)
+        : extent_(extent),
+          node_size_(std::max(int(shp_rtree::min_node_size),std::min(node_size,int(shp_rtree::max_node_size)))) {}
+
+    void insert(boost::int32_t value,const box2d<double>& item_ext)
+    {
+        item i;
+        i.ext = item_ext;
+        i.value = value;
+        i.hilbert = 0;
+        items_.push_back(i);
+    }
+
+    int node_size() const
+    {
+        return node_size_;
+    }
+
+    // items in insertion order, or in index order once sorted; values
+    // may be changed as long as the order is kept
+    std::vector<item>& items()
+    {
+        return items_;
+    }
+
+    void sort()
+    {
+        const double width = extent_.width() > 0 ? extent_.width() : 1.0;
+        const double height = extent_.height() > 0 ? extent_.height() : 1.0;
+        const double max = (1 << 16) - 1;
+        for (std::vector<item>::iterator itr = items_.begin(); itr != items_.end(); ++itr)
+        {
+            coord2d c = itr->ext.center();
+            double x = std::max(0.0, std::min(max, max * (c.x - extent_.minx()) / width));
+            double y = std::max(0.0, std::min(max, max * (c.y - extent_.miny()) / height));
+            itr->hilbert = hilbert_index(boost::uint32_t(x), boost::uint32_t(y));
+        }
+        std::stable_sort(items_.begin(), items_.end(), hilbert_order);
+    }
+
+    int count() const
+    {
+        int count = 0;
+        std::vector<int> levels = level_sizes();
+        for (unsigned i = 0; i < levels.size(); ++i)
+        {
+            count += levels[i];
+        }
+        return count;
+    }
+
+    void write(std::ostream& out) const
+    {
+        const std::vector<int> levels = level_sizes();
+        const int num_nodes = count();
+        const std::size_t node_bytes = node_size_ * shp_rtree::entry_size;
+        std::vector<char> node(node_bytes);
+
+        // header, padded to a whole node
+        std::memset(&node[0], 0, node_bytes);
+        std::memcpy(&node[0], "mapnik", 6);
+        node[6] = shp_rtree::version;
+        boost::int32_t header[4] = { node_size_, boost::int32_t(items_.size()), num_nodes, levels.empty() ? 0 : levels[0] };
+        std::memcpy(&node[8], header, sizeof(header));
+        out.write(&node[0], node_bytes);
+
+        // level k summarizes the nodes of level k-1, level 0 holds the items
+        std::vector<std::vector<item> > entries(levels.size());
+        if (!levels.empty()) entries[0] = items_;
+        // node number of the first node of every level, the root is node 0
+        std::vector<int> first(levels.size(), 0);
+        for (int k = int(levels.size()) - 2; k >= 0; --k)
+        {
+            first[k] = first[k + 1] + levels[k + 1];
+        }
+        for (unsigned k = 1; k < levels.size(); ++k)
+        {
+            std::vector<item> const& children = entries[k - 1];
+            for (int j = 0; j < levels[k - 1]; ++j)
+            {
+                item parent;
+                parent.ext = children[j * node_size_].ext;
+                parent.value = first[k - 1] + j;
+                parent.hilbert = 0;
+                for (unsigned i = j * node_size_; i < children.size() && i < unsigned((j + 1) * node_size_); ++i)
+                {
+                    parent.ext.expand_to_include(children[i].ext);
+                }
+                entries[k].push_back(parent);
+            }
+        }
+
+        for (int k = int(levels.size()) - 1; k >= 0; --k)
+        {
+            for (int j = 0; j < levels[k]; ++j)
+            {
+                std::memset(&node[0], 0, node_bytes);
+                for (int i = 0; i < node_size_; ++i)
+                {
+                    char* entry = &node[i * shp_rtree::entry_size];
+                    unsigned pos = j * node_size_ + i;
+                    boost::int32_t value = -1;
+                    if (pos < entries[k].size())
+                    {
+                        std::memcpy(entry, &entries[k][pos].ext, sizeof(box2d<double>));
+                        value = entries[k][pos].value;
+                    }
+                    std::memcpy(entry + 32, &value, 4);
+                }
+                out.write(&node[0], node_bytes);
+            }
+        }
+    }
+
+private:
+
+    static bool hilbert_order(const item& a, const item& b)
+    {
+        return a.hilbert < b.hilbert;
+    }
+
+    // number of nodes per level, leaves first
+    std::vector<int> level_sizes() const
+    {
+        std::vector<int> levels;
+        int n = items_.size();
+        while (n > 0)
+        {
+            n = (n + node_size_ - 1) / node_size_;
+            levels.push_back(n);
+            if (n == 1) break;
+        }
+        return levels;
+    }
+
+    box2d<double> extent_;
+    const int node_size_;
+    std::vector<item> items_;
+};
+
+#endif //PACKED_RTREE_HPP
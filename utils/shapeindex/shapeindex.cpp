@@ -23,14 +23,17 @@
 
 
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <string>
+#include <map>
 
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/program_options.hpp>
 #include "quadtree.hpp"
+#include "packed_rtree.hpp"
 #include "shapefile.hpp"
 #include "shape_io.hpp"
 
@@ -39,6 +42,90 @@ const int DEFAULT_DEPTH = 8;
 const double MINRATIO=0.5;
 const double MAXRATIO=0.8;
 const double DEFAULT_RATIO=0.55;
+const int DEFAULT_NODE_SIZE=16;
+
+struct record_info
+{
+    int number;
+    int content_length;
+};
+
+// Rewrites the records of the .shp in the order of the tree items and
+// points the items at the new offsets. Records keep their numbers, so
+// the .dbf still matches, and the .shx (if any) is rewritten to the new
+// offsets in record number order.
+bool reorder_shapefile(std::string const& shapename,
+                       packed_rtree& tree,
+                       std::map<int,record_info> const& records)
+{
+    using std::clog;
+    using std::endl;
+
+    std::string shp_name(shapename + ".shp");
+    std::string shx_name(shapename + ".shx");
+    std::string tmp_name(shapename + ".shp.reorder");
+
+    std::ifstream in(shp_name.c_str(), std::ios::in | std::ios::binary);
+    std::ofstream out(tmp_name.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!in || !out)
+    {
+        clog << "error : cannot reorder " << shp_name << endl;
+        return false;
+    }
+
+    std::vector<char> buffer(100);
+    in.read(&buffer[0], 100);
+    out.write(&buffer[0], 100);
+
+    // new offset and content length of every record, by record number
+    std::map<int,std::pair<int,int> > locations;
+    std::vector<packed_rtree::item>& items = tree.items();
+    for (std::vector<packed_rtree::item>::iterator itr = items.begin(); itr != items.end(); ++itr)
+    {
+        std::map<int,record_info>::const_iterator rec = records.find(itr->value);
+        if (rec == records.end()) continue;
+        std::size_t size = 8 + 2 * rec->second.content_length;
+        if (buffer.size() < size) buffer.resize(size);
+        in.seekg(itr->value, std::ios::beg);
+        in.read(&buffer[0], size);
+        int offset = out.tellp();
+        out.write(&buffer[0], size);
+        locations[rec->second.number] = std::make_pair(offset, rec->second.content_length);
+        itr->value = offset;
+    }
+    in.close();
+    out.close();
+    if (!in || !out)
+    {
+        clog << "error : failed writing " << tmp_name << endl;
+        boost::filesystem::remove(tmp_name);
+        return false;
+    }
+
+    boost::filesystem::remove(shp_name);
+    boost::filesystem::rename(tmp_name, shp_name);
+
+    if (boost::filesystem::exists(shx_name))
+    {
+        std::fstream shx(shx_name.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        shx.seekp(100, std::ios::beg);
+        for (std::map<int,std::pair<int,int> >::const_iterator itr = locations.begin(); itr != locations.end(); ++itr)
+        {
+            // shx records are big endian offset and length in 16 bit words
+            int values[2] = { itr->second.first / 2, itr->second.second };
+            for (int i = 0; i < 2; ++i)
+            {
+                char b[4];
+                b[0] = (values[i] >> 24) & 0xff;
+                b[1] = (values[i] >> 16) & 0xff;
+                b[2] = (values[i] >> 8) & 0xff;
+                b[3] = values[i] & 0xff;
+                shx.write(b, 4);
+            }
+        }
+    }
+    return true;
+}
 
 int main (int argc,char** argv) 
 {
@@ -50,8 +137,11 @@ int main (int argc,char** argv)
     using std::endl;
     
     bool verbose=false;
+    bool rtree=false;
+    bool reorder=false;
     unsigned int depth=DEFAULT_DEPTH;
     double ratio=DEFAULT_RATIO;
+    int node_size=DEFAULT_NODE_SIZE;
     vector<string> shape_files;
     
     try
@@ -63,6 +153,9 @@ int main (int argc,char** argv)
             ("verbose,v","verbose output")
             ("depth,d", po::value<unsigned int>(), "max tree depth\n(default 8)")   
             ("ratio,r",po::value<double>(),"split ratio (default 0.55)")
+            ("rtree","write a packed Hilbert R-tree index (format 2) instead of a quadtree")
+            ("node-size,n",po::value<int>(),"entries per R-tree node\n(default 16)")
+            ("reorder","also rewrite the .shp records in index order for sequential reads, implies --rtree. Record numbers are kept, tools pairing .shp and .dbf records by position must use the rewritten .shx")
             ("shape_files",po::value<vector<string> >(),"shape files to index: file1 file2 ...fileN")
             ;
         
@@ -95,6 +188,19 @@ int main (int argc,char** argv)
         {
             ratio = vm["ratio"].as<double>();
         }
+        if (vm.count("rtree"))
+        {
+            rtree = true;
+        }
+        if (vm.count("reorder"))
+        {
+            rtree = true;
+            reorder = true;
+        }
+        if (vm.count("node-size"))
+        {
+            node_size = vm["node-size"].as<int>();
+        }
         
         if (vm.count("shape_files"))
         {
@@ -107,8 +213,15 @@ int main (int argc,char** argv)
         return -1;
     }
     
-    clog << "max tree depth:" << depth << endl;
-    clog << "split ratio:" << ratio << endl;
+    if (rtree)
+    {
+        clog << "node size:" << node_size << endl;
+    }
+    else
+    {
+        clog << "max tree depth:" << depth << endl;
+        clog << "split ratio:" << ratio << endl;
+    }
   
     vector<string>::const_iterator itr = shape_files.begin();
     if (itr == shape_files.end())
@@ -155,6 +268,8 @@ int main (int argc,char** argv)
         int pos=50;
         shp.seek(pos*2);  
         quadtree<int> tree(extent,depth,ratio);
+        packed_rtree packed(extent,node_size);
+        std::map<int,record_info> records;
         int count=0;
         while (true) {
             
@@ -205,7 +320,19 @@ int main (int argc,char** argv)
                 shp.skip(2*content_length-4*8-4);
             }
             
-            tree.insert(offset,item_ext);
+            if (rtree)
+            {
+                packed.insert(offset,item_ext);
+                if (reorder)
+                {
+                    record_info info = { record_number, content_length };
+                    records[offset] = info;
+                }
+            }
+            else
+            {
+                tree.insert(offset,item_ext);
+            }
             if (verbose) {
                 clog << "record number " << record_number << " box=" << item_ext << endl;
             }
@@ -219,6 +346,20 @@ int main (int argc,char** argv)
         } 
         
         clog << " number shapes=" << count << endl;  
+
+        if (rtree)
+        {
+            packed.sort();
+        }
+
+        if (reorder)
+        {
+            shp.file().close();
+            if (reorder_shapefile(shapename,packed,records))
+            {
+                clog << " reordered " << shapename_full << endl;
+            }
+        }
     
         std::fstream file((shapename+".index").c_str(),
                           std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
@@ -226,10 +367,18 @@ int main (int argc,char** argv)
             clog << "cannot open index file for writing file \"" 
                  << (shapename+".index") << "\"" << endl;
         } else {
-            tree.trim();
-            std::clog<<" number nodes="<<tree.count()<<std::endl;
             file.exceptions(std::ios::failbit | std::ios::badbit);
-            tree.write(file);
+            if (rtree)
+            {
+                std::clog<<" number nodes="<<packed.count()<<std::endl;
+                packed.write(file);
+            }
+            else
+            {
+                tree.trim();
+                std::clog<<" number nodes="<<tree.count()<<std::endl;
+                tree.write(file);
+            }
             file.flush();
             file.close();
         }